@@ -0,0 +1,128 @@
+/*
+ * Timing loop and JSON report shared by the benchmarks
+ */
+#ifndef BENCH_REPORT_H
+#define BENCH_REPORT_H
+#include <stdio.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <thread>
+#include <core/base/timer.h>
+#include <core/common/LatencyTracer.h>
+
+/// one measured operation
+struct BenchResult {
+    std::string name;
+    uint64_t iterations;
+    uint64_t total_ns;          ///< sum of the per operation times
+    uint64_t items;             ///< points, bytes or revolutions processed
+    LatencyPercentiles latency; ///< per operation times
+    std::vector<std::pair<std::string, double> > counters;///< extra values of the result
+};
+
+/**
+ * @brief Runs the benchmarks and writes their results as JSON \n
+ * Every operation is timed on its own, so the results include one clock
+ * read per operation(about 20 ns) and come with percentiles.
+ */
+class BenchReport {
+public:
+    BenchReport() {
+    }
+
+    /**
+     * @brief time an operation
+     * @param name        result name, "operation/input"
+     * @param iterations  timed calls, a tenth more warm the caches first
+     * @param op          called as op(i), returns the items it processed
+     */
+    template <typename Op>
+    BenchResult &run(const std::string &name, uint64_t iterations, Op op) {
+        lidar::core::common::LatencyHistogram histogram;
+        BenchResult r;
+        r.name = name;
+        r.iterations = iterations;
+        r.total_ns = 0;
+        r.items = 0;
+        for (uint64_t i = 0; i < iterations / 10; i++) {
+            op(i);
+        }
+        for (uint64_t i = 0; i < iterations; i++) {
+            uint64_t start = getns();
+            size_t items = op(i);
+            uint64_t ns = getns() - start;
+            histogram.record(ns);
+            r.total_ns += ns;
+            r.items += items;
+        }
+        histogram.percentiles(r.latency);
+        return add(r);
+    }
+
+    /**
+     * @brief add a result measured by the benchmark itself
+     */
+    BenchResult &add(const BenchResult &r) {
+        m_results.push_back(r);
+        fprintf(stderr, "%-32s %10.1f ns/op %10.1f p99\n", r.name.c_str(),
+                r.iterations ? (double)r.total_ns / r.iterations : 0.0, (double)r.latency.p99);
+        return m_results.back();
+    }
+
+    /**
+     * @brief exact percentiles of a sample
+     * @param values      sample, sorted in place
+     * @param[out] p      percentiles
+     */
+    static void percentiles(std::vector<uint64_t> &values, LatencyPercentiles &p) {
+        std::sort(values.begin(), values.end());
+        size_t n = values.size();
+        p.count = n;
+        p.p50 = n ? values[(n - 1) * 500 / 1000] : 0;
+        p.p90 = n ? values[(n - 1) * 900 / 1000] : 0;
+        p.p99 = n ? values[(n - 1) * 990 / 1000] : 0;
+        p.p999 = n ? values[(n - 1) * 999 / 1000] : 0;
+        p.max = n ? values[n - 1] : 0;
+    }
+
+    /**
+     * @brief write every result
+     * @param fp     stream
+     * @param bench  executable name
+     */
+    void write(FILE *fp, const char *bench) const {
+        fprintf(fp, "{\n  \"context\": {\"benchmark\": \"%s\", \"cpus\": %u, \"tsc_clock\": %s, \"optimized\": %s},\n",
+                bench, std::thread::hardware_concurrency(),
+                impl::isTscClock() ? "true" : "false",
+#if defined(__OPTIMIZE__) || defined(NDEBUG)
+                "true"
+#else
+                "false"
+#endif
+               );
+        fprintf(fp, "  \"benchmarks\": [");
+        for (size_t i = 0; i < m_results.size(); i++) {
+            const BenchResult &r = m_results[i];
+            double seconds = r.total_ns * 1e-9;
+            fprintf(fp, "%s\n    {\"name\": \"%s\", \"iterations\": %llu, \"ns_per_op\": %.1f, "
+                    "\"items_per_second\": %.1f, \"p50_ns\": %llu, \"p90_ns\": %llu, \"p99_ns\": %llu, "
+                    "\"p999_ns\": %llu, \"max_ns\": %llu", i ? "," : "", r.name.c_str(),
+                    (unsigned long long)r.iterations, r.iterations ? (double)r.total_ns / r.iterations : 0.0,
+                    seconds > 0 ? r.items / seconds : 0.0,
+                    (unsigned long long)r.latency.p50, (unsigned long long)r.latency.p90,
+                    (unsigned long long)r.latency.p99, (unsigned long long)r.latency.p999,
+                    (unsigned long long)r.latency.max);
+            for (size_t j = 0; j < r.counters.size(); j++) {
+                fprintf(fp, ", \"%s\": %.3f", r.counters[j].first.c_str(), r.counters[j].second);
+            }
+            fprintf(fp, "}");
+        }
+        fprintf(fp, "\n  ]\n}\n");
+    }
+
+private:
+    std::vector<BenchResult> m_results;
+};
+
+#endif // BENCH_REPORT_H
@@ -0,0 +1,312 @@
+/*
+ * Cost of the scan pipeline: packet decoding, revolution assembly, LaserScan
+ * conversion in doProcessSimple, the NoiseFilter strategies and the parsing
+ * of config answers, results as JSON
+ * usage: pipeline_bench [-o result.json] [capture file]
+ * The JSON goes to pipeline_bench.json unless -o names another file or "-"
+ * for stdout, the filters print to stdout themselves.
+ * The synthetic input is a 10 Hz lidar at 20k points/s in a room, a capture
+ * recorded with LidarPropRecordPath runs the same benchmarks on real frames.
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <core/common/ScanAssembler.h>
+#include <core/common/lidar_help.h>
+#include <core/tools/cJSON.h>
+#include <src/CLidar.h>
+#include <src/FrameDecoder.h>
+#include <src/filters/NoiseFilter.h>
+#include <src/record/CaptureReader.h>
+#include <src/record/CaptureWriter.h>
+#include "bench_report.h"
+
+using namespace lidar;
+
+enum {
+    SYNTHETIC_RATE = 20000,            ///< points per second
+    SYNTHETIC_FREQUENCY = 10,          ///< revolutions per second
+    SYNTHETIC_REVOLUTIONS = 16,
+    DECODE_ITERATIONS = 200000,
+    CONVERT_REVOLUTIONS = 300,
+    FILTER_ITERATIONS = 300,
+    JSON_ITERATIONS = 200000,
+};
+
+/// frames of a lidar turning in a room with a wall 2-4m away, as the simulator sends them
+static void syntheticFrames(std::vector<DataFrame> &frames) {
+    double step = 36000.0 * SYNTHETIC_FREQUENCY / SYNTHETIC_RATE;
+    double angle = 0;
+    uint64_t stamp_ms = 1000000;
+    uint32_t sequence = 0;
+
+    //whole revolutions and a multiple of 16 frames keep the sequence and the zero crossing seamless
+    size_t count = SYNTHETIC_REVOLUTIONS * SYNTHETIC_RATE / SYNTHETIC_FREQUENCY / (DATABLOCK_COUNT * DATA_COUNT);
+    count = (count + 15) / 16 * 16;
+    frames.resize(count);
+    for (size_t n = 0; n < count; n++) {
+        DataFrame &frame = frames[n];
+        memset(&frame, 0, sizeof(frame));
+        for (int i = 0; i < DATABLOCK_COUNT; i++) {
+            DataBlock &block = frame.dataBlock[i];
+            uint16_t last = static_cast<uint16_t>(angle + 0.5) % 36000;
+            block.frameHead = BigLittleSwap16(0xFFEE);
+            block.startAngle = BigLittleSwap16(last);
+            for (int j = 0; j < DATA_COUNT; j++) {
+                uint16_t a = static_cast<uint16_t>(angle + 0.5) % 36000;
+                if (a < last || a - last > 0x3f) {
+                    break;
+                }
+                uint32_t distance = static_cast<uint32_t>(3000 + 1000 * sin(a * M_PI / 6000.0));
+                block.data[j] = BigLittleSwap32(((uint32_t)(a - last) << 24) | (100 << 16) | distance);
+                last = a;
+                angle += step;
+                if (angle >= 36000) {
+                    angle -= 36000;
+                }
+            }
+        }
+        stamp_ms += 1000 * DATABLOCK_COUNT * DATA_COUNT / SYNTHETIC_RATE;
+        frame.timeStamp_s = BigLittleSwap32(static_cast<uint32_t>(stamp_ms / 1000));
+        frame.timeStamp_ms = BigLittleSwap32(static_cast<uint32_t>(stamp_ms % 1000));
+        frame.factory = BigLittleSwap32(((sequence & 0x0F) << 24) | 0x00123456);
+        sequence++;
+    }
+}
+
+/// DataFrames of the first source of a capture
+static bool recordedFrames(const char *path, std::vector<DataFrame> &frames) {
+    CaptureReader reader;
+    if (!reader.open(path)) {
+        return false;
+    }
+    capture_frame frame;
+    uint32_t source = 0;
+    while (reader.next(frame)) {
+        if (source == 0) {
+            source = frame.src_addr;
+        }
+        if (frame.src_addr == source && frame.length >= sizeof(DataFrame)) {
+            frames.resize(frames.size() + 1);
+            memcpy(&frames.back(), frame.payload, sizeof(DataFrame));
+        }
+    }
+    return !frames.empty();
+}
+
+/// capture of the synthetic frames for the replay driver
+static bool writeCapture(const std::string &path, const std::vector<DataFrame> &frames) {
+    CaptureWriter writer;
+    if (!writer.open(path.c_str())) {
+        return false;
+    }
+    uint64_t recv_ns = getTime();
+    for (size_t i = 0; i < frames.size(); i++) {
+        //one source, the replay follows the first one it sees
+        recv_ns += 1000000000ULL * DATABLOCK_COUNT * DATA_COUNT / SYNTHETIC_RATE;
+        writer.write(recv_ns, 1, 8000, &frames[i], sizeof(DataFrame));
+    }
+    writer.close();
+    return true;
+}
+
+/// FrameDecoder::decode, the waitScanData path without the socket
+static void benchDecode(BenchReport &report, const std::string &input, const std::vector<DataFrame> &frames,
+                        std::vector<std::vector<node_info> > &decoded) {
+    FrameDecoder decoder;
+    node_info nodes[DATABLOCK_COUNT * DATA_COUNT];
+    size_t n = frames.size();
+    report.run("decode/" + input, DECODE_ITERATIONS, [&](uint64_t i) {
+        size_t count = 0;
+        decoder.decode(reinterpret_cast<const uint8_t *>(&frames[i % n]), sizeof(DataFrame), nodes, count);
+        return count;
+    });
+
+    //points of every frame for the assembly
+    decoder.reset();
+    decoded.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        size_t count = 0;
+        decoder.decode(reinterpret_cast<const uint8_t *>(&frames[i]), sizeof(DataFrame), nodes, count);
+        decoded[i].assign(nodes, nodes + count);
+    }
+}
+
+/// ScanAssembler::push and the copy of publishScan, the cacheScanData path
+static void benchAssemble(BenchReport &report, const std::string &input,
+                          const std::vector<std::vector<node_info> > &decoded) {
+    ScanAssembler assembler(DriverInterface::MAX_SCAN_NODES);
+    std::vector<node_info> published(DriverInterface::MAX_SCAN_NODES);
+    uint64_t revolutions = 0;
+    size_t n = decoded.size();
+    BenchResult &r = report.run("assemble/" + input, DECODE_ITERATIONS, [&](uint64_t i) {
+        const std::vector<node_info> &nodes = decoded[i % n];
+        if (nodes.empty()) {
+            assembler.markSync();
+            return (size_t)0;
+        }
+        assembler.push(&nodes[0], nodes.size(), [&](const node_info *scan, size_t count, const ScanStats &) {
+            memcpy(&published[0], scan, count * sizeof(node_info));
+            revolutions++;
+        });
+        return nodes.size();
+    });
+    r.counters.push_back(std::make_pair(std::string("revolutions"), (double)revolutions));
+}
+
+/**
+ * @brief CLidar::doProcessSimple on a replayed capture \n
+ * The conversion is the time from the grab to the filled LaserScan, taken
+ * from the scan timelines, so the wait for the replay thread is left out.
+ */
+static bool benchConvert(BenchReport &report, const std::string &input, const std::string &path,
+                         LaserScan &sample) {
+    CLidar lidar;
+    int type = LIDAR_TYPE_REPLAY;
+    float speed = 0;
+    bool loop = true;
+    lidar.setlidaropt(LidarPropDeviceType, &type, sizeof(type));
+    lidar.setlidaropt(LidarPropSerialPort, path.c_str(), path.size());
+    lidar.setlidaropt(LidarPropReplaySpeed, &speed, sizeof(speed));
+    lidar.setlidaropt(LidarPropReplayLoop, &loop, sizeof(loop));
+    if (!lidar.initialize() || !lidar.turnOn()) {
+        fprintf(stderr, "failed to replay %s\n", path.c_str());
+        return false;
+    }
+
+    LaserScan scan;
+    BenchResult r;
+    r.name = "convert/" + input;
+    r.iterations = 0;
+    r.total_ns = 0;
+    r.items = 0;
+    uint64_t deadline = getns() + 30000000000ULL;
+    while (r.iterations < CONVERT_REVOLUTIONS && getns() < deadline) {
+        if (!lidar.doProcessSimple(scan)) {
+            continue;
+        }
+        ScanTimeline t = lidar.getScanTimeline();
+        r.total_ns += t.stamp[TraceConverted] - t.stamp[TraceGrabbed];
+        r.items += scan.points.size();
+        r.iterations++;
+        if (scan.points.size() > sample.points.size()) {
+            sample = scan;
+        }
+    }
+    ScanLatency latency;
+    lidar.getScanLatency(latency);
+    r.latency = latency.stage[TraceGrabbed];
+    r.counters.push_back(std::make_pair(std::string("points_per_scan"),
+                                        r.iterations ? (double)r.items / r.iterations : 0.0));
+    report.add(r);
+
+    lidar.turnOff();
+    lidar.disconnecting();
+    return r.iterations > 0;
+}
+
+/// every NoiseFilter strategy on one revolution
+static void benchFilters(BenchReport &report, const std::string &input, const LaserScan &scan) {
+    static const struct {
+        int strategy;
+        const char *name;
+    } strategies[] = {
+        {NoiseFilter::FS_Normal, "normal"},
+        {NoiseFilter::FS_Tail, "tail"},
+        {NoiseFilter::FS_TailStrong, "tail_strong"},
+        {NoiseFilter::FS_TailWeek, "tail_week"},
+        {NoiseFilter::FS_TailStrong2, "tail_strong2"},
+    };
+    for (size_t i = 0; i < sizeof(strategies) / sizeof(strategies[0]); i++) {
+        NoiseFilter filter;
+        filter.setStrategy(strategies[i].strategy);
+        LaserScan out;
+        report.run(std::string("filter/") + strategies[i].name + "/" + input, FILTER_ITERATIONS,
+                   [&](uint64_t) {
+            filter.filter(scan, 0, 0, out);
+            return scan.points.size();
+        });
+    }
+}
+
+/// cJSON as configMessage uses it, one answer and the full register set
+static void benchJson(BenchReport &report) {
+    static const char reply[] = "{\"motorSpeed\":10}";
+    static const char registers[] =
+        "{\"samplerate\":20,\"motorSpeed\":10,\"angleCompensation\":0,\"isMultiPoint\":0,\"APD\":0,"
+        "\"LD\":0,\"distanceCompensation\":0,\"measureMode\":0,\"calMode\":0,\"heartbeat\":1,"
+        "\"scanType\":-1,\"restart\":0}";
+    const char *inputs[] = {reply, registers};
+    const char *names[] = {"json/config_reply", "json/register_set"};
+    for (int i = 0; i < 2; i++) {
+        const char *text = inputs[i];
+        report.run(names[i], JSON_ITERATIONS, [&](uint64_t) {
+            cJSON *root = cJSON_Parse(text);
+            cJSON *item = cJSON_GetObjectItem(root, "motorSpeed");
+            size_t ok = cJSON_IsNumber(item) ? 1 : 0;
+            cJSON_Delete(root);
+            return ok;
+        });
+    }
+}
+
+static void benchInput(BenchReport &report, const std::string &input, const std::vector<DataFrame> &frames,
+                       const std::string &capture) {
+    std::vector<std::vector<node_info> > decoded;
+    benchDecode(report, input, frames, decoded);
+    benchAssemble(report, input, decoded);
+    LaserScan sample;
+    if (benchConvert(report, input, capture, sample)) {
+        benchFilters(report, input, sample);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    const char *output = "pipeline_bench.json";
+    const char *recorded = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            output = argv[++i];
+        } else if (argv[i][0] != '-') {
+            recorded = argv[i];
+        } else {
+            fprintf(stderr, "usage: %s [-o result.json] [capture file]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    BenchReport report;
+    std::vector<DataFrame> frames;
+    syntheticFrames(frames);
+    std::string capture = "pipeline_bench_synthetic.cap";
+    if (!writeCapture(capture, frames)) {
+        fprintf(stderr, "failed to write %s\n", capture.c_str());
+        return 1;
+    }
+    benchInput(report, "synthetic", frames, capture);
+    remove(capture.c_str());
+
+    if (recorded) {
+        frames.clear();
+        if (!recordedFrames(recorded, frames)) {
+            fprintf(stderr, "no DataFrame in %s\n", recorded);
+            return 1;
+        }
+        benchInput(report, "recorded", frames, recorded);
+    }
+    benchJson(report);
+
+    FILE *fp = strcmp(output, "-") == 0 ? stdout : fopen(output, "w");
+    if (!fp) {
+        fprintf(stderr, "failed to write %s\n", output);
+        return 1;
+    }
+    report.write(fp, "pipeline_bench");
+    if (fp != stdout) {
+        fclose(fp);
+    }
+    return 0;
+}
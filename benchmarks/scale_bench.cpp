@@ -0,0 +1,314 @@
+/*
+ * Throughput and latency of N network lidars on one host, N = 1..32
+ * usage: scale_bench [-n 1,2,4,8,16,32] [-r kHz] [-f Hz] [-t seconds]
+ *                    [-S lidar_simulator] [-o result.json]
+ * Every N starts lidar_simulator with N units on 127.0.0.x in its own
+ * process, so the CPU time measured is the SDK's alone: N CLidar instances,
+ * each with a thread calling doProcessSimple. Per N the result holds the
+ * converted points/s, the revolution latency from kernel receive to the
+ * filled LaserScan(p50 to p999 are exact), packet loss and the CPU per device.
+ * ns_per_op is the measured time divided by the converted revolutions.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <src/CLidar.h>
+#include "bench_report.h"
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+using namespace lidar;
+
+enum {
+    CONFIG_PORT = 8090,
+    DATA_PORT = 18000,                 ///< data port of the first unit, the next ones count up
+    WARMUP = 2000,                     ///< ms from turnOn to the measurement
+};
+
+/// one lidar and the thread consuming its revolutions
+struct Unit {
+    CLidar lidar;
+    std::thread consumer;
+    std::atomic<bool> running;
+    std::atomic<bool> measuring;
+    uint64_t points;                   ///< converted while measuring, consumer only
+    std::vector<uint64_t> latency;     ///< kernel receive to converted(ns), consumer only
+    LidarMetrics start;
+
+    Unit() : running(false), measuring(false), points(0) {
+    }
+
+    void consume() {
+        LaserScan scan;
+        while (running) {
+            if (!lidar.doProcessSimple(scan) || !measuring) {
+                continue;
+            }
+            ScanTimeline t = lidar.getScanTimeline();
+            points += scan.points.size();
+            if (t.stamp[TraceLastReceive] && t.stamp[TraceConverted] >= t.stamp[TraceLastReceive]) {
+                latency.push_back(t.stamp[TraceConverted] - t.stamp[TraceLastReceive]);
+            }
+        }
+    }
+};
+
+/// user + system time of the process(ns)
+static uint64_t cpuTime() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return ((uint64_t)usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000000ULL +
+           ((uint64_t)usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1000ULL;
+}
+
+/// datagrams the kernel dropped on full receive buffers, every socket of the host
+static uint64_t udpReceiveErrors() {
+    FILE *fp = fopen("/proc/net/snmp", "r");
+    if (!fp) {
+        return 0;
+    }
+    char names[1024];
+    char values[1024];
+    uint64_t errors = 0;
+    while (fgets(names, sizeof(names), fp) && fgets(values, sizeof(values), fp)) {
+        if (strncmp(names, "Udp:", 4) != 0) {
+            continue;
+        }
+        std::istringstream n(names);
+        std::istringstream v(values);
+        std::string name;
+        std::string value;
+        while (n >> name && v >> value) {
+            if (name == "RcvbufErrors") {
+                errors = strtoull(value.c_str(), NULL, 10);
+            }
+        }
+    }
+    fclose(fp);
+    return errors;
+}
+
+static pid_t startSimulator(const std::string &path, int count, int rate, int frequency) {
+    std::string n = std::to_string(count);
+    std::string p = std::to_string((int)DATA_PORT);
+    std::string r = std::to_string(rate);
+    std::string f = std::to_string(frequency);
+    const char *argv[] = {path.c_str(), "-n", n.c_str(), "-p", p.c_str(), "-b", "0",
+                          "-r", r.c_str(), "-f", f.c_str(), NULL
+                         };
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, 1, "/dev/null", O_WRONLY, 0);
+    pid_t pid = 0;
+    int ret = posix_spawn(&pid, path.c_str(), &actions, NULL, const_cast<char **>(argv), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    return ret == 0 ? pid : 0;
+}
+
+static void stopSimulator(pid_t pid) {
+    kill(pid, SIGTERM);
+    int status = 0;
+    waitpid(pid, &status, 0);
+}
+
+/**
+ * @brief run N lidars and measure them
+ * @return false if a lidar could not be started
+ */
+static bool measure(BenchReport &report, const std::string &simulator, int count, int rate, int frequency,
+                    int seconds) {
+    pid_t pid = startSimulator(simulator, count, rate, frequency);
+    if (pid == 0) {
+        fprintf(stderr, "cannot start %s\n", simulator.c_str());
+        return false;
+    }
+    delay(200 + 10 * count);
+
+    std::vector<std::unique_ptr<Unit> > units;
+    bool ok = true;
+    for (int i = 0; i < count && ok; i++) {
+        std::unique_ptr<Unit> unit(new Unit());
+        char ip[32];
+        snprintf(ip, sizeof(ip), "127.0.0.%d", 2 + i);
+        int baudrate = CONFIG_PORT;
+        int port = DATA_PORT + i;
+        float speed = (float)frequency;
+        unit->lidar.setlidaropt(LidarPropSerialPort, ip, strlen(ip));
+        unit->lidar.setlidaropt(LidarPropSerialBaudrate, &baudrate, sizeof(baudrate));
+        unit->lidar.setlidaropt(LidarPropDataPort, &port, sizeof(port));
+        unit->lidar.setlidaropt(LidarPropSampleRate, &rate, sizeof(rate));
+        unit->lidar.setlidaropt(LidarPropScanFrequency, &speed, sizeof(speed));
+        ok = unit->lidar.initialize() && unit->lidar.turnOn();
+        if (!ok) {
+            fprintf(stderr, "lidar %s failed to start\n", ip);
+        }
+        unit->running = true;
+        Unit *u = unit.get();
+        unit->consumer = std::thread([u]() {
+            u->consume();
+        });
+        units.push_back(std::move(unit));
+    }
+
+    if (ok) {
+        delay(WARMUP);
+        uint64_t cpu = cpuTime();
+        uint64_t dropped = udpReceiveErrors();
+        uint64_t start = getns();
+        for (size_t i = 0; i < units.size(); i++) {
+            units[i]->start = units[i]->lidar.getMetrics();
+            units[i]->measuring = true;
+        }
+        delay(seconds * 1000);
+        for (size_t i = 0; i < units.size(); i++) {
+            units[i]->measuring = false;
+        }
+        uint64_t elapsed = getns() - start;
+        cpu = cpuTime() - cpu;
+        dropped = udpReceiveErrors() - dropped;
+
+        uint64_t packets = 0;
+        uint64_t gaps = 0;
+        uint64_t overwritten = 0;
+        for (size_t i = 0; i < units.size(); i++) {
+            LidarMetrics end = units[i]->lidar.getMetrics();
+            packets += end.packets - units[i]->start.packets;
+            gaps += end.sequence_gaps - units[i]->start.sequence_gaps;
+            overwritten += end.scans_overwritten - units[i]->start.scans_overwritten;
+        }
+
+        //the consumers are stopped before their samples are read
+        for (size_t i = 0; i < units.size(); i++) {
+            units[i]->running = false;
+            units[i]->consumer.join();
+        }
+        BenchResult r;
+        r.name = "scale/" + std::to_string(count);
+        r.iterations = 0;
+        r.total_ns = elapsed;
+        r.items = 0;
+        std::vector<uint64_t> latency;
+        for (size_t i = 0; i < units.size(); i++) {
+            r.items += units[i]->points;
+            latency.insert(latency.end(), units[i]->latency.begin(), units[i]->latency.end());
+        }
+        r.iterations = latency.size();
+        BenchReport::percentiles(latency, r.latency);
+
+        double s = elapsed * 1e-9;
+        //a gap loses one packet at least, the count is a lower bound
+        double loss = packets + gaps ? (double)gaps / (packets + gaps) : 0;
+        r.counters.push_back(std::make_pair(std::string("devices"), (double)count));
+        r.counters.push_back(std::make_pair(std::string("points_per_second_per_device"), r.items / s / count));
+        r.counters.push_back(std::make_pair(std::string("packets_per_second"), packets / s));
+        r.counters.push_back(std::make_pair(std::string("sequence_gaps"), (double)gaps));
+        r.counters.push_back(std::make_pair(std::string("packet_loss"), loss));
+        r.counters.push_back(std::make_pair(std::string("udp_receive_errors"), (double)dropped));
+        r.counters.push_back(std::make_pair(std::string("scans_overwritten"), (double)overwritten));
+        r.counters.push_back(std::make_pair(std::string("cpu_per_device"), cpu / (double)elapsed / count));
+        report.add(r);
+    } else {
+        for (size_t i = 0; i < units.size(); i++) {
+            units[i]->running = false;
+            units[i]->consumer.join();
+        }
+    }
+
+    for (size_t i = 0; i < units.size(); i++) {
+        units[i]->lidar.turnOff();
+        units[i]->lidar.disconnecting();
+    }
+    stopSimulator(pid);
+    return ok;
+}
+
+int main(int argc, char *argv[]) {
+    std::vector<int> counts;
+    int rate = 20;
+    int frequency = 10;
+    int seconds = 5;
+    const char *output = "scale_bench.json";
+    std::string simulator = argv[0];
+    size_t slash = simulator.rfind('/');
+    simulator = (slash == std::string::npos ? std::string(".") : simulator.substr(0, slash)) + "/lidar_simulator";
+
+    for (int i = 1; i < argc; i++) {
+        const char *opt = argv[i];
+        const char *val = i + 1 < argc ? argv[++i] : NULL;
+        if (!val || strlen(opt) != 2 || opt[0] != '-') {
+            counts.clear();
+            counts.push_back(-1);
+            break;
+        }
+        switch (opt[1]) {
+            case 'n': {
+                std::istringstream list(val);
+                std::string item;
+                while (std::getline(list, item, ',')) {
+                    counts.push_back(atoi(item.c_str()));
+                }
+                break;
+            }
+            case 'r': rate = atoi(val); break;
+            case 'f': frequency = atoi(val); break;
+            case 't': seconds = atoi(val); break;
+            case 'S': simulator = val; break;
+            case 'o': output = val; break;
+            default:
+                counts.assign(1, -1);
+                break;
+        }
+    }
+    if (counts.empty()) {
+        int defaults[] = {1, 2, 4, 8, 16, 32};
+        counts.assign(defaults, defaults + 6);
+    }
+    for (size_t i = 0; i < counts.size(); i++) {
+        if (counts[i] <= 0 || counts[i] > 250 || rate <= 0 || frequency <= 0 || seconds <= 0) {
+            fprintf(stderr, "usage: %s [-n 1,2,4,8,16,32] [-r kHz] [-f Hz] [-t seconds] "
+                    "[-S lidar_simulator] [-o result.json]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    BenchReport report;
+    for (size_t i = 0; i < counts.size(); i++) {
+        if (!measure(report, simulator, counts[i], rate, frequency, seconds)) {
+            return 1;
+        }
+    }
+
+    FILE *fp = strcmp(output, "-") == 0 ? stdout : fopen(output, "w");
+    if (!fp) {
+        fprintf(stderr, "failed to write %s\n", output);
+        return 1;
+    }
+    report.write(fp, "scale_bench");
+    if (fp != stdout) {
+        fclose(fp);
+    }
+    return 0;
+}
+
+#else
+
+int main() {
+    fprintf(stderr, "scale_bench needs posix_spawn\n");
+    return 1;
+}
+
+#endif
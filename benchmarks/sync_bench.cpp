@@ -0,0 +1,112 @@
+/*
+ * Locker and Event cost, futex against the pthread based implementation
+ * usage: sync_bench [iterations]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <thread>
+#include <core/base/locker.h>
+
+using namespace lidar::core::base;
+typedef std::chrono::steady_clock bench_clock;
+
+static double elapsed_ns(bench_clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(bench_clock::now() - start).count();
+}
+
+/// lock + unlock without contention
+template <typename L>
+static double uncontendedLock(long n) {
+    L lock;
+    bench_clock::time_point start = bench_clock::now();
+    for (long i = 0; i < n; i++) {
+        lock.lock();
+        lock.unlock();
+    }
+    return elapsed_ns(start) / n;
+}
+
+/// two threads incrementing one counter
+template <typename L>
+static double contendedLock(long n) {
+    L lock;
+    volatile long counter = 0;
+    bench_clock::time_point start = bench_clock::now();
+    std::thread other([&]() {
+        for (long i = 0; i < n; i++) {
+            lock.lock();
+            counter = counter + 1;
+            lock.unlock();
+        }
+    });
+    for (long i = 0; i < n; i++) {
+        lock.lock();
+        counter = counter + 1;
+        lock.unlock();
+    }
+    other.join();
+    if (counter != 2 * n) {
+        fprintf(stderr, "lost updates: %ld of %ld\n", (long)counter, 2 * n);
+    }
+    return elapsed_ns(start) / (2 * n);
+}
+
+/// set + wait of a signalled event, the grabScanData path when a scan is ready
+template <typename E>
+static double uncontendedEvent(long n) {
+    E event;
+    bench_clock::time_point start = bench_clock::now();
+    for (long i = 0; i < n; i++) {
+        event.set();
+        event.wait(0xFFFFFFFF);
+    }
+    return elapsed_ns(start) / n;
+}
+
+/// one way handoff between two threads, the revolution handoff to the user
+template <typename E>
+static double pingPong(long n) {
+    E ping;
+    E pong;
+    bench_clock::time_point start = bench_clock::now();
+    std::thread other([&]() {
+        for (long i = 0; i < n; i++) {
+            ping.wait(0xFFFFFFFF);
+            pong.set();
+        }
+    });
+    for (long i = 0; i < n; i++) {
+        ping.set();
+        pong.wait(0xFFFFFFFF);
+    }
+    other.join();
+    return elapsed_ns(start) / (2 * n);
+}
+
+int main(int argc, char *argv[]) {
+    long n = argc > 1 ? atol(argv[1]) : 1000000;
+    long handoffs = n / 10 > 0 ? n / 10 : 1;
+
+    //glibc skips the atomics while a process has one thread, the SDK never has
+    std::thread idle([]() {});
+    idle.detach();
+
+    printf("%-24s %12s %12s\n", "ns/op", "system", "futex");
+#if defined(__linux__)
+    printf("%-24s %12.1f %12.1f\n", "lock, uncontended",
+           uncontendedLock<SystemLocker>(n), uncontendedLock<FutexLocker>(n));
+    printf("%-24s %12.1f %12.1f\n", "lock, 2 threads",
+           contendedLock<SystemLocker>(n), contendedLock<FutexLocker>(n));
+    printf("%-24s %12.1f %12.1f\n", "event set+wait",
+           uncontendedEvent<SystemEvent>(n), uncontendedEvent<FutexEvent>(n));
+    printf("%-24s %12.1f %12.1f\n", "event handoff",
+           pingPong<SystemEvent>(handoffs), pingPong<FutexEvent>(handoffs));
+#else
+    printf("%-24s %12.1f %12s\n", "lock, uncontended", uncontendedLock<SystemLocker>(n), "-");
+    printf("%-24s %12.1f %12s\n", "lock, 2 threads", contendedLock<SystemLocker>(n), "-");
+    printf("%-24s %12.1f %12s\n", "event set+wait", uncontendedEvent<SystemEvent>(n), "-");
+    printf("%-24s %12.1f %12s\n", "event handoff", pingPong<SystemEvent>(handoffs), "-");
+#endif
+    return 0;
+}
@@ -0,0 +1,194 @@
+#pragma once
+#if defined(__linux__)
+#include <atomic>
+#include <limits.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+namespace lidar {
+namespace core {
+namespace base {
+
+namespace futex {
+
+/// CLOCK_MONOTONIC in ns
+inline long long monotonic_ns() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+/// sleep while *addr == expected, at most timeout_ns (< 0: no limit)
+inline int wait(std::atomic<int> *addr, int expected, long long timeout_ns) {
+    timespec rel;
+    timespec *prel = NULL;
+    if (timeout_ns >= 0) {
+        rel.tv_sec = timeout_ns / 1000000000LL;
+        rel.tv_nsec = timeout_ns % 1000000000LL;
+        prel = &rel;
+    }
+    return syscall(SYS_futex, reinterpret_cast<int *>(addr), FUTEX_WAIT_PRIVATE, expected, prel, NULL, 0);
+}
+
+inline void wake(std::atomic<int> *addr, int count) {
+    syscall(SYS_futex, reinterpret_cast<int *>(addr), FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0);
+}
+
+/// ns left until deadline, < 0 without limit
+inline long long remaining(unsigned long timeout, long long deadline) {
+    if (timeout == 0xFFFFFFFF) {
+        return -1;
+    }
+    long long left = deadline - monotonic_ns();
+    return left > 0 ? left : 0;
+}
+
+}//futex
+
+/**
+ * @brief Futex mutex, same interface as SystemLocker \n
+ * Lock and unlock are one atomic operation each while uncontended, the
+ * kernel is only entered to sleep or to wake a sleeper.
+ * 0: unlocked, 1: locked, 2: locked with possible sleepers.
+ */
+class FutexLocker {
+public:
+    enum LOCK_STATUS {
+        LOCK_OK = 0,
+        LOCK_TIMEOUT = -1,
+        LOCK_FAILED = -2
+    };
+
+    enum {
+        SPIN_COUNT = 100,             ///< CAS attempts before sleeping
+    };
+
+    FutexLocker() : _state(0) {
+    }
+
+    FutexLocker::LOCK_STATUS lock(unsigned long timeout = 0xFFFFFFFF) {
+        int c = 0;
+        if (_state.compare_exchange_strong(c, 1, std::memory_order_acquire)) {
+            return LOCK_OK;
+        }
+        if (timeout == 0) {
+            return LOCK_FAILED;//as pthread_mutex_trylock
+        }
+
+        //short critical sections end while spinning
+        for (int i = 0; i < SPIN_COUNT; i++) {
+            c = 0;
+            if (_state.compare_exchange_weak(c, 1, std::memory_order_acquire)) {
+                return LOCK_OK;
+            }
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_ia32_pause();
+#endif
+        }
+
+        long long deadline = futex::monotonic_ns() + (long long)timeout * 1000000LL;
+        if (c != 2) {
+            c = _state.exchange(2, std::memory_order_acquire);
+        }
+        while (c != 0) {
+            long long left = futex::remaining(timeout, deadline);
+            if (left == 0) {
+                return LOCK_TIMEOUT;
+            }
+            futex::wait(&_state, 2, left);
+            c = _state.exchange(2, std::memory_order_acquire);
+        }
+        return LOCK_OK;
+    }
+
+    void unlock() {
+        if (_state.fetch_sub(1, std::memory_order_release) != 1) {
+            _state.store(0, std::memory_order_release);
+            futex::wake(&_state, 1);
+        }
+    }
+
+private:
+    FutexLocker(const FutexLocker &);
+    FutexLocker &operator=(const FutexLocker &);
+
+    std::atomic<int> _state;
+};
+
+
+/**
+ * @brief Futex event, same interface as SystemEvent \n
+ * ::set only enters the kernel if a thread sleeps in ::wait, ::wait only
+ * if the event is not signalled yet.
+ */
+class FutexEvent {
+public:
+    enum {
+        EVENT_OK = 1,
+        EVENT_TIMEOUT = 2,
+        EVENT_FAILED = 0,
+    };
+
+    explicit FutexEvent(bool isAutoReset = true, bool isSignal = false)
+        : _signalled(isSignal ? 1 : 0)
+        , _waiters(0)
+        , _isAutoReset(isAutoReset) {
+    }
+
+    void set(bool isSignal = true) {
+        if (!isSignal) {
+            _signalled.store(0);
+            return;
+        }
+        //seq_cst pairs with ::wait: either the waiter is seen or it sees the signal
+        if (_signalled.exchange(1) == 0 && _waiters.load() > 0) {
+            futex::wake(&_signalled, _isAutoReset ? 1 : INT_MAX);
+        }
+    }
+
+    unsigned long wait(unsigned long timeout = 0xFFFFFFFF) {
+        if (consume()) {
+            return EVENT_OK;//no clock read on the fast path
+        }
+        long long deadline = futex::monotonic_ns() + (long long)timeout * 1000000LL;
+        while (true) {
+            long long left = futex::remaining(timeout, deadline);
+            if (left == 0) {
+                return EVENT_TIMEOUT;
+            }
+            _waiters.fetch_add(1);
+            if (_signalled.load() == 0) {
+                futex::wait(&_signalled, 0, left);
+            }
+            _waiters.fetch_sub(1);
+            if (consume()) {
+                return EVENT_OK;
+            }
+        }
+    }
+
+private:
+    FutexEvent(const FutexEvent &);
+    FutexEvent &operator=(const FutexEvent &);
+
+    bool consume() {
+        if (!_isAutoReset) {
+            return _signalled.load(std::memory_order_acquire) != 0;
+        }
+        int s = 1;
+        return _signalled.compare_exchange_strong(s, 0, std::memory_order_acquire);
+    }
+
+    std::atomic<int> _signalled;      ///< futex word, 1 while signalled
+    std::atomic<int> _waiters;        ///< threads about to sleep or sleeping in ::wait
+    bool _isAutoReset;
+};
+
+}//base
+}//core
+}//lidar
+
+#endif // defined(__linux__)
@@ -14,13 +14,17 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <errno.h>
+#include "futex.h"
 #endif
 
 namespace lidar {
 namespace core {
 namespace base {
 
-class Locker {
+/**
+ * @brief mutex of the operating system, Locker on non-Linux systems
+ */
+class SystemLocker {
     public:
     enum LOCK_STATUS {
         LOCK_OK = 0,
@@ -28,18 +32,18 @@ class Locker {
         LOCK_FAILED = -2
     };
 
-    Locker() {
+    SystemLocker() {
 #ifdef _WIN32
         _lock = NULL;
 #endif
         init();
     }
 
-    ~Locker() {
+    ~SystemLocker() {
         release();
     }
 
-    Locker::LOCK_STATUS lock(unsigned long timeout = 0xFFFFFFFF) {
+    SystemLocker::LOCK_STATUS lock(unsigned long timeout = 0xFFFFFFFF) {
 #ifdef _WIN32
 
     switch (WaitForSingleObject(_lock,
@@ -184,7 +188,10 @@ class Locker {
 };
 
 
-class Event {
+/**
+ * @brief condition variable event, Event on non-Linux systems
+ */
+class SystemEvent {
     public:
 
     enum {
@@ -193,7 +200,7 @@ class Event {
         EVENT_FAILED = 0,
     };
 
-    explicit Event(bool isAutoReset = true, bool isSignal = false)
+    explicit SystemEvent(bool isAutoReset = true, bool isSignal = false)
 #ifdef _WIN32
         : _event(NULL)
 #else
@@ -218,7 +225,7 @@ class Event {
 #endif
     }
 
-    ~ Event() {
+    ~ SystemEvent() {
         release();
     }
 
@@ -338,6 +345,15 @@ _final:
 #endif
 };
 
+#if defined(__linux__)
+//uncontended lock/unlock and set/wait stay in user space
+typedef FutexLocker Locker;
+typedef FutexEvent Event;
+#else
+typedef SystemLocker Locker;
+typedef SystemEvent Event;
+#endif
+
 class ScopedLocker {
 	public :
 	explicit ScopedLocker(Locker &l): _binded(l) {
@@ -0,0 +1,223 @@
+#pragma once
+#include "v8stdint.h"
+#include <atomic>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <windows.h>
+#else
+#include <poll.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/eventfd.h>
+#endif
+#endif
+
+namespace lidar {
+namespace core {
+namespace base {
+
+/**
+ * @brief Cooperative stop request of a thread \n
+ * The thread polls ::stopRequested and does all of its blocking waits
+ * through ::sleep and ::waitReadable, which end as soon as ::requestStop is
+ * called, so Thread::join returns within microseconds and no thread is
+ * cancelled. The wakeup is an eventfd on Linux, a self-pipe on other POSIX
+ * systems and an event handle on Windows.
+ */
+class StopToken {
+public:
+    enum {
+        WAIT_READABLE = 1,      ///< the descriptor is readable
+        WAIT_TIMEOUT = 0,       ///< nothing happened within the timeout
+        WAIT_STOPPED = -1,      ///< ::requestStop was called
+        WAIT_FAILED = -2,       ///< the descriptor failed or was closed
+    };
+
+    StopToken() : _stop(false) {
+#if defined(_WIN32)
+        _event = CreateEvent(NULL, TRUE, FALSE, NULL);
+#elif defined(__linux__)
+        _fd[0] = _fd[1] = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+#else
+        if (pipe(_fd) == 0) {
+            for (int i = 0; i < 2; i++) {
+                fcntl(_fd[i], F_SETFL, O_NONBLOCK);
+                fcntl(_fd[i], F_SETFD, FD_CLOEXEC);
+            }
+        } else {
+            _fd[0] = _fd[1] = -1;
+        }
+#endif
+    }
+
+    ~StopToken() {
+#if defined(_WIN32)
+        CloseHandle(_event);
+#else
+        if (_fd[0] != -1) {
+            close(_fd[0]);
+        }
+        if (_fd[1] != _fd[0] && _fd[1] != -1) {
+            close(_fd[1]);
+        }
+#endif
+    }
+
+    /**
+     * @brief ask the thread to stop and wake it from any wait
+     */
+    void requestStop() {
+        if (_stop.exchange(true)) {
+            return;
+        }
+#if defined(_WIN32)
+        SetEvent(_event);
+#else
+        uint64_t one = 1;
+        //an eventfd takes 8 bytes, a pipe takes them just as well
+        ssize_t ret = write(_fd[1], &one, sizeof(one));
+        (void)ret;
+#endif
+    }
+
+    /**
+     * @brief clear the request before the thread is started again
+     */
+    void reset() {
+        if (!_stop.exchange(false)) {
+            return;
+        }
+#if defined(_WIN32)
+        ResetEvent(_event);
+#else
+        uint64_t buf;
+        while (read(_fd[0], &buf, sizeof(buf)) > 0) {
+        }
+#endif
+    }
+
+    bool stopRequested() const {
+        return _stop.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief sleep unless a stop is requested
+     * @param timeout  ms
+     * @return false if a stop was requested
+     */
+    bool sleep(uint32_t timeout) {
+#if defined(_WIN32)
+        WaitForSingleObject(_event, timeout);
+#else
+        waitReadable(-1, timeout);
+#endif
+        return !stopRequested();
+    }
+
+    /**
+     * @brief wait until a descriptor is readable or a stop is requested
+     * @param fd       socket or device, -1 to wait for the stop only
+     * @param timeout  ms, 0xFFFFFFFF without limit
+     * @return WAIT_READABLE, WAIT_TIMEOUT, WAIT_STOPPED or WAIT_FAILED
+     * @note sockets only on Windows, they are polled in short slices there
+     */
+    int waitReadable(int fd, uint32_t timeout) {
+        return wait(fd, false, timeout);
+    }
+
+    /**
+     * @brief wait until a socket is writable or a stop is requested, e.g. a nonblocking connect
+     * @param fd       socket
+     * @param timeout  ms, 0xFFFFFFFF without limit
+     * @return WAIT_READABLE when writable, WAIT_TIMEOUT, WAIT_STOPPED or WAIT_FAILED
+     */
+    int waitWritable(int fd, uint32_t timeout) {
+        return wait(fd, true, timeout);
+    }
+
+    /**
+     * @brief descriptor that turns readable on ::requestStop, -1 on Windows
+     */
+    int fd() const {
+#if defined(_WIN32)
+        return -1;
+#else
+        return _fd[0];
+#endif
+    }
+
+private:
+    StopToken(const StopToken &);
+    StopToken &operator=(const StopToken &);
+
+    int wait(int fd, bool write, uint32_t timeout) {
+        if (stopRequested()) {
+            return WAIT_STOPPED;
+        }
+#if defined(_WIN32)
+        if (fd == -1) {
+            WaitForSingleObject(_event, timeout);
+            return stopRequested() ? WAIT_STOPPED : WAIT_TIMEOUT;
+        }
+        //select cannot wait on the event handle
+        uint32_t waited = 0;
+        do {
+            uint32_t slice = timeout - waited < WIN_SLICE ? timeout - waited : WIN_SLICE;
+            fd_set fds;
+            FD_ZERO(&fds);
+            FD_SET((SOCKET)fd, &fds);
+            //a failed connect is reported in the except set
+            fd_set efds;
+            FD_ZERO(&efds);
+            FD_SET((SOCKET)fd, &efds);
+            timeval tv = {0, (long)slice * 1000};
+            int r = write ? select(0, NULL, &fds, &efds, &tv) : select(0, &fds, NULL, NULL, &tv);
+            if (r > 0) {
+                return WAIT_READABLE;
+            }
+            if (r < 0) {
+                return WAIT_FAILED;
+            }
+            waited += slice;
+            if (stopRequested()) {
+                return WAIT_STOPPED;
+            }
+        } while (waited < timeout);
+        return WAIT_TIMEOUT;
+#else
+        pollfd fds[2] = {{_fd[0], POLLIN, 0}, {fd, (short)(write ? POLLOUT : POLLIN), 0}};
+        int r = poll(fds, fd == -1 ? 1 : 2, (int)timeout);
+        if (r < 0) {
+            return errno == EINTR ? WAIT_TIMEOUT : WAIT_FAILED;
+        }
+        if (fds[0].revents || stopRequested()) {
+            return WAIT_STOPPED;
+        }
+        if (r == 0) {
+            return WAIT_TIMEOUT;
+        }
+        if (fds[1].revents & POLLNVAL) {
+            return WAIT_FAILED;
+        }
+        //errors and hangups are reported by the read or connect that follows
+        return WAIT_READABLE;
+#endif
+    }
+
+#if defined(_WIN32)
+    enum {
+        WIN_SLICE = 10,         ///< stop check interval of socket waits(ms)
+    };
+    HANDLE _event;
+#else
+    int _fd[2];                 ///< read and write end, the same eventfd on Linux
+#endif
+    std::atomic<bool> _stop;
+};
+
+}//base
+}//core
+}//lidar
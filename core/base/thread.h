@@ -8,8 +8,15 @@
 #include <process.h>
 #else
 #include <pthread.h>
+#include <sched.h>
+#include <limits.h>
+#include <errno.h>
 #include <assert.h>
 #endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
 
 
 #if defined(__ANDROID__)
@@ -17,17 +24,39 @@
 #endif
 
 #define CLASS_THREAD(c , x ) Thread::ThreadCreateObjectFunctor<c, &c::x>(this)
+#define CLASS_THREAD_ATTR(c , x, attr) Thread::ThreadCreateObjectFunctor<c, &c::x>(this, &(attr))
 
 namespace lidar {
 namespace core {
 namespace base {
 
+/// scheduling policy of a thread, the values of SCHED_OTHER, SCHED_FIFO and SCHED_RR
+enum ThreadPolicy {
+  ThreadPolicyNormal = 0,
+  ThreadPolicyFifo = 1,
+  ThreadPolicyRoundRobin = 2,
+};
+
+/**
+ * @brief thread attributes, default constructed means the system defaults
+ */
+struct thread_attr {
+  std::string name;     ///< shown by top -H and debuggers, at most 15 characters
+  std::string cpus;     ///< allowed CPUs as a list like "2-3,6", empty for any
+  int policy;           ///< ThreadPolicy, real-time needs CAP_SYS_NICE or an rtprio limit
+  int priority;         ///< 1-99 for the real-time policies
+  size_t stack_size;    ///< bytes, 0 for the default
+
+  thread_attr(const char *thread_name = "")
+    : name(thread_name), policy(ThreadPolicyNormal), priority(0), stack_size(0) {}
+};
+
 class Thread {
  public:
 
   template <class CLASS, int (CLASS::*PROC)(void)> static Thread
-  ThreadCreateObjectFunctor(CLASS *pthis) {
-    return createThread(createThreadAux<CLASS, PROC>, pthis);
+  ThreadCreateObjectFunctor(CLASS *pthis, const thread_attr *attr = NULL) {
+    return createThread(createThreadAux<CLASS, PROC>, pthis, attr);
   }
 
   template <class CLASS, int (CLASS::*PROC)(void) > static _size_t THREAD_PROC
@@ -35,20 +64,117 @@ class Thread {
     return (static_cast<CLASS *>(param)->*PROC)();
   }
 
-  static Thread createThread(thread_proc_t proc, void *param = NULL) {
+  static Thread createThread(thread_proc_t proc, void *param = NULL,
+                             const thread_attr *attr = NULL) {
     Thread thread_(proc, param);
+    std::vector<int> cpus;
+    if (attr && !parseCpuList(attr->cpus, cpus)) {
+      fprintf(stderr, "Invalid cpu list \"%s\" of thread %s\n", attr->cpus.c_str(), attr->name.c_str());
+    }
 #if defined(_WIN32)
-    thread_._handle = (_size_t)(_beginthreadex(NULL, 0,
+    thread_._handle = (_size_t)(_beginthreadex(NULL, attr ? (unsigned)attr->stack_size : 0,
                                 (unsigned int (__stdcall *)(void *))proc, param, 0, NULL));
+    if (thread_._handle && attr) {
+      DWORD_PTR mask = 0;
+      for (size_t i = 0; i < cpus.size(); i++) {
+        if (cpus[i] < (int)sizeof(mask) * 8) {
+          mask |= (DWORD_PTR)1 << cpus[i];
+        }
+      }
+      if (mask) {
+        SetThreadAffinityMask(reinterpret_cast<HANDLE>(thread_._handle), mask);
+      }
+      if (attr->policy != ThreadPolicyNormal) {
+        SetThreadPriority(reinterpret_cast<HANDLE>(thread_._handle), THREAD_PRIORITY_TIME_CRITICAL);
+      }
+    }
 #else
     assert(sizeof(thread_._handle) >= sizeof(pthread_t));
+    pthread_attr_t pattr;
+    pthread_attr_init(&pattr);
+    if (attr && attr->stack_size) {
+      pthread_attr_setstacksize(&pattr, attr->stack_size < (size_t)PTHREAD_STACK_MIN ? (size_t)PTHREAD_STACK_MIN : attr->stack_size);
+    }
+    if (attr && attr->policy != ThreadPolicyNormal) {
+      sched_param param_;
+      int lo = sched_get_priority_min(attr->policy);
+      int hi = sched_get_priority_max(attr->policy);
+      param_.sched_priority = attr->priority < lo ? lo : (attr->priority > hi ? hi : attr->priority);
+      pthread_attr_setinheritsched(&pattr, PTHREAD_EXPLICIT_SCHED);
+      pthread_attr_setschedpolicy(&pattr, attr->policy);
+      pthread_attr_setschedparam(&pattr, &param_);
+    }
 
-    pthread_create((pthread_t *)&thread_._handle, NULL, (void *(*)(void *))proc,
+    int ret = pthread_create((pthread_t *)&thread_._handle, &pattr, (void *(*)(void *))proc,
                    param);
+    if (ret == EPERM && attr && attr->policy != ThreadPolicyNormal) {
+      //the thread still runs, without the real-time policy
+      fprintf(stderr, "No permission for real-time scheduling of thread %s\n", attr->name.c_str());
+      pthread_attr_setinheritsched(&pattr, PTHREAD_INHERIT_SCHED);
+      ret = pthread_create((pthread_t *)&thread_._handle, &pattr, (void *(*)(void *))proc,
+                           param);
+    }
+    pthread_attr_destroy(&pattr);
+    if (ret != 0) {
+      thread_._handle = 0;
+      return thread_;
+    }
+#if defined(__linux__)
+    if (attr && !attr->name.empty()) {
+      pthread_setname_np((pthread_t)thread_._handle, attr->name.substr(0, 15).c_str());
+    }
+#if !defined(__ANDROID__)
+    if (!cpus.empty()) {
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      for (size_t i = 0; i < cpus.size(); i++) {
+        if (cpus[i] < CPU_SETSIZE) {
+          CPU_SET(cpus[i], &set);
+        }
+      }
+      if (pthread_setaffinity_np((pthread_t)thread_._handle, sizeof(set), &set) != 0) {
+        fprintf(stderr, "Failed to pin thread %s to cpus %s\n", attr->name.c_str(), attr->cpus.c_str());
+      }
+    }
+#endif
+#endif
 #endif
     return thread_;
   }
 
+  /**
+   * @brief parse a cpu list like "0-2,5"
+   * @return false on a syntax error, cpus holds the part before it
+   */
+  static bool parseCpuList(const std::string &list, std::vector<int> &cpus) {
+    const char *p = list.c_str();
+    while (*p) {
+      char *end = NULL;
+      long first = strtol(p, &end, 10);
+      if (end == p || first < 0) {
+        return false;
+      }
+      long last = first;
+      p = end;
+      if (*p == '-') {
+        last = strtol(p + 1, &end, 10);
+        if (end == p + 1 || last < first) {
+          return false;
+        }
+        p = end;
+      }
+      for (long cpu = first; cpu <= last && cpu < 4096; cpu++) {
+        cpus.push_back((int)cpu);
+      }
+      if (*p == ',') {
+        p++;
+      } else if (*p) {
+        return false;
+      }
+    }
+    return true;
+  }
+
  public:
   explicit Thread(): _param(NULL), _func(NULL), _handle(0) {}
   virtual ~Thread() {}
@@ -82,6 +208,9 @@ class Thread {
   void *getParam() {
     return _param;
   }
+  /**
+   * @brief wait for the thread to return, it has to be asked to stop first
+   */
   int join(unsigned long timeout = -1) {
     if (!this->_handle) {
       return 0;
@@ -104,22 +233,9 @@ class Thread {
 
 #else
     UNUSED(timeout);
-    void *res;
-    int s = -1;
-    s = pthread_cancel((pthread_t)(this->_handle));
-
-    if (s != 0) {
-    }
-
-    s = pthread_join((pthread_t)(this->_handle), &res);
-
-    if (s != 0) {
-    }
-
-    if (res == PTHREAD_CANCELED) {
-      printf("%lu thread has been canceled\n", this->_handle);
-      this->_handle = 0;
-    }
+    //threads are never cancelled, they leave on their StopToken or state
+    pthread_join((pthread_t)(this->_handle), NULL);
+    this->_handle = 0;
 
 #endif
     return 0;
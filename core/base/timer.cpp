@@ -6,9 +6,11 @@
 namespace impl {
 
 static LARGE_INTEGER _current_freq;
+static LARGE_INTEGER _perf_freq;
 
 void HPtimer_reset() {
   BOOL ans = QueryPerformanceFrequency(&_current_freq);
+  _perf_freq = _current_freq;
   _current_freq.QuadPart /= 1000;
 }
 
@@ -26,6 +28,19 @@ uint64_t getCurrentTime() {
          100;
 }
 
+uint64_t getMonotonicTime() {
+  LARGE_INTEGER current;
+  QueryPerformanceCounter(&current);
+  uint64_t freq = _perf_freq.QuadPart;
+  //split, the counter times 1e9 overflows after a few days
+  return (current.QuadPart / freq) * 1000000000ULL +
+         (current.QuadPart % freq) * 1000000000ULL / freq;
+}
+
+bool isTscClock() {
+  return false;
+}
+
 
 BEGIN_STATIC_CODE(timer_cailb) {
   HPtimer_reset();
@@ -33,8 +48,91 @@ BEGIN_STATIC_CODE(timer_cailb) {
 
 }
 #else
+#include <stdio.h>
+#include <string.h>
+#if defined(__linux__) && (defined(__x86_64__) || defined(__i386__))
+#include <atomic>
+#include <x86intrin.h>
+#define HAS_TSC_CLOCK 1
+#endif
 
 namespace impl {
+
+static inline uint64_t clock_ns(clockid_t id) {
+  struct timespec t;
+  clock_gettime(id, &t);
+  return static_cast<uint64_t>(t.tv_sec) * 1000000000ULL + t.tv_nsec;
+}
+
+#if HAS_TSC_CLOCK
+enum {
+  TSC_CALIBRATION_NS = 20000000,     ///< shortest span a tick rate is measured over
+  TSC_RESYNC_NS = 1000000000,        ///< re-anchor interval to CLOCK_MONOTONIC
+};
+
+/// the kernel only keeps the TSC as clocksource if it is invariant and synchronized
+static bool tsc_trusted() {
+  char name[32] = {0};
+  FILE *fp = fopen("/sys/devices/system/clocksource/clocksource0/current_clocksource", "r");
+  if (!fp) {
+    return false;
+  }
+  bool ok = fgets(name, sizeof(name), fp) && strncmp(name, "tsc", 3) == 0;
+  fclose(fp);
+  return ok;
+}
+
+static bool use_tsc() {
+  static const bool tsc = tsc_trusted();
+  return tsc;
+}
+
+/// ns per tick, measured by the first thread that calibrated
+static std::atomic<double> tsc_rate(0.0);
+
+/// per thread, no thread waits for another one
+struct tsc_anchor {
+  uint64_t tsc;
+  uint64_t ns;
+  uint64_t resync;                   ///< ticks until the next anchor
+  uint64_t last;                     ///< last value returned
+  double rate;                       ///< ns per tick, 0 until known
+};
+
+static uint64_t tsc_ns() {
+  static __thread tsc_anchor a = {0, 0, 0, 0, 0.0};
+  uint64_t tsc = __rdtsc();
+  uint64_t ns;
+
+  if (a.rate > 0 && tsc - a.tsc < a.resync) {
+    ns = a.ns + static_cast<uint64_t>((tsc - a.tsc) * a.rate);
+  } else {
+    ns = clock_ns(CLOCK_MONOTONIC);
+    tsc = __rdtsc();
+    if (a.ns != 0 && ns - a.ns >= TSC_CALIBRATION_NS && tsc > a.tsc) {
+      //the rate of the last interval follows the NTP slew of CLOCK_MONOTONIC
+      a.rate = static_cast<double>(ns - a.ns) / (tsc - a.tsc);
+      tsc_rate.store(a.rate, std::memory_order_relaxed);
+    } else if (a.rate == 0) {
+      a.rate = tsc_rate.load(std::memory_order_relaxed);
+    }
+    //an uncalibrated anchor is kept until the calibration span has passed
+    if (a.ns == 0 || a.rate > 0) {
+      a.tsc = tsc;
+      a.ns = ns;
+      a.resync = a.rate > 0 ? static_cast<uint64_t>(TSC_RESYNC_NS / a.rate) : 0;
+    }
+  }
+
+  //the TSC estimate may be ahead of the anchor that replaces it
+  if (ns < a.last) {
+    ns = a.last;
+  }
+  a.last = ns;
+  return ns;
+}
+#endif
+
 uint32_t getHDTimer() {
   struct timespec t;
   t.tv_sec = t.tv_nsec = 0;
@@ -53,5 +151,22 @@ uint64_t getCurrentTime() {
          static_cast<uint64_t>(timeofday.tv_usec) * 1000LL;
 #endif
 }
+
+uint64_t getMonotonicTime() {
+#if HAS_TSC_CLOCK
+  if (use_tsc()) {
+    return tsc_ns();
+  }
+#endif
+  return clock_ns(CLOCK_MONOTONIC);
+}
+
+bool isTscClock() {
+#if HAS_TSC_CLOCK
+  return use_tsc();
+#else
+  return false;
+#endif
+}
 }
 #endif
@@ -43,7 +43,20 @@ void HPtimer_reset();
 #endif
 uint32_t getHDTimer();
 uint64_t getCurrentTime();
+/**
+ * @brief monotonic clock(ns), the epoch is arbitrary \n
+ * Read from the TSC where the kernel itself trusts it (invariant and
+ * synchronized across cores), kept on CLOCK_MONOTONIC by re-anchoring every
+ * thread once a second. CLOCK_MONOTONIC otherwise, QueryPerformanceCounter
+ * on Windows.
+ */
+uint64_t getMonotonicTime();
+/**
+ * @brief whether ::getMonotonicTime reads the TSC
+ */
+bool isTscClock();
 } // namespace impl
 
 #define getms() impl::getHDTimer()
 #define getTime() impl::getCurrentTime()
+#define getns() impl::getMonotonicTime()
@@ -0,0 +1,349 @@
+#include "AsyncLogger.h"
+#include <core/base/thread.h>
+#include <core/base/locker.h>
+#include <core/base/stop_token.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+namespace lidar {
+namespace core {
+namespace common {
+
+using namespace base;
+
+#if defined(_WIN32)
+#define LOG_COLOR(c) ""
+#else
+#define LOG_COLOR(c) c
+#endif
+
+static const char *const level_prefix[] = {
+    LOG_COLOR("\033[0;32m") "[LIDAR SDK] [DEBUG]> " LOG_COLOR("\033[0m"),
+    LOG_COLOR("\033[0;34m") "[LIDAR SDK] [INFOR]> " LOG_COLOR("\033[0m"),
+    LOG_COLOR("\033[0;33m") "[LIDAR SDK] [WARRING]> " LOG_COLOR("\033[0m"),
+    LOG_COLOR("\033[0;31m") "[LIDAR SDK] [ERROR]> " LOG_COLOR("\033[0m"),
+    LOG_COLOR("\033[0;35m") "[LIDAR SDK] [FALT]> " LOG_COLOR("\033[0m"),
+};
+
+/**
+ * @brief records of one thread, single producer and single consumer
+ */
+struct LogRing {
+    LogRing() : head(0), tail(0), dropped(0), orphaned(false) {
+        //fault the pages in now rather than in the middle of a LOG call
+        memset(slots, 0, sizeof(slots));
+    }
+
+    LogRecord slots[AsyncLogger::RING_SLOTS];
+    std::atomic<uint32_t> head;        ///< next slot the thread writes
+    std::atomic<uint32_t> tail;        ///< next slot the logger reads
+    std::atomic<uint32_t> dropped;     ///< records lost to a full ring
+    std::atomic<bool> orphaned;        ///< the thread has exited
+};
+
+/// ring of the calling thread, NULL until its first message
+static thread_local LogRing *t_ring = NULL;
+
+/**
+ * @brief the rings and the thread draining them
+ */
+class LogWriter {
+public:
+    LogWriter() : m_running(false) {
+        thread_attr attr("lidar-log");
+        m_running = true;
+        m_thread = CLASS_THREAD_ATTR(LogWriter, drainLoop, attr);
+        if (m_thread.getHandle() == 0) {
+            m_running = false;
+        }
+    }
+
+    /// the writer lives until exit, rings of exiting threads are freed by the loop
+    static LogWriter &instance() {
+        static LogWriter *writer = create();
+        return *writer;
+    }
+
+    LogRing *ring() {
+        if (!t_ring) {
+            t_ring = new LogRing();
+            ScopedLocker lock(m_RingLock);
+            m_rings.push_back(t_ring);
+            m_owner.ring = t_ring;
+        }
+        return t_ring;
+    }
+
+    bool running() const {
+        return m_running.load(std::memory_order_acquire);
+    }
+
+    void stop() {
+        m_running = false;
+        m_stop.requestStop();
+        m_thread.join();
+        drain();
+    }
+
+    /// format everything in the rings, oldest first
+    void drain() {
+        ScopedLocker lock(m_DrainLock);
+        std::vector<LogRing *> rings;
+        {
+            ScopedLocker l(m_RingLock);
+            rings = m_rings;
+        }
+
+        bool written = false;
+        while (true) {
+            LogRing *oldest = NULL;
+            uint64_t oldest_ns = 0;
+            for (size_t i = 0; i < rings.size(); i++) {
+                LogRing *ring = rings[i];
+                uint32_t tail = ring->tail.load(std::memory_order_relaxed);
+                if (tail == ring->head.load(std::memory_order_acquire)) {
+                    continue;
+                }
+                const LogRecord &r = ring->slots[tail % AsyncLogger::RING_SLOTS];
+                if (!oldest || r.ns < oldest_ns) {
+                    oldest = ring;
+                    oldest_ns = r.ns;
+                }
+            }
+            if (!oldest) {
+                break;
+            }
+            uint32_t tail = oldest->tail.load(std::memory_order_relaxed);
+            print(oldest->slots[tail % AsyncLogger::RING_SLOTS]);
+            oldest->tail.store(tail + 1, std::memory_order_release);
+            written = true;
+        }
+
+        for (size_t i = 0; i < rings.size(); i++) {
+            uint32_t dropped = rings[i]->dropped.exchange(0);
+            if (dropped) {
+                fprintf(stdout, "%s%u log messages dropped\n", level_prefix[LogWarn], dropped);
+                written = true;
+            }
+        }
+        if (written) {
+            fflush(stdout);
+        }
+        release(rings);
+    }
+
+    /// format one record into m_line and write it, m_DrainLock is held
+    void print(const LogRecord &r) {
+        format(r, m_line);
+        fwrite(m_line.data(), 1, m_line.size(), stdout);
+    }
+
+    static void format(const LogRecord &r, std::string &line);
+
+    Locker m_DrainLock;                ///< drain() and synchronous writes
+
+private:
+    /// marks the ring of an exiting thread
+    struct RingOwner {
+        LogRing *ring;
+        RingOwner() : ring(NULL) {}
+        ~RingOwner() {
+            if (ring) {
+                //a later message of this thread starts a new ring
+                t_ring = NULL;
+                ring->orphaned = true;
+            }
+        }
+    };
+
+    static LogWriter *create() {
+        LogWriter *writer = new LogWriter();
+        atexit(shutdown);
+        return writer;
+    }
+
+    /// whatever is logged after exit() is written synchronously
+    static void shutdown() {
+        instance().stop();
+    }
+
+    int drainLoop() {
+        while (m_stop.sleep(AsyncLogger::FLUSH_INTERVAL)) {
+            drain();
+        }
+        return 0;
+    }
+
+    /// free the drained rings of exited threads
+    void release(const std::vector<LogRing *> &rings) {
+        for (size_t i = 0; i < rings.size(); i++) {
+            LogRing *ring = rings[i];
+            if (!ring->orphaned.load(std::memory_order_acquire) ||
+                ring->tail.load() != ring->head.load()) {
+                continue;
+            }
+            ScopedLocker lock(m_RingLock);
+            for (size_t j = 0; j < m_rings.size(); j++) {
+                if (m_rings[j] == ring) {
+                    m_rings.erase(m_rings.begin() + j);
+                    break;
+                }
+            }
+            delete ring;
+        }
+    }
+
+    static thread_local RingOwner m_owner;
+
+    Thread m_thread;
+    StopToken m_stop;
+    std::atomic<bool> m_running;
+    Locker m_RingLock;                 ///< m_rings
+    std::vector<LogRing *> m_rings;
+    std::string m_line;
+};
+
+thread_local LogWriter::RingOwner LogWriter::m_owner;
+
+
+void LogWriter::format(const LogRecord &r, std::string &line) {
+    char buf[256];
+    const uint8_t *arg = r.args;
+    const uint8_t *end = r.args + r.size;
+    const char *p = r.site->format;
+    int level = r.site->level;
+
+    line = level_prefix[level < LogDebug ? LogDebug : (level > LogFatal ? LogFatal : level)];
+    while (*p) {
+        if (*p != '%') {
+            const char *next = strchr(p, '%');
+            size_t len = next ? (size_t)(next - p) : strlen(p);
+            line.append(p, len);
+            p += len;
+            continue;
+        }
+        if (p[1] == '%') {
+            line.push_back('%');
+            p += 2;
+            continue;
+        }
+
+        //one conversion: flags, width and precision are kept, the length
+        //modifier is replaced by the one of the stored argument
+        std::string fmt(1, *p++);
+        bool star = false;
+        while (*p && !strchr("diouxXeEfFgGaAcsp", *p)) {
+            if (strchr("-+ #0123456789.", *p)) {
+                fmt.push_back(*p);
+            } else if (*p == '*') {
+                star = true;
+            }
+            p++;
+        }
+        if (!*p) {
+            break;
+        }
+        char conv = *p++;
+        int n = -1;
+
+        if (arg < end && !star) {
+            uint8_t tag = *arg++;
+            if (tag == LogRecord::ARG_STRING) {
+                const char *s = reinterpret_cast<const char *>(arg);
+                arg += strlen(s) + 1;
+                if (conv == 's') {
+                    n = snprintf(buf, sizeof(buf), (fmt + conv).c_str(), s);
+                }
+            } else if (tag == LogRecord::ARG_INT32) {
+                int32_t v;
+                memcpy(&v, arg, sizeof(v));
+                arg += sizeof(v);
+                if (strchr("diouxXc", conv)) {
+                    n = snprintf(buf, sizeof(buf), (fmt + conv).c_str(), v);
+                }
+            } else if (tag == LogRecord::ARG_INT64) {
+                int64_t v;
+                memcpy(&v, arg, sizeof(v));
+                arg += sizeof(v);
+                if (strchr("diouxX", conv)) {
+                    n = snprintf(buf, sizeof(buf), (fmt + "ll" + conv).c_str(), (long long)v);
+                } else if (conv == 'p') {
+                    n = snprintf(buf, sizeof(buf), "%p", (void *)(intptr_t)v);
+                }
+            } else if (tag == LogRecord::ARG_DOUBLE) {
+                double v;
+                memcpy(&v, arg, sizeof(v));
+                arg += sizeof(v);
+                if (strchr("eEfFgGaA", conv)) {
+                    n = snprintf(buf, sizeof(buf), (fmt + conv).c_str(), v);
+                }
+            } else if (tag == LogRecord::ARG_POINTER) {
+                const void *v;
+                memcpy(&v, arg, sizeof(v));
+                arg += sizeof(v);
+                if (conv == 'p') {
+                    n = snprintf(buf, sizeof(buf), "%p", v);
+                }
+            } else {
+                arg = end;
+            }
+        }
+        if (n < 0) {
+            line.append("<?>");//missing or mismatched argument
+        } else {
+            line.append(buf, (size_t)n < sizeof(buf) ? n : sizeof(buf) - 1);
+        }
+    }
+
+    if (r.suppressed) {
+        snprintf(buf, sizeof(buf), " (%u similar messages suppressed)", r.suppressed);
+        line.append(buf);
+    }
+    line.push_back('\n');
+}
+
+
+LogRecord *AsyncLogger::claim() {
+    LogWriter &writer = LogWriter::instance();
+    if (!writer.running()) {
+        return NULL;
+    }
+    LogRing *ring = writer.ring();
+    uint32_t head = ring->head.load(std::memory_order_relaxed);
+    if (head - ring->tail.load(std::memory_order_acquire) >= RING_SLOTS) {
+        ring->dropped.fetch_add(1, std::memory_order_relaxed);
+        return NULL;
+    }
+    return &ring->slots[head % RING_SLOTS];
+}
+
+
+void AsyncLogger::commit() {
+    LogRing *ring = t_ring;
+    ring->head.store(ring->head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+
+bool AsyncLogger::synchronous() {
+    return !LogWriter::instance().running();
+}
+
+
+void AsyncLogger::write(const LogRecord &r) {
+    LogWriter &writer = LogWriter::instance();
+    std::string line;
+    LogWriter::format(r, line);
+    ScopedLocker lock(writer.m_DrainLock);
+    fwrite(line.data(), 1, line.size(), stdout);
+    fflush(stdout);
+}
+
+
+void AsyncLogger::flush() {
+    LogWriter::instance().drain();
+}
+
+}//common
+}//core
+}//lidar
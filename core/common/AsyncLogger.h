@@ -0,0 +1,241 @@
+#pragma once
+#include <core/base/v8stdint.h>
+#include <core/base/timer.h>
+#include <atomic>
+#include <string>
+#include <type_traits>
+#include <string.h>
+
+namespace lidar {
+namespace core {
+namespace common {
+
+/// severity of a log message
+enum LogLevel {
+    LogDebug = 0,
+    LogInfo = 1,
+    LogWarn = 2,
+    LogError = 3,
+    LogFatal = 4,
+};
+
+/**
+ * @brief State of one LOG call site, constant initialised \n
+ * At most LOG_RATE_BURST messages per LOG_RATE_WINDOW pass, the rest are
+ * counted and reported with the next message that passes.
+ */
+class LogSite {
+public:
+    enum {
+        LOG_RATE_BURST = 20,               ///< messages per window
+    };
+    static const uint64_t LOG_RATE_WINDOW = 1000000000ULL;///< ns
+
+    constexpr LogSite(int level, const char *format)
+        : level(level), format(format), m_window(0), m_count(0), m_suppressed(0) {
+    }
+
+    /**
+     * @brief rate limit
+     * @param now              getns()
+     * @param[out] suppressed  messages dropped since the last one that passed
+     * @return false if the message is dropped
+     */
+    bool admit(uint64_t now, uint32_t &suppressed) {
+        uint64_t window = m_window.load(std::memory_order_relaxed);
+        if (now - window >= LOG_RATE_WINDOW &&
+            m_window.compare_exchange_strong(window, now, std::memory_order_relaxed)) {
+            m_count.store(0, std::memory_order_relaxed);
+        }
+        if (m_count.fetch_add(1, std::memory_order_relaxed) < LOG_RATE_BURST) {
+            suppressed = m_suppressed.load(std::memory_order_relaxed) ?
+                         m_suppressed.exchange(0, std::memory_order_relaxed) : 0;
+            return true;
+        }
+        m_suppressed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    const int level;
+    const char *const format;          ///< printf format, a string literal
+
+private:
+    std::atomic<uint64_t> m_window;    ///< start of the current window(ns)
+    std::atomic<uint32_t> m_count;     ///< messages in the current window
+    std::atomic<uint32_t> m_suppressed;
+};
+
+/**
+ * @brief A message with its arguments, formatted later by the logger thread \n
+ * Numbers are kept by value, strings are copied, so nothing the caller
+ * owns is read after the LOG call returns.
+ */
+struct LogRecord {
+    enum {
+        RECORD_SIZE = 256,
+        ARG_INT32 = 1,
+        ARG_INT64,
+        ARG_DOUBLE,
+        ARG_POINTER,
+        ARG_STRING,                    ///< NUL terminated copy, cut at the end of the record
+    };
+
+    uint64_t ns;                       ///< getns() of the call
+    const LogSite *site;
+    uint32_t suppressed;               ///< messages of the site dropped before this one
+    uint16_t size;                     ///< bytes of args in use
+    uint8_t nargs;
+    uint8_t reserved;
+    uint8_t args[RECORD_SIZE - 24];    ///< tag byte, then the value
+
+    void put(uint8_t tag, const void *value, size_t len) {
+        if (size + 1 + len > sizeof(args)) {
+            size = sizeof(args);//the formatter stops at the cut
+            return;
+        }
+        args[size] = tag;
+        memcpy(args + size + 1, value, len);
+        size += 1 + len;
+        nargs++;
+    }
+
+    void putString(const char *s) {
+        if (!s) {
+            s = "(null)";
+        }
+        size_t room = (size_t)size + 2 < sizeof(args) ? sizeof(args) - (size_t)size - 2 : 0;
+        size_t len = strlen(s);
+        if (room == 0) {
+            size = sizeof(args);
+            return;
+        }
+        len = len < room ? len : room;
+        args[size] = ARG_STRING;
+        memcpy(args + size + 1, s, len);
+        args[size + 1 + len] = 0;
+        size += 2 + len;
+        nargs++;
+    }
+};
+
+template <typename T>
+inline typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type
+logArg(LogRecord &r, T v) {
+    if (sizeof(T) <= 4) {
+        int32_t i = (int32_t)v;
+        r.put(LogRecord::ARG_INT32, &i, sizeof(i));
+    } else {
+        int64_t i = (int64_t)v;
+        r.put(LogRecord::ARG_INT64, &i, sizeof(i));
+    }
+}
+
+inline void logArg(LogRecord &r, double v) {
+    r.put(LogRecord::ARG_DOUBLE, &v, sizeof(v));
+}
+
+inline void logArg(LogRecord &r, const char *s) {
+    r.putString(s);
+}
+
+inline void logArg(LogRecord &r, char *s) {
+    r.putString(s);
+}
+
+inline void logArg(LogRecord &r, const std::string &s) {
+    r.putString(s.c_str());
+}
+
+template <typename T>
+inline void logArg(LogRecord &r, T *p) {
+    const void *v = p;
+    r.put(LogRecord::ARG_POINTER, &v, sizeof(v));
+}
+
+inline void logArgs(LogRecord &) {
+}
+
+template <typename T, typename... Rest>
+inline void logArgs(LogRecord &r, const T &first, const Rest &... rest) {
+    logArg(r, first);
+    logArgs(r, rest...);
+}
+
+/**
+ * @brief Asynchronous logger behind the LOG macros \n
+ * Every thread writes its records into its own lock-free ring, a LOG call
+ * costs a rate check, a clock read and a copy of the arguments. The logger
+ * thread formats the rings in time order and writes them to stdout every
+ * FLUSH_INTERVAL. A full ring drops the record and counts it, the caller
+ * never waits for stdout.
+ */
+class AsyncLogger {
+public:
+    enum {
+        RING_SLOTS = 256,              ///< records per thread
+        FLUSH_INTERVAL = 10,           ///< ms
+    };
+
+    /**
+     * @brief log a message, the entry point of the LOG macros
+     */
+    template <typename... Args>
+    static void log(LogSite &site, const Args &... args) {
+        uint64_t now = getns();
+        uint32_t suppressed = 0;
+        if (!site.admit(now, suppressed)) {
+            return;
+        }
+        LogRecord *r = claim();
+        LogRecord local;
+        bool sync = r == NULL;
+        if (sync) {
+            if (!synchronous()) {
+                return;//ring full, counted by ::claim
+            }
+            r = &local;
+        }
+        r->ns = now;
+        r->site = &site;
+        r->suppressed = suppressed;
+        r->size = 0;
+        r->nargs = 0;
+        logArgs(*r, args...);
+        if (sync) {
+            write(local);
+        } else {
+            commit();
+        }
+    }
+
+    /**
+     * @brief write out everything logged so far
+     */
+    static void flush();
+
+private:
+    /// free slot of the calling thread's ring, NULL if full or not running
+    static LogRecord *claim();
+    /// publish the claimed slot
+    static void commit();
+    /// true if records are written in the calling thread (logger stopped)
+    static bool synchronous();
+    /// format and write one record in the calling thread
+    static void write(const LogRecord &r);
+};
+
+}//common
+}//core
+}//lidar
+
+/// messages below this level are compiled out
+#ifndef LIDAR_LOG_LEVEL
+#define LIDAR_LOG_LEVEL 0
+#endif
+
+#define LIDAR_LOG(level, format, ...)  do { \
+        if ((level) >= LIDAR_LOG_LEVEL) { \
+            static lidar::core::common::LogSite _lidar_log_site((level), format); \
+            lidar::core::common::AsyncLogger::log(_lidar_log_site, ##__VA_ARGS__); \
+        } \
+    } while (0)
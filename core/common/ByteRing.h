@@ -0,0 +1,105 @@
+#pragma once
+#include <core/base/v8stdint.h>
+#include <vector>
+#include <atomic>
+
+namespace lidar {
+namespace core {
+namespace common {
+
+/**
+ * @brief Lock-free byte ring for one producer and one consumer thread \n
+ * Both sides work on contiguous regions of the ring: the producer receives
+ * straight into ::writeRegion, the consumer parses ::readRegion in place,
+ * no byte is copied in between.
+ */
+class ByteRing {
+public:
+    /**
+     * @param capacity  ring size, rounded up to a power of two
+     */
+    explicit ByteRing(size_t capacity) {
+        size_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        m_buffer.resize(size);
+        m_mask = size - 1;
+        m_head = 0;
+        m_tail = 0;
+    }
+
+    /**
+     * @brief drop all bytes, neither side may be active
+     */
+    void reset() {
+        m_head = 0;
+        m_tail = 0;
+    }
+
+    /**
+     * @brief bytes waiting for the consumer
+     */
+    size_t size() const {
+        return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const {
+        return m_buffer.size();
+    }
+
+    /**
+     * @brief producer: contiguous free space
+     * @param[out] size  free bytes at the returned pointer, 0 if the ring is full
+     */
+    uint8_t *writeRegion(size_t &size) {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        size_t tail = m_tail.load(std::memory_order_acquire);
+        size_t offset = head & m_mask;
+        size = m_buffer.size() - (head - tail);
+        if (size > m_buffer.size() - offset) {
+            size = m_buffer.size() - offset;
+        }
+        return &m_buffer[offset];
+    }
+
+    /**
+     * @brief producer: publish bytes written to ::writeRegion
+     */
+    void commit(size_t size) {
+        m_head.store(m_head.load(std::memory_order_relaxed) + size, std::memory_order_release);
+    }
+
+    /**
+     * @brief consumer: contiguous pending bytes
+     * @param[out] size  bytes at the returned pointer, 0 if the ring is empty
+     */
+    const uint8_t *readRegion(size_t &size) {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        size_t head = m_head.load(std::memory_order_acquire);
+        size_t offset = tail & m_mask;
+        size = head - tail;
+        if (size > m_buffer.size() - offset) {
+            size = m_buffer.size() - offset;
+        }
+        return &m_buffer[offset];
+    }
+
+    /**
+     * @brief consumer: hand bytes of ::readRegion back to the producer
+     */
+    void release(size_t size) {
+        m_tail.store(m_tail.load(std::memory_order_relaxed) + size, std::memory_order_release);
+    }
+
+private:
+    std::vector<uint8_t> m_buffer;
+    size_t m_mask;
+    std::atomic<size_t> m_head;       ///< total bytes committed, written by the producer only
+    char m_pad[64];                   ///< keeps the two indices on separate cache lines
+    std::atomic<size_t> m_tail;       ///< total bytes released, written by the consumer only
+};
+
+}//common
+}//core
+}//lidar
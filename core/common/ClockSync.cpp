@@ -0,0 +1,144 @@
+#include "ClockSync.h"
+#include <string.h>
+
+namespace lidar {
+namespace core {
+namespace common {
+
+using namespace base;
+
+static const uint64_t WINDOW_NS = ClockSync::WINDOW_MS * 1000000ULL;
+static const int64_t RESYNC_NS = ClockSync::RESYNC_MS * 1000000LL;
+
+
+ClockSync::ClockSync() {
+    reset();
+}
+
+
+void ClockSync::reset() {
+    memset(m_points, 0, sizeof(m_points));
+    memset(&m_min, 0, sizeof(m_min));
+    memset(&m_fit, 0, sizeof(m_fit));
+    m_count = 0;
+    m_next = 0;
+    m_windowStart = 0;
+    m_lastDevice = 0;
+    publish();
+}
+
+
+void ClockSync::sample(uint64_t device, uint64_t host) {
+    int64_t delay = (int64_t)(host - device);
+    if (m_fit.samples) {
+        //no delay is below the line, unless a clock jumped
+        int64_t below = (int64_t)(toHost(m_fit, device) - host);
+        bool jumped = device < m_lastDevice || below > RESYNC_NS;
+        if (!jumped && device - m_windowStart >= WINDOW_NS) {
+            jumped = !closeWindow();
+            m_windowStart = 0;
+        }
+        if (jumped) {
+            uint32_t resyncs = m_fit.resyncs + 1;
+            reset();
+            m_fit.resyncs = resyncs;
+        }
+    }
+    m_lastDevice = device;
+    m_fit.samples++;
+
+    bool lower = m_windowStart == 0 || delay < m_min.delay;
+    if (m_windowStart == 0) {
+        m_windowStart = device;
+    }
+    if (lower) {
+        m_min.device = device;
+        m_min.delay = delay;
+    }
+    //until the first window closes the smallest delay so far is the estimate
+    if (m_fit.windows == 0 && lower) {
+        m_fit.reference = m_min.device;
+        m_fit.offset = m_min.delay;
+        publish();
+    }
+}
+
+
+bool ClockSync::closeWindow() {
+    if (m_fit.windows) {
+        //a whole window late, the clocks moved apart
+        int64_t line = (int64_t)(toHost(m_fit, m_min.device) - m_min.device);
+        if (m_min.delay - line > RESYNC_NS) {
+            return false;
+        }
+    }
+    m_points[m_next] = m_min;
+    m_next = (m_next + 1) % WINDOWS;
+    if (m_count < WINDOWS) {
+        m_count++;
+    }
+    fit();
+    publish();
+    return true;
+}
+
+
+void ClockSync::fit() {
+    //relative to the newest minimum, the doubles keep the nanoseconds
+    const Point &last = m_points[(m_next + WINDOWS - 1) % WINDOWS];
+    double t[WINDOWS];
+    double y[WINDOWS];
+    double mean_t = 0;
+    double mean_y = 0;
+    for (uint32_t i = 0; i < m_count; i++) {
+        const Point &p = m_points[(m_next + WINDOWS - m_count + i) % WINDOWS];
+        t[i] = (double)(int64_t)(p.device - last.device);
+        y[i] = (double)(p.delay - last.delay);
+        mean_t += t[i];
+        mean_y += y[i];
+    }
+    mean_t /= m_count;
+    mean_y /= m_count;
+
+    double skew = 0;
+    if (m_count >= MIN_WINDOWS) {
+        double sxx = 0;
+        double sxy = 0;
+        for (uint32_t i = 0; i < m_count; i++) {
+            sxx += (t[i] - mean_t) * (t[i] - mean_t);
+            sxy += (t[i] - mean_t) * (y[i] - mean_y);
+        }
+        skew = sxx > 0 ? sxy / sxx : 0;
+    }
+
+    //the least squares slope, lowered under every minimum
+    double low = y[0] - skew * t[0];
+    double high = low;
+    for (uint32_t i = 1; i < m_count; i++) {
+        double r = y[i] - skew * t[i];
+        low = r < low ? r : low;
+        high = r > high ? r : high;
+    }
+    m_fit.reference = last.device;
+    m_fit.offset = last.delay + (int64_t)low;
+    m_fit.skew = skew;
+    m_fit.error = (uint64_t)(high - low);
+    m_fit.windows = m_count;
+    m_fit.synchronized = m_count >= MIN_WINDOWS;
+}
+
+
+void ClockSync::publish() {
+    ScopedLocker l(m_Lock);
+    m_state = m_fit;
+}
+
+
+ClockSyncState ClockSync::state() const {
+    ScopedLocker l(m_Lock);
+    return m_state;
+}
+
+}//common
+}//core
+}//lidar
@@ -0,0 +1,86 @@
+#pragma once
+#include <core/base/v8stdint.h>
+#include <core/base/locker.h>
+#include "lidar_def.h"
+
+namespace lidar {
+namespace core {
+namespace common {
+
+/**
+ * @brief Online estimate of the lidar clock in host time \n
+ * Every packet gives a receive delay, host receive time - device stamp:
+ * the clock offset plus the network and scheduling jitter, which is never
+ * negative. The smallest delay of each WINDOW of device time filters the
+ * jitter, a line fitted through the last WINDOWS minima and lowered under
+ * all of them gives offset and skew. A sample outside the line by more than
+ * RESYNC restarts the estimate, e.g. after a lidar reboot or a host clock step.
+ * ::sample is owned by one thread, ::state may be called from any thread.
+ */
+class ClockSync {
+public:
+    enum {
+        WINDOW_MS = 1000,             ///< device time of a minimum delay window
+        WINDOWS = 32,                 ///< windows in the fit
+        MIN_WINDOWS = 4,              ///< windows before the skew is estimated
+        RESYNC_MS = 1000,             ///< clock jump that restarts the estimate
+    };
+
+    ClockSync();
+
+    /**
+     * @brief forget every sample, owner thread only
+     */
+    void reset();
+
+    /**
+     * @brief account a packet, owner thread only
+     * @param device  device stamp of the packet(ns)
+     * @param host    receive time of the packet, getTime() domain(ns)
+     */
+    void sample(uint64_t device, uint64_t host);
+
+    /**
+     * @brief the current estimate, any thread
+     */
+    ClockSyncState state() const;
+
+    /**
+     * @brief map a device stamp to host time
+     * @param state   estimate, samples must not be 0
+     * @param device  device stamp(ns)
+     */
+    static uint64_t toHost(const ClockSyncState &state, uint64_t device) {
+        double drift = state.skew * (double)(int64_t)(device - state.reference);
+        return device + state.offset + (int64_t)drift;
+    }
+
+private:
+    ClockSync(const ClockSync &);
+    ClockSync &operator=(const ClockSync &);
+
+    /// minimum receive delay of a window
+    struct Point {
+        uint64_t device;
+        int64_t delay;
+    };
+
+    /// close the current window, false if its minimum left the line
+    bool closeWindow();
+    void fit();
+    void publish();
+
+    Point m_points[WINDOWS];          ///< minima of the last windows, ring
+    uint32_t m_count;                 ///< minima in m_points
+    uint32_t m_next;                  ///< slot of the next minimum
+    Point m_min;                      ///< smallest delay of the current window
+    uint64_t m_windowStart;           ///< device stamp opening the current window, 0 if none
+    uint64_t m_lastDevice;
+    ClockSyncState m_fit;             ///< owner thread only
+    mutable base::Locker m_Lock;      ///< m_state
+    ClockSyncState m_state;
+};
+
+}//common
+}//core
+}//lidar
@@ -2,10 +2,17 @@
 #include <core/base/v8stdint.h>
 #include <core/base/thread.h>
 #include <core/base/locker.h>
+#include <core/base/stop_token.h>
+#include <core/base/timer.h>
 #include <map>
 #include "lidar_def.h"
 #include "lidar_datatype.h"
 #include "lidar_config.h"
+#include "LivenessMonitor.h"
+#include "DriverStateMachine.h"
+#include "ScanAssembler.h"
+#include "MetricsRegistry.h"
+#include "ClockSync.h"
 
 namespace lidar {
 namespace core {
@@ -28,24 +35,137 @@ public:
     enum {
         DEFAULT_TIMEOUT = 2000,    /**< Default timeout. */
         DEFAULT_HEART_BEAT = 1000, /**< Default heartbeat timeout. */
-        MAX_SCAN_NODES = 7200,	   /**< Default Max Scan Count. */
+        MAX_SCAN_NODES = 7200,	   /**< Scan buffer size while the sample rate or scan frequency is unknown. */
         DEFAULT_TIMEOUT_COUNT = 1, /**< Default Timeout Count. */
+        DEFAULT_RECONNECT_MIN_DELAY = 50,   /**< First reconnect backoff(ms). */
+        DEFAULT_RECONNECT_MAX_DELAY = 2000, /**< Maximum reconnect backoff(ms). */
+        DEFAULT_DATA_PORT = 8000,  /**< Local UDP port of the data stream. */
     };
 
 protected:
     node_info *m_ScanNodeBuf;
+    size_t m_ScanNodeSize;            ///< points m_ScanNodeBuf holds
     size_t m_ScanNodeCount;
     DriverError m_DriverErrno;
     Thread m_Thread;
+    StopToken m_StopToken;            ///< stops and wakes the threads of a scan
     Event m_DataEvent;
     Locker m_Lock;
     Locker m_CmdLock;
     Locker m_DataLock;
     Locker m_ErrorLock;
-    PropertyBuilderByName(bool, IsScanning, protected);
-    PropertyBuilderByName(bool, IsConnected, protected);
+    startup_timing m_StartupTiming;   ///< ingest thread writes under m_Lock, see ::markStartup
+    LivenessMonitor m_Liveness;
+    DriverStateMachine m_State;
+    MetricsRegistry m_Metrics;        ///< written by the ingest threads only
+    ClockSync m_Clock;                ///< device clock in host time, sampled by the ingest threads only
+    ScanTimeline m_Building;          ///< revolution being assembled, ingest thread only
+    ScanTimeline m_ScanTimeline;      ///< revolution in m_ScanNodeBuf, under m_Lock
+    ScanTimeline m_GrabbedTimeline;   ///< last grabbed revolution, consumer thread only
+    ScanStats m_ScanStats;            ///< revolution in m_ScanNodeBuf, under m_Lock
+    ScanStats m_GrabbedStats;         ///< last grabbed revolution, consumer thread only
     PropertyBuilderByName(bool, IsAutoReconnect, protected);
-    PropertyBuilderByName(bool, IsAutoconnting, protected);
+    PropertyBuilderByName(uint32_t, DataPort, protected);
+    PropertyBuilderByName(uint32_t, ScanCapacity, protected);///< points a revolution may hold, see ScanAssembler::capacity
+    PropertyBuilderByName(uint32_t, ScanSpacing, protected);///< expected point spacing(0.01 degree), 0 if unknown, see ScanAssembler::spacing
+    PropertyBuilderByName(uint32_t, FieldOfView, protected);///< angle the lidar measures(0.01 degree)
+    PropertyBuilderByName(thread_attr, ThreadAttr, protected);///< ingest thread cpus, policy and stack
+
+    /**
+     * @brief Attributes of an ingest thread, ::setThreadAttr under its own name
+     * @param name  thread name
+     */
+    thread_attr ingestAttr(const char *name) const {
+        thread_attr attr = m_ThreadAttr;
+        attr.name = name;
+        return attr;
+    }
+
+    /**
+     * @brief Size m_ScanNodeBuf for ::getScanCapacity points, at the start of an ingest thread
+     */
+    void allocScanBuffer() {
+        ScopedLocker l(m_Lock);
+        if (m_ScanNodeBuf && m_ScanNodeSize == m_ScanCapacity) {
+            return;
+        }
+        delete[] m_ScanNodeBuf;
+        m_ScanNodeBuf = new node_info[m_ScanCapacity];
+        m_ScanNodeSize = m_ScanCapacity;
+        m_ScanNodeCount = 0;
+    }
+
+    /**
+     * @brief Hand a completed revolution over to ::grabScanData
+     * @param scan   revolution
+     * @param count  point count, at most ::getScanCapacity
+     * @param stats  speed and coverage of the revolution, see ScanAssembler
+     */
+    void publishScan(const node_info *scan, size_t count, const ScanStats &stats) {
+        m_Building.stamp[TraceAssembled] = getns();
+        m_Metrics.onScan(stats);
+        {
+            ScopedLocker l(m_Lock);//timeout lock, wait resource copy
+            m_Metrics.scans.add();
+            if (m_ScanNodeCount) {
+                m_Metrics.scans_overwritten.add();
+            }
+            memcpy(m_ScanNodeBuf, scan, count * sizeof(node_info));
+            m_ScanNodeCount = count;
+            m_Building.scan = m_Metrics.scans.value();
+            m_Building.stamp[TracePublished] = getns();
+            m_ScanTimeline = m_Building;
+            m_ScanStats = stats;
+            m_DataEvent.set();
+        }
+        //the packet completing this revolution starts the next one
+        uint64_t received = m_Building.stamp[TraceLastReceive];
+        traceReset();
+        m_Building.stamp[TraceFirstReceive] = received;
+    }
+
+    /**
+     * @brief Record a bring-up step of the ingest thread once, under m_Lock for ::getStartupTiming
+     * @param step  first_packet or first_scan of m_StartupTiming
+     * @return true if the step was reached just now
+     */
+    bool markStartup(uint32_t &step) {
+        if (step != 0) {
+            return false;//the ingest thread is the only writer
+        }
+        ScopedLocker l(m_Lock);
+        step = getms();
+        return true;
+    }
+
+    /**
+     * @brief Account a packet before its points are assembled, ingest thread only
+     * @param received  kernel receive time, getns() domain
+     * @param decoded   getns() once the packet is decoded
+     */
+    void tracePacket(uint64_t received, uint64_t decoded) {
+        if (m_Building.stamp[TraceFirstReceive] == 0) {
+            m_Building.stamp[TraceFirstReceive] = received;
+        }
+        m_Building.stamp[TraceLastReceive] = received;
+        m_Building.stamp[TraceDecoded] = decoded;
+    }
+
+    /**
+     * @brief Drop the timeline being built, at the start of an ingest thread
+     */
+    void traceReset() {
+        memset(&m_Building, 0, sizeof(m_Building));
+    }
+
+    /**
+     * @brief Take the timeline and statistics of the revolution being grabbed, m_Lock is held
+     */
+    void traceGrab() {
+        m_GrabbedStats = m_ScanStats;
+        m_GrabbedTimeline = m_ScanTimeline;
+        m_GrabbedTimeline.stamp[TraceGrabbed] = getns();
+    }
 
 public:
     /**
@@ -53,13 +173,21 @@ public:
      *
      */
     DriverInterface(){
-        node_info *m_ScanNodeBuf = NULL; 
-        size_t m_ScanNodeCount = 0;
-        DriverError m_DriverErrno = NoError;
-        setIsScanning(false);
-        setIsConnected(false);
+        m_ScanNodeBuf = NULL;
+        m_ScanNodeSize = 0;
+        m_ScanNodeCount = 0;
+        m_DriverErrno = NoError;
+        memset(&m_StartupTiming, 0, sizeof(m_StartupTiming));
+        memset(&m_Building, 0, sizeof(m_Building));
+        memset(&m_ScanTimeline, 0, sizeof(m_ScanTimeline));
+        memset(&m_GrabbedTimeline, 0, sizeof(m_GrabbedTimeline));
+        memset(&m_ScanStats, 0, sizeof(m_ScanStats));
+        memset(&m_GrabbedStats, 0, sizeof(m_GrabbedStats));
         setIsAutoReconnect(true);
-        setIsAutoconnting(false);
+        setDataPort(DEFAULT_DATA_PORT);
+        setScanCapacity(MAX_SCAN_NODES);
+        setScanSpacing(0);
+        setFieldOfView(ScanAssembler::FULL_CIRCLE);
     }
 
     /**
@@ -170,6 +298,23 @@ public:
      */
     virtual std::map<std::string, std::string> lidarPortList() = 0;
     
+    /**
+     * @brief Start recording the raw data of the lidar
+     * @param path  capture file
+     * @return result status
+     * @retval RESULT_OK       success
+     * @retval RESULT_FAILE    failed or not supported
+     */
+    virtual result_t startRecord(const char *path) {
+        UNUSED(path);
+        return RESULT_FAIL;
+    }
+
+    /**
+     * @brief Stop recording
+     */
+    virtual void stopRecord() {}
+
     /**
      * @brief Get SDK Version \n
      * static function
@@ -179,6 +324,137 @@ public:
         return LIDAR_SDK_VERSION_STR;
     }
 
+    /**
+     * @brief Get the bring-up timeline of the last connect and start scan
+     * @return startup timing, getms() ticks of each step
+     */
+    virtual startup_timing getStartupTiming() {
+        ScopedLocker l(m_Lock);
+        return m_StartupTiming;
+    }
+
+    /**
+     * @brief Get the ingest pipeline metrics
+     * @return totals since the driver was created
+     */
+    virtual LidarMetrics getMetrics() {
+        LidarMetrics metrics;
+        m_Metrics.snapshot(metrics, getns());
+        return metrics;
+    }
+
+    /**
+     * @brief Get the timeline of the revolution returned by the last ::grabScanData
+     * @note call it from the thread calling ::grabScanData
+     */
+    virtual ScanTimeline getScanTimeline() {
+        return m_GrabbedTimeline;
+    }
+
+    /**
+     * @brief Get the measured speed and coverage of the revolution returned by the last ::grabScanData
+     * @note call it from the thread calling ::grabScanData
+     */
+    virtual ScanStats getScanStats() {
+        return m_GrabbedStats;
+    }
+
+    /**
+     * @brief Get the relation of the lidar clock to the host clock
+     * @return estimate from the packets received so far, see ClockSync
+     */
+    virtual ClockSyncState getClockSync() {
+        return m_Clock.state();
+    }
+
+    /**
+     * @brief Set link liveness thresholds \n
+     * A heartbeat_interval other than 0 enables the control channel heartbeat.
+     * @param config  thresholds, unit: ms
+     * @note takes effect at the next ::startScan
+     */
+    virtual void setLivenessConfig(const liveness_config &config) {
+        m_Liveness.setConfig(config);
+    }
+
+    /**
+     * @brief Set the link state transition callback
+     * @param callback  callback, NULL to disable
+     * @param user      user data passed to the callback
+     */
+    virtual void setLinkStateCallback(LinkStateCallback callback, void *user) {
+        m_Liveness.setCallback(callback, user);
+    }
+
+    /**
+     * @brief Get the link liveness state
+     * @return link state
+     */
+    virtual LinkState getLinkState() {
+        return m_Liveness.getState();
+    }
+
+    /**
+     * @brief Get the driver lifecycle state
+     * @return driver state
+     */
+    virtual DriverState getDriverState() {
+        return m_State.getState();
+    }
+
+    /**
+     * @brief Set the driver state transition callback
+     * @param callback  callback, NULL to disable
+     * @param user      user data passed to the callback
+     */
+    virtual void setDriverStateCallback(DriverStateCallback callback, void *user) {
+        m_State.setCallback(callback, user);
+    }
+
+    /**
+     * @brief Wait until the driver enters one of the given states
+     * @param states   DriverStateMachine::mask of the expected states
+     * @param timeout  timeout(ms)
+     * @retval true   the driver is in one of the states
+     * @retval false  timeout or cancelled by ::cancelStateWait
+     */
+    virtual bool waitForState(uint32_t states, uint32_t timeout = DEFAULT_TIMEOUT) {
+        return m_State.wait(states, timeout);
+    }
+
+    /**
+     * @brief Wake up all pending ::waitForState calls
+     */
+    virtual void cancelStateWait() {
+        m_State.cancel();
+    }
+
+    /**
+     * @brief Whether the command and data ports are open
+     * @return true if connected
+     */
+    bool getIsConnected() const {
+        return !m_State.in(DriverStateMachine::mask(DriverStateDisconnected) |
+                           DriverStateMachine::mask(DriverStateConnecting));
+    }
+
+    /**
+     * @brief Whether a scan is active, reconnecting included
+     * @return true if scanning
+     */
+    bool getIsScanning() const {
+        return m_State.in(DriverStateMachine::mask(DriverStateScanning) |
+                          DriverStateMachine::mask(DriverStateReconnecting));
+    }
+
+    /**
+     * @brief Whether the link is being restored
+     * @return true if reconnecting
+     */
+    bool getIsAutoconnting() const {
+        return m_State.in(DriverStateMachine::mask(DriverStateReconnecting));
+    }
+
     /**
      * @brief Set driver error code
      * @param er
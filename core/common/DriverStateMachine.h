@@ -0,0 +1,154 @@
+#pragma once
+#include <core/base/v8stdint.h>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <deque>
+#include "lidar_def.h"
+
+namespace lidar {
+namespace core {
+namespace common {
+
+/**
+ * @brief Driver lifecycle state machine \n
+ * Holds the single DriverState of a driver. Transitions are serialized and
+ * reported in order through a callback, waiters are woken by a condition
+ * variable instead of polling flags. The callback runs without any lock held,
+ * it may read the state or cause another transition.
+ */
+class DriverStateMachine {
+public:
+    DriverStateMachine()
+        : m_state(DriverStateDisconnected)
+        , m_generation(0)
+        , m_delivering(false)
+        , m_callback(NULL)
+        , m_user(NULL) {
+    }
+
+    /**
+     * @brief state bit used by the masks of ::transition and ::wait
+     * @param state  driver state
+     * @return state mask
+     */
+    static uint32_t mask(DriverState state) {
+        return 1u << state;
+    }
+
+    /**
+     * @brief set the state transition callback
+     * @param callback  callback, NULL to disable
+     * @param user      user data passed to the callback
+     */
+    void setCallback(DriverStateCallback callback, void *user) {
+        std::lock_guard<std::mutex> l(m_Lock);
+        m_callback = callback;
+        m_user = user;
+    }
+
+    /**
+     * @brief get current state
+     * @return driver state
+     */
+    DriverState getState() const {
+        std::lock_guard<std::mutex> l(m_Lock);
+        return m_state;
+    }
+
+    /**
+     * @brief check whether the current state is one of a set
+     * @param states  state mask
+     * @return true if the current state is in the mask
+     */
+    bool in(uint32_t states) const {
+        return (mask(getState()) & states) != 0;
+    }
+
+    /**
+     * @brief unconditional transition
+     * @param state  new state
+     * @return true if the state changed
+     */
+    bool transition(DriverState state) {
+        return transition(0xFFFFFFFFu, state);
+    }
+
+    /**
+     * @brief conditional transition
+     * @param from   states the transition is allowed from
+     * @param state  new state
+     * @return true if the state changed, false if the current state is not in from
+     */
+    bool transition(uint32_t from, DriverState state) {
+        std::unique_lock<std::mutex> l(m_Lock);
+        DriverState previous = m_state;
+        if (!(mask(previous) & from) || previous == state) {
+            return false;
+        }
+        m_state = state;
+        m_Cond.notify_all();
+        m_events.push_back(Event(state, previous));
+
+        //one caller delivers the queue in transition order, others only enqueue
+        if (m_delivering) {
+            return true;
+        }
+        m_delivering = true;
+        while (!m_events.empty()) {
+            Event event = m_events.front();
+            m_events.pop_front();
+            DriverStateCallback callback = m_callback;
+            void *user = m_user;
+            l.unlock();
+            if (callback) {
+                callback(event.first, event.second, user);
+            }
+            l.lock();
+        }
+        m_delivering = false;
+        return true;
+    }
+
+    /**
+     * @brief wait until the state is one of a set
+     * @param states   state mask
+     * @param timeout  timeout(ms)
+     * @retval true   the state is in the mask
+     * @retval false  timeout or the wait was cancelled by ::cancel
+     */
+    bool wait(uint32_t states, uint32_t timeout) {
+        std::unique_lock<std::mutex> l(m_Lock);
+        uint32_t generation = m_generation;
+        m_Cond.wait_for(l, std::chrono::milliseconds(timeout), [&] {
+            return (mask(m_state) & states) || generation != m_generation;
+        });
+        return (mask(m_state) & states) && generation == m_generation;
+    }
+
+    /**
+     * @brief wake up all pending ::wait calls, they return false
+     */
+    void cancel() {
+        std::lock_guard<std::mutex> l(m_Lock);
+        m_generation++;
+        m_Cond.notify_all();
+    }
+
+protected:
+    /// (state, previous) of a transition not yet reported
+    typedef std::pair<DriverState, DriverState> Event;
+
+    DriverState m_state;
+    uint32_t m_generation;          ///< bumped by ::cancel
+    std::deque<Event> m_events;     ///< transitions waiting for the callback
+    bool m_delivering;              ///< a caller is draining m_events
+    DriverStateCallback m_callback;
+    void *m_user;
+    mutable std::mutex m_Lock;
+    std::condition_variable m_Cond;
+};
+
+}//common
+}//core
+}//lidar
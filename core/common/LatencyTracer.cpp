@@ -0,0 +1,156 @@
+#include "LatencyTracer.h"
+#include <core/base/timer.h>
+#include <stdio.h>
+
+namespace lidar {
+namespace core {
+namespace common {
+
+using namespace base;
+
+/// name of the transition from stage i to stage i + 1
+static const char *const transition_name[TraceStageCount - 1] = {
+    "network",      //first to last packet of the revolution
+    "decode",       //kernel receive to decoded
+    "assemble",
+    "publish",      //m_Lock of the producer
+    "handoff",      //wait of the consumer and m_Lock
+    "convert",      //doProcessSimple
+};
+
+
+void LatencyHistogram::percentiles(LatencyPercentiles &p) const {
+    static const double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+    uint64_t *out[] = {&p.p50, &p.p90, &p.p99, &p.p999};
+    memset(&p, 0, sizeof(p));
+    p.count = m_count.value();
+    p.max = m_max.value();
+    if (p.count == 0) {
+        return;
+    }
+
+    uint64_t seen = 0;
+    size_t q = 0;
+    for (int i = 0; i < BUCKETS && q < sizeof(quantiles) / sizeof(quantiles[0]); i++) {
+        seen += m_buckets[i].value();
+        //the buckets are read one by one while the owner records, stop at the count
+        while (q < sizeof(quantiles) / sizeof(quantiles[0]) &&
+               (seen >= quantiles[q] * p.count || seen >= p.count)) {
+            uint64_t bound = upperBound(i);
+            *out[q++] = bound < p.max ? bound : p.max;
+        }
+    }
+    while (q < sizeof(quantiles) / sizeof(quantiles[0])) {
+        *out[q++] = p.max;
+    }
+}
+
+
+LatencyTracer::LatencyTracer() : m_ring(TRACE_CAPACITY), m_next(0) {
+}
+
+
+void LatencyTracer::record(const ScanTimeline &timeline) {
+    const uint64_t *stamp = timeline.stamp;
+    for (int i = 0; i + 1 < TraceStageCount; i++) {
+        if (stamp[i] && stamp[i + 1] >= stamp[i]) {
+            m_stages[i].record(stamp[i + 1] - stamp[i]);
+        }
+    }
+    if (stamp[TraceLastReceive] && stamp[TraceConverted] >= stamp[TraceLastReceive]) {
+        m_total.record(stamp[TraceConverted] - stamp[TraceLastReceive]);
+    }
+
+    ScopedLocker l(m_Lock);
+    m_ring[m_next % TRACE_CAPACITY] = timeline;
+    m_next++;
+}
+
+
+void LatencyTracer::latency(ScanLatency &latency) const {
+    for (int i = 0; i + 1 < TraceStageCount; i++) {
+        m_stages[i].percentiles(latency.stage[i]);
+    }
+    m_total.percentiles(latency.total);
+}
+
+
+ScanTimeline LatencyTracer::last() const {
+    ScanTimeline timeline;
+    memset(&timeline, 0, sizeof(timeline));
+    ScopedLocker l(m_Lock);
+    if (m_next) {
+        timeline = m_ring[(m_next - 1) % TRACE_CAPACITY];
+    }
+    return timeline;
+}
+
+
+bool LatencyTracer::writeTrace(const std::string &path, const std::string &label) const {
+    std::vector<ScanTimeline> timelines;
+    {
+        ScopedLocker l(m_Lock);
+        uint64_t count = m_next < TRACE_CAPACITY ? m_next : (uint64_t)TRACE_CAPACITY;
+        timelines.reserve(count);
+        for (uint64_t i = m_next - count; i < m_next; i++) {
+            timelines.push_back(m_ring[i % TRACE_CAPACITY]);
+        }
+    }
+
+    std::string json;
+    formatTrace(timelines, label, json);
+    FILE *fp = fopen(path.c_str(), "wb");
+    if (!fp) {
+        return false;
+    }
+    bool ok = fwrite(json.data(), 1, json.size(), fp) == json.size();
+    return fclose(fp) == 0 && ok;
+}
+
+
+void LatencyTracer::formatTrace(const std::vector<ScanTimeline> &timelines, const std::string &label,
+                                std::string &out) {
+    char buf[256];
+    std::string name;
+    for (size_t i = 0; i < label.size(); i++) {
+        if (label[i] == '"' || label[i] == '\\') {
+            name.push_back('\\');
+            name.push_back(label[i]);
+        } else if ((unsigned char)label[i] >= 0x20) {
+            name.push_back(label[i]);
+        }
+    }
+
+    out.append("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    out.append("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"").append(name).append("\"}}");
+    //one track per transition, in pipeline order
+    for (int i = 0; i + 1 < TraceStageCount; i++) {
+        snprintf(buf, sizeof(buf), ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+                 "\"args\":{\"name\":\"%s\"}}", i + 1, transition_name[i]);
+        out.append(buf);
+        snprintf(buf, sizeof(buf), ",\n{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+                 "\"args\":{\"sort_index\":%d}}", i + 1, i + 1);
+        out.append(buf);
+    }
+
+    for (size_t n = 0; n < timelines.size(); n++) {
+        const ScanTimeline &t = timelines[n];
+        for (int i = 0; i + 1 < TraceStageCount; i++) {
+            if (!t.stamp[i] || t.stamp[i + 1] < t.stamp[i]) {
+                continue;
+            }
+            uint64_t dur = t.stamp[i + 1] - t.stamp[i];
+            //microseconds with the nanoseconds kept as decimals
+            snprintf(buf, sizeof(buf), ",\n{\"name\":\"%s\",\"cat\":\"scan\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+                     "\"ts\":%" PRIu64 ".%03u,\"dur\":%" PRIu64 ".%03u,\"args\":{\"scan\":%" PRIu64 "}}",
+                     transition_name[i], i + 1, t.stamp[i] / 1000, (unsigned int)(t.stamp[i] % 1000),
+                     dur / 1000, (unsigned int)(dur % 1000), t.scan);
+            out.append(buf);
+        }
+    }
+    out.append("\n]}\n");
+}
+
+}//common
+}//core
+}//lidar
@@ -0,0 +1,131 @@
+#pragma once
+#include <core/base/v8stdint.h>
+#include <core/base/locker.h>
+#include <string>
+#include <vector>
+#include "lidar_def.h"
+#include "MetricsRegistry.h"
+
+namespace lidar {
+namespace core {
+namespace common {
+
+/**
+ * @brief Log-linear histogram of durations owned by one thread \n
+ * Every power of two is split into SUB_COUNT buckets, a percentile is off by
+ * at most 1/SUB_COUNT of its value. Values up to 2^MAX_EXPONENT ns(18 min)
+ * are told apart, longer ones share the last bucket.
+ */
+class LatencyHistogram {
+public:
+    enum {
+        SUB_BITS = 4,
+        SUB_COUNT = 1 << SUB_BITS,
+        MAX_EXPONENT = 40,
+        BUCKETS = (MAX_EXPONENT - SUB_BITS + 2) * SUB_COUNT,
+    };
+
+    void record(uint64_t ns) {
+        m_buckets[bucket(ns)].add();
+        m_count.add();
+        if (ns > m_max.value()) {
+            m_max.set(ns);
+        }
+    }
+
+    /**
+     * @brief percentiles of the recorded values, any thread
+     * @param[out] p  upper bound of the bucket holding each percentile
+     */
+    void percentiles(LatencyPercentiles &p) const;
+
+    static int bucket(uint64_t ns) {
+        if (ns < SUB_COUNT) {
+            return (int)ns;
+        }
+        int exponent = SUB_BITS;
+        while (exponent < 63 && (ns >> (exponent + 1))) {
+            exponent++;
+        }
+        if (exponent > MAX_EXPONENT) {
+            return BUCKETS - 1;
+        }
+        return (exponent - SUB_BITS + 1) * SUB_COUNT + (int)((ns >> (exponent - SUB_BITS)) & (SUB_COUNT - 1));
+    }
+
+    /// largest value of bucket i
+    static uint64_t upperBound(int i) {
+        if (i < SUB_COUNT) {
+            return i;
+        }
+        int shift = i / SUB_COUNT - 1;
+        return ((uint64_t)(SUB_COUNT + i % SUB_COUNT + 1) << shift) - 1;
+    }
+
+private:
+    MetricCounter m_buckets[BUCKETS];
+    MetricCounter m_count;
+    MetricCounter m_max;
+};
+
+/**
+ * @brief Stage latencies of the revolutions handed to the caller \n
+ * The consumer thread records the timeline of each converted revolution:
+ * one histogram per stage transition, and the last TRACE_CAPACITY
+ * timelines for ::writeTrace. ::latency and ::writeTrace may be called
+ * from any thread.
+ */
+class LatencyTracer {
+public:
+    enum {
+        TRACE_CAPACITY = 2048,         ///< timelines kept for the trace
+    };
+
+    LatencyTracer();
+
+    /**
+     * @brief account a converted revolution, consumer thread only
+     * @param timeline  stages of the revolution
+     */
+    void record(const ScanTimeline &timeline);
+
+    /**
+     * @brief percentiles of every stage transition
+     */
+    void latency(ScanLatency &latency) const;
+
+    /**
+     * @brief timeline of the last recorded revolution, zeroed if none
+     */
+    ScanTimeline last() const;
+
+    /**
+     * @brief write the kept timelines in Chrome trace event format \n
+     * One track per stage transition, loads in chrome://tracing and Perfetto.
+     * @param path   json file
+     * @param label  process name shown in the viewer
+     * @return false if the file can not be written
+     */
+    bool writeTrace(const std::string &path, const std::string &label) const;
+
+    /**
+     * @brief format timelines in Chrome trace event format
+     * @param[out] out  json, appended
+     */
+    static void formatTrace(const std::vector<ScanTimeline> &timelines, const std::string &label,
+                            std::string &out);
+
+private:
+    LatencyTracer(const LatencyTracer &);
+    LatencyTracer &operator=(const LatencyTracer &);
+
+    LatencyHistogram m_stages[TraceStageCount - 1];
+    LatencyHistogram m_total;
+    mutable base::Locker m_Lock;               ///< m_ring, m_next
+    std::vector<ScanTimeline> m_ring;
+    uint64_t m_next;                           ///< timelines recorded
+};
+
+}//common
+}//core
+}//lidar
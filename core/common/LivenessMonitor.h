@@ -0,0 +1,237 @@
+#pragma once
+#include <core/base/v8stdint.h>
+#include <core/base/locker.h>
+#include <atomic>
+#include <deque>
+#include "lidar_def.h"
+
+namespace lidar {
+namespace core {
+using namespace base;
+namespace common {
+
+/// Liveness thresholds, unit: ms
+struct liveness_config {
+    uint32_t data_timeout;        ///< maximum gap between two data packets
+    uint32_t heartbeat_interval;  ///< heartbeat request period, 0 disables the heartbeat
+    uint32_t heartbeat_timeout;   ///< maximum age of the last heartbeat answer
+    uint32_t control_fail_count;  ///< consecutive control failures before the link is degraded
+};
+
+/**
+ * @brief Link liveness monitor \n
+ * Combines data packet arrival gaps, heartbeat answers and control channel
+ * results into one LinkState and reports every transition through a callback.
+ * ::onPacket is called by the receiving thread for each valid packet,
+ * ::update by any thread that wants the state re-evaluated. Transitions are
+ * reported in order, without the lock held.
+ */
+class LivenessMonitor {
+public:
+    LivenessMonitor()
+        : m_lastPacket(0)
+        , m_lastHeartBeat(0)
+        , m_controlFails(0)
+        , m_expectData(false)
+        , m_state(LinkStateUnknown)
+        , m_faults(LinkFaultNone)
+        , m_delivering(false)
+        , m_callback(NULL)
+        , m_user(NULL) {
+        m_config.data_timeout = 100;
+        m_config.heartbeat_interval = 0;
+        m_config.heartbeat_timeout = 3000;
+        m_config.control_fail_count = 3;
+    }
+
+    /**
+     * @brief set liveness thresholds
+     * @param config  thresholds, unit: ms
+     */
+    void setConfig(const liveness_config &config) {
+        ScopedLocker l(m_Lock);
+        m_config = config;
+    }
+
+    /**
+     * @brief get liveness thresholds
+     * @return thresholds, unit: ms
+     */
+    liveness_config getConfig() {
+        ScopedLocker l(m_Lock);
+        return m_config;
+    }
+
+    /**
+     * @brief set the state transition callback
+     * @param callback  callback, NULL to disable
+     * @param user      user data passed to the callback
+     */
+    void setCallback(LinkStateCallback callback, void *user) {
+        ScopedLocker l(m_Lock);
+        m_callback = callback;
+        m_user = user;
+    }
+
+    /**
+     * @brief start monitoring a new session
+     * @param now         current time(ms)
+     * @param expectData  whether data packets are expected
+     */
+    void start(uint32_t now, bool expectData = true) {
+        m_lastPacket = 0;
+        m_lastHeartBeat = now;
+        m_controlFails = 0;
+        m_expectData = expectData;
+        transition(LinkStateUnknown, LinkFaultNone);
+    }
+
+    /**
+     * @brief stop monitoring, the state goes back to LinkStateUnknown
+     */
+    void stop() {
+        m_expectData = false;
+        transition(LinkStateUnknown, LinkFaultNone);
+    }
+
+    /**
+     * @brief a valid data packet was received
+     * @param now  current time(ms)
+     */
+    void onPacket(uint32_t now) {
+        m_lastPacket = now;
+    }
+
+    /**
+     * @brief result of a heartbeat or control request
+     * @param ok   whether the lidar answered
+     * @param now  current time(ms)
+     */
+    void onControl(bool ok, uint32_t now) {
+        if (ok) {
+            m_lastHeartBeat = now;
+            m_controlFails = 0;
+        } else {
+            m_controlFails++;
+        }
+    }
+
+    /**
+     * @brief time since the last valid data packet
+     * @param now  current time(ms)
+     * @return packet gap(ms), 0 if no packet has been received yet
+     */
+    uint32_t packetAge(uint32_t now) const {
+        uint32_t last = m_lastPacket;
+        return last ? now - last : 0;
+    }
+
+    /**
+     * @brief re-evaluate the link state, the callback is invoked on transitions
+     * @param now  current time(ms)
+     * @return current link state
+     */
+    LinkState update(uint32_t now) {
+        uint32_t lastPacket = m_lastPacket;
+        uint32_t faults = LinkFaultNone;
+        liveness_config config = getConfig();
+
+        if (m_expectData && lastPacket && now - lastPacket > config.data_timeout) {
+            faults |= LinkFaultData;
+        }
+        if (config.heartbeat_interval &&
+            now - m_lastHeartBeat > config.heartbeat_timeout) {
+            faults |= LinkFaultHeartBeat;
+        }
+        if (config.control_fail_count && m_controlFails >= config.control_fail_count) {
+            faults |= LinkFaultControl;
+        }
+
+        LinkState state = LinkStateAlive;
+        if (faults & LinkFaultData) {
+            state = LinkStateDead;
+        } else if ((faults & LinkFaultHeartBeat) && !m_expectData) {
+            state = LinkStateDead;
+        } else if (faults != LinkFaultNone) {
+            state = LinkStateDegraded;
+        } else if (m_expectData && !lastPacket) {
+            //motor spin-up, nothing to judge yet
+            state = LinkStateUnknown;
+        }
+        transition(state, faults);
+        return state;
+    }
+
+    /**
+     * @brief get current link state
+     * @return link state
+     */
+    LinkState getState() const {
+        return m_state;
+    }
+
+    /**
+     * @brief get the faults of the current link state
+     * @return LinkFault flags
+     */
+    uint32_t getFaults() const {
+        return m_faults;
+    }
+
+protected:
+    /// a transition not yet reported
+    struct Event {
+        LinkState state;
+        LinkState previous;
+        uint32_t faults;
+    };
+
+    void transition(LinkState state, uint32_t faults) {
+        ScopedLocker l(m_Lock);
+        if (state == m_state) {
+            m_faults = faults;
+            return;
+        }
+        Event event = {state, m_state, faults};
+        m_state = state;
+        m_faults = faults;
+        m_events.push_back(event);
+
+        //one thread reports the queue in transition order, the others only enqueue
+        if (m_delivering) {
+            return;
+        }
+        m_delivering = true;
+        while (!m_events.empty()) {
+            event = m_events.front();
+            m_events.pop_front();
+            LinkStateCallback callback = m_callback;
+            void *user = m_user;
+            //the callback may query or drive the monitor, call it unlocked
+            m_Lock.unlock();
+            if (callback) {
+                callback(event.state, event.previous, event.faults, user);
+            }
+            m_Lock.lock();
+        }
+        m_delivering = false;
+    }
+
+protected:
+    std::atomic<uint32_t> m_lastPacket;      ///< last valid packet time, 0 before the first one
+    std::atomic<uint32_t> m_lastHeartBeat;   ///< last answered heartbeat time
+    std::atomic<uint32_t> m_controlFails;    ///< consecutive control failures
+    std::atomic<bool> m_expectData;          ///< data packets are expected
+    std::atomic<LinkState> m_state;
+    std::atomic<uint32_t> m_faults;
+    liveness_config m_config;
+    std::deque<Event> m_events;              ///< transitions waiting for the callback
+    bool m_delivering;                       ///< a thread is reporting m_events
+    LinkStateCallback m_callback;
+    void *m_user;
+    Locker m_Lock;
+};
+
+}//common
+}//core
+}//lidar
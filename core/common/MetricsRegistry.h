@@ -0,0 +1,265 @@
+#pragma once
+#include <core/base/v8stdint.h>
+#include <atomic>
+#include <string.h>
+#include "lidar_def.h"
+
+namespace lidar {
+namespace core {
+namespace common {
+
+/**
+ * @brief Counter owned by one thread \n
+ * Only the owning thread adds, so an increment is a plain load and store
+ * instead of a locked read-modify-write. Any thread may read it.
+ */
+class MetricCounter {
+public:
+    MetricCounter() : m_value(0) {
+    }
+
+    void add(uint64_t n = 1) {
+        m_value.store(m_value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    void set(uint64_t n) {
+        m_value.store(n, std::memory_order_relaxed);
+    }
+
+    uint64_t value() const {
+        return m_value.load(std::memory_order_relaxed);
+    }
+
+private:
+    MetricCounter(const MetricCounter &);
+    MetricCounter &operator=(const MetricCounter &);
+
+    std::atomic<uint64_t> m_value;
+};
+
+/**
+ * @brief Value set by one thread, read by any
+ */
+class MetricGauge {
+public:
+    MetricGauge() : m_value(0) {
+    }
+
+    void set(double value) {
+        m_value.store(value, std::memory_order_relaxed);
+    }
+
+    double value() const {
+        return m_value.load(std::memory_order_relaxed);
+    }
+
+private:
+    MetricGauge(const MetricGauge &);
+    MetricGauge &operator=(const MetricGauge &);
+
+    std::atomic<double> m_value;
+};
+
+/**
+ * @brief Per second rate of a counter, updated by the counter's owner
+ */
+class MetricRate {
+public:
+    static const uint64_t WINDOW = 1000000000ULL;///< ns
+
+    MetricRate() : m_start(0), m_base(0), m_rate(0), m_updated(0) {
+    }
+
+    /**
+     * @brief account the counter, once a window the rate is recomputed
+     * @param total  counter value
+     * @param now    getns()
+     */
+    void update(uint64_t total, uint64_t now) {
+        if (m_start == 0) {
+            m_start = now;
+            m_base = total;
+            return;
+        }
+        uint64_t elapsed = now - m_start;
+        if (elapsed >= WINDOW) {
+            m_rate.store((double)(total - m_base) * 1e9 / elapsed, std::memory_order_relaxed);
+            m_updated.store(now, std::memory_order_relaxed);
+            m_start = now;
+            m_base = total;
+        }
+    }
+
+    /**
+     * @brief rate of the last window, 0 once the counter stopped moving
+     * @param now  getns()
+     */
+    double value(uint64_t now) const {
+        uint64_t updated = m_updated.load(std::memory_order_relaxed);
+        return now - updated > 2 * WINDOW ? 0 : m_rate.load(std::memory_order_relaxed);
+    }
+
+private:
+    uint64_t m_start;                  ///< start of the window, owner only
+    uint64_t m_base;                   ///< counter at the start of the window, owner only
+    std::atomic<double> m_rate;
+    std::atomic<uint64_t> m_updated;   ///< end of the last window
+};
+
+/**
+ * @brief Histogram of durations owned by one thread \n
+ * Bucket i counts the values below 1024 << i ns, the last one everything
+ * above, so the bounds cover 1 us to 16 ms.
+ */
+class MetricHistogram {
+public:
+    enum {
+        BUCKETS = LIDAR_METRICS_BUCKETS,
+        FIRST_BOUND_SHIFT = 10,        ///< 1024 ns
+    };
+
+    void record(uint64_t ns) {
+        m_buckets[bucket(ns)].add();
+        m_count.add();
+        m_sum.add(ns);
+        if (ns > m_max.value()) {
+            m_max.set(ns);
+        }
+    }
+
+    static int bucket(uint64_t ns) {
+        int i = 0;
+        for (ns >>= FIRST_BOUND_SHIFT; ns && i < BUCKETS - 1; ns >>= 1) {
+            i++;
+        }
+        return i;
+    }
+
+    uint64_t count() const {
+        return m_count.value();
+    }
+
+    uint64_t sum() const {
+        return m_sum.value();
+    }
+
+    uint64_t max() const {
+        return m_max.value();
+    }
+
+    uint64_t bucketCount(int i) const {
+        return m_buckets[i].value();
+    }
+
+private:
+    MetricCounter m_buckets[BUCKETS];
+    MetricCounter m_count;
+    MetricCounter m_sum;
+    MetricCounter m_max;
+};
+
+/**
+ * @brief Metrics of the ingest pipeline of one driver \n
+ * Every metric has a single writer: the thread reading the port counts
+ * bytes, the thread decoding counts packets, errors and revolutions.
+ * ::snapshot may be called from any thread at any time.
+ */
+class MetricsRegistry {
+public:
+    /**
+     * @brief count a received packet
+     * @param len  packet size, 0 if the bytes are counted by ::onBytes
+     * @param now  getns()
+     */
+    void onPacket(size_t len, uint64_t now) {
+        packets.add();
+        packet_rate.update(packets.value(), now);
+        if (len) {
+            onBytes(len, now);
+        }
+    }
+
+    /**
+     * @brief count received bytes
+     * @param len  byte count
+     * @param now  getns()
+     */
+    void onBytes(size_t len, uint64_t now) {
+        bytes.add(len);
+        byte_rate.update(bytes.value(), now);
+    }
+
+    /**
+     * @brief account the speed and coverage of a published revolution
+     * @param stats  measured by the ScanAssembler
+     */
+    void onScan(const ScanStats &stats) {
+        scan_period.set(stats.period);
+        scan_jitter.set(stats.jitter);
+        scan_points.set(stats.points);
+        scan_max_gap.set(stats.max_gap);
+        scan_coverage.set(stats.coverage);
+        if (stats.flags & ScanIncomplete) {
+            scans_incomplete.add();
+        }
+        if (stats.flags & ScanTruncated) {
+            scans_truncated.add();
+        }
+    }
+
+    /**
+     * @brief copy every metric
+     * @param[out] m   metrics
+     * @param now      getns()
+     */
+    void snapshot(LidarMetrics &m, uint64_t now) const {
+        memset(&m, 0, sizeof(m));
+        m.stamp = now;
+        m.packets = packets.value();
+        m.bytes = bytes.value();
+        m.sequence_gaps = sequence_gaps.value();
+        m.frame_errors = frame_errors.value();
+        m.foreign_packets = foreign_packets.value();
+        m.scans = scans.value();
+        m.scans_overwritten = scans_overwritten.value();
+        m.scans_incomplete = scans_incomplete.value();
+        m.scans_truncated = scans_truncated.value();
+        m.packet_rate = packet_rate.value(now);
+        m.byte_rate = byte_rate.value(now);
+        m.decode_count = decode.count();
+        m.decode_ns_sum = decode.sum();
+        m.decode_ns_max = decode.max();
+        for (int i = 0; i < MetricHistogram::BUCKETS; i++) {
+            m.decode_ns_buckets[i] = decode.bucketCount(i);
+        }
+        m.scan_period_ns = scan_period.value();
+        m.scan_jitter_ns = scan_jitter.value();
+        m.scan_points = scan_points.value();
+        m.scan_frequency = m.scan_period_ns ? 1e9 / m.scan_period_ns : 0;
+        m.scan_speed_jitter = m.scan_period_ns ? (double)m.scan_jitter_ns / m.scan_period_ns : 0;
+        m.scan_max_gap = scan_max_gap.value();
+        m.scan_coverage = scan_coverage.value();
+    }
+
+    MetricCounter packets;
+    MetricCounter bytes;
+    MetricCounter sequence_gaps;
+    MetricCounter frame_errors;
+    MetricCounter foreign_packets;
+    MetricCounter scans;
+    MetricCounter scans_overwritten;
+    MetricCounter scans_incomplete;
+    MetricCounter scans_truncated;
+    MetricRate packet_rate;
+    MetricRate byte_rate;
+    MetricHistogram decode;
+    MetricCounter scan_period;         ///< ns
+    MetricCounter scan_jitter;         ///< ns
+    MetricCounter scan_points;
+    MetricGauge scan_max_gap;          ///< degree
+    MetricGauge scan_coverage;
+};
+
+}//common
+}//core
+}//lidar
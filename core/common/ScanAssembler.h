@@ -0,0 +1,289 @@
+#pragma once
+#include <core/base/v8stdint.h>
+#include <vector>
+#include <string.h>
+#include "lidar_protocol.h"
+#include "lidar_datatype.h"
+
+namespace lidar {
+namespace core {
+namespace common {
+
+/**
+ * @brief Assembles decoded points into revolutions \n
+ * A revolution ends where the angle steps back by more than MIN_WRAP, which
+ * also holds across the gap of a limited field of view, or where a point is
+ * later than the measured period allows for its angle, when the packets
+ * around the zero crossing were lost. Live and replay drivers share it, so
+ * both cut the scans at the same points. The buffer holds ::capacity
+ * points; a revolution reaching it is published as truncated instead of
+ * overwriting points. Each published revolution comes with its ScanStats:
+ * the angular gaps are tracked point by point against the spacing of the
+ * configured sample rate, the blind sector of the field of view is not
+ * counted as missing. The period is seeded from the angle and time spanned by
+ * the first revolution, then measured between the device stamps of
+ * consecutive zero crossings and filtered once per revolution.
+ */
+class ScanAssembler {
+public:
+    enum {
+        FULL_CIRCLE = 36000,          ///< angle_q6_checkbit of a turn, 0.01 degree
+        MIN_WRAP = 100,               ///< smaller steps back are angle noise, 0.01 degree
+        HEADROOM = 2,                 ///< a motor down to half the configured speed fits the buffer
+        PERIOD_GAIN_SHIFT = 3,        ///< the filtered period moves by 1/8 of a deviation
+        JITTER_GAIN_SHIFT = 4,        ///< the jitter moves by 1/16 of a change, as RFC 3550
+        MIN_SEED_SPAN = FULL_CIRCLE / 4,///< angle a revolution must span to seed the period, 0.01 degree
+    };
+
+    /**
+     * @param capacity  points a revolution may hold, see ::capacity
+     * @param spacing   expected point spacing, see ::spacing, 0 if unknown: gaps are not accounted
+     * @param fov       field of view of the lidar, 0.01 degree
+     */
+    explicit ScanAssembler(size_t capacity, uint32_t spacing = 0, uint32_t fov = FULL_CIRCLE)
+        : m_scan(capacity > 0 ? capacity : 1)
+        , m_count(0)
+        , m_spacing(spacing)
+        , m_blind(fov > 0 && fov < FULL_CIRCLE ? FULL_CIRCLE - fov : 0) {
+        reset();
+    }
+
+    /**
+     * @brief buffer size for a sample rate and scan frequency
+     * @param sampleRate  kHz
+     * @param frequency   Hz
+     * @param packet      points of a packet, the size is rounded up to whole packets
+     * @param fallback    size if the configuration is unknown
+     * @return HEADROOM revolutions
+     */
+    static size_t capacity(int sampleRate, float frequency, size_t packet, size_t fallback) {
+        if (sampleRate <= 0 || frequency <= 0.f || packet == 0) {
+            return fallback;
+        }
+        size_t points = (size_t)(sampleRate * 1000.0 / frequency + 0.5) * HEADROOM;
+        return (points + packet - 1) / packet * packet;
+    }
+
+    /**
+     * @brief point spacing for a sample rate and scan frequency
+     * @param sampleRate  kHz
+     * @param frequency   Hz
+     * @return 0.01 degree, 0 if the configuration is unknown
+     */
+    static uint32_t spacing(int sampleRate, float frequency) {
+        if (sampleRate <= 0 || frequency <= 0.f) {
+            return 0;
+        }
+        return (uint32_t)(FULL_CIRCLE * frequency / (sampleRate * 1000.0) + 0.5);
+    }
+
+    /**
+     * @brief drop the revolution being assembled and the speed measured so far
+     */
+    void reset() {
+        m_count = 0;
+        m_open = false;
+        m_flags = 0;
+        memset(&m_stats, 0, sizeof(m_stats));
+        m_syncStamp = 0;
+        m_lost = false;
+        m_hasLast = false;
+        m_lastAngle = 0;
+        m_maxGap = 0;
+        m_missing = 0;
+    }
+
+    /**
+     * @brief mark the revolution being assembled as incomplete \n
+     * used after a bad or lost packet, the revolution is published with a gap
+     */
+    void markSync() {
+        m_open = true;
+        m_flags |= ScanIncomplete;
+        m_lost = true;
+    }
+
+    /**
+     * @brief statistics of the last published revolution
+     */
+    const ScanStats &stats() const {
+        return m_stats;
+    }
+
+    /**
+     * @brief append decoded points
+     * @param nodes    points of one packet
+     * @param count    point count
+     * @param publish  called as publish(const node_info *scan, size_t count, const ScanStats &stats)
+     *                 for every completed revolution
+     */
+    template <typename Publisher>
+    void push(const node_info *nodes, size_t count, Publisher publish) {
+        for (size_t pos = 0; pos < count; pos++) {
+            const node_info &node = nodes[pos];
+            uint16_t angle = node.angle_q6_checkbit;
+            bool wrap = m_hasLast ? angle + MIN_WRAP < m_lastAngle : (node.sync_flag & Node_Sync) != 0;
+            bool late = !wrap && m_hasLast && isLate(node);
+            if (wrap || late) {
+                if (m_open) {
+                    if (late) {
+                        m_flags |= ScanIncomplete;
+                    }
+                    finish(&node, wrap);
+                    publish(&m_scan[0], m_count, m_stats);
+                }
+                //the points lost right before may have been the start of this revolution
+                m_count = 0;
+                m_open = true;
+                m_flags = late || m_lost ? ScanIncomplete : 0;
+                //back to the zero crossing, the first point is later with a limited field of view or lost packets
+                m_syncStamp = startOf(node);
+                m_maxGap = 0;
+                m_missing = 0;
+                if (late) {
+                    gap(angle);
+                }
+            } else if (m_count && angle >= m_lastAngle) {
+                gap(angle - m_lastAngle);
+            }
+            m_lost = false;
+            m_hasLast = true;
+            m_lastAngle = angle;
+            m_scan[m_count] = node;
+            m_scan[m_count].sync_flag = m_count == 0 && (wrap || late) ? Node_Sync : Node_NotSync;
+            m_count++;
+
+            if (m_count == m_scan.size()) {
+                //published as it is, the rest of the turn follows as an incomplete revolution
+                if (m_open) {
+                    m_flags |= ScanTruncated;
+                    finish(NULL, false);
+                    publish(&m_scan[0], m_count, m_stats);
+                    m_flags = ScanIncomplete;
+                }
+                m_count = 0;
+                m_maxGap = 0;
+                m_missing = 0;
+            }
+        }
+    }
+
+private:
+    /// time from the zero crossing to a point at angle, with the measured period
+    uint64_t expected(uint16_t angle) const {
+        return m_stats.period * angle / FULL_CIRCLE;
+    }
+
+    /// device time of the zero crossing before a point
+    uint64_t startOf(const node_info &node) const {
+        uint64_t offset = expected(node.angle_q6_checkbit);
+        return node.stamp > offset ? node.stamp - offset : 0;
+    }
+
+    /// a point later than half a period after the time its angle was due belongs to a later turn
+    bool isLate(const node_info &node) const {
+        return m_stats.period && m_syncStamp && node.stamp > m_syncStamp &&
+               node.stamp - m_syncStamp > expected(node.angle_q6_checkbit) + m_stats.period / 2;
+    }
+
+    /// account the angle between two neighbouring points
+    void gap(uint32_t angle) {
+        if (angle > m_maxGap) {
+            m_maxGap = angle;
+        }
+        if (m_spacing && angle > 2 * m_spacing) {
+            m_missing += angle - m_spacing;
+        }
+    }
+
+    /**
+     * @brief fill m_stats for the revolution in m_scan
+     * @param next  point starting the next revolution, NULL if the revolution is truncated
+     * @param wrap  next is at the zero crossing
+     */
+    void finish(const node_info *next, bool wrap) {
+        if (next && m_count) {
+            //a late point leaves the end of the turn uncovered
+            gap(wrap ? next->angle_q6_checkbit + FULL_CIRCLE - m_lastAngle : FULL_CIRCLE - m_lastAngle);
+        }
+        m_stats.points = (uint32_t)m_count;
+        m_stats.flags = m_flags;
+        m_stats.max_gap = m_maxGap / 100.f;
+        //the blind sector is a gap of every revolution, only the field of view counts
+        uint32_t missing = m_missing > m_blind ? m_missing - m_blind : 0;
+        uint32_t fov = FULL_CIRCLE - m_blind;
+        m_stats.coverage = missing < fov ? 1.f - (float)missing / fov : 0.f;
+
+        if (m_stats.period == 0) {
+            seed();
+        } else {
+            //a device clock going back, e.g. after a lidar restart, starts the measurement again
+            uint64_t start = next ? startOf(*next) : 0;
+            if (next && m_syncStamp && start > m_syncStamp) {
+                measure(start - m_syncStamp);
+            }
+        }
+        uint32_t frequency = (uint32_t)(m_stats.frequency * 10 + 0.5f);
+        m_scan[0].scan_frequence = (uint8_t)(frequency > 0xFF ? 0xFF : frequency);
+    }
+
+    /**
+     * @brief first period, from the time the points of m_scan took to sweep their angle \n
+     * without a period the start of a revolution whose zero crossing was lost is unknown,
+     * the points themselves do not depend on it
+     */
+    void seed() {
+        if (m_count < 2) {
+            return;
+        }
+        const node_info &first = m_scan[0];
+        const node_info &last = m_scan[m_count - 1];
+        uint32_t span = last.angle_q6_checkbit > first.angle_q6_checkbit ?
+                        last.angle_q6_checkbit - first.angle_q6_checkbit : 0;
+        if (span >= MIN_SEED_SPAN && last.stamp > first.stamp) {
+            measure((last.stamp - first.stamp) * FULL_CIRCLE / span);
+        }
+    }
+
+    /**
+     * @brief filter a measured period, O(1)
+     * @param period  zero crossing to zero crossing, device clock(ns)
+     */
+    void measure(uint64_t period) {
+        if (m_stats.period == 0) {
+            m_stats.period = period;
+            m_stats.jitter = 0;
+        } else {
+            //a lost zero crossing merges revolutions, one period is a fraction of the measured one
+            uint64_t turns = (period + m_stats.period / 2) / m_stats.period;
+            if (turns > 1) {
+                period /= turns;
+            }
+            int64_t deviation = (int64_t)(period - m_stats.period);
+            uint64_t magnitude = deviation < 0 ? -deviation : deviation;
+            m_stats.period = (uint64_t)((int64_t)m_stats.period + deviation / (1 << PERIOD_GAIN_SHIFT));
+            m_stats.jitter = (uint64_t)((int64_t)m_stats.jitter +
+                                        ((int64_t)magnitude - (int64_t)m_stats.jitter) / (1 << JITTER_GAIN_SHIFT));
+        }
+        m_stats.frequency = m_stats.period ? 1e9f / m_stats.period : 0.f;
+        m_stats.speed_jitter = m_stats.period ? (float)m_stats.jitter / m_stats.period : 0.f;
+    }
+
+    std::vector<node_info> m_scan;    ///< revolution being assembled
+    size_t m_count;                   ///< points in m_scan
+    bool m_open;                      ///< m_scan is publishable: it starts at a boundary or has a gap
+    uint32_t m_flags;                 ///< ScanFlag bits of m_scan
+    ScanStats m_stats;                ///< last published revolution
+    uint64_t m_syncStamp;             ///< device time of the zero crossing starting m_scan, 0 if none
+    bool m_lost;                      ///< packets were lost since the last point
+    bool m_hasLast;                   ///< m_lastAngle is set
+    uint16_t m_lastAngle;             ///< angle of the last point appended
+    uint32_t m_spacing;               ///< expected point spacing, 0.01 degree, 0 if unknown
+    uint32_t m_blind;                 ///< angle outside the field of view, 0.01 degree
+    uint32_t m_maxGap;                ///< widest gap in m_scan, 0.01 degree
+    uint32_t m_missing;               ///< angle of the gaps in m_scan beyond the usual spacing
+};
+
+}//common
+}//core
+}//lidar
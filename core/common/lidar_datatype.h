@@ -104,11 +104,14 @@ typedef struct  {
  * @endcode
  */
 typedef struct {
-    uint64_t stamp;/// System time when first range was measured in nanoseconds
+    uint64_t stamp;/// Host time(getTime()) when first range was measured in nanoseconds, mapped from the lidar clock
     std::vector<LaserPoint> points;/// Array of lidar points
     LaserConfig config;/// Configuration of scan
     int moduleNum ;
     uint16_t envFlag; //环境标记（目前只针对GS2）
+    ScanStats stats;/// Measured scan frequency, motor stability and angular gaps
+    uint64_t device_stamp;/// Lidar clock time when first range was measured in nanoseconds
+    uint64_t stamp_error;/// Error bound of stamp in nanoseconds, UINT64_MAX while the clocks are not related
 } LaserScan;
 
 
@@ -119,9 +122,9 @@ struct node_info {
     uint16_t sync_quality; //信号强度
     uint16_t angle_q6_checkbit; //角度值（°）
     uint16_t distance_q2; //距离值
-    uint64_t stamp; //时间戳
+    uint64_t stamp; //时间戳(ns)
     uint32_t delay_time; ///< delay time
-    uint8_t scan_frequence; //扫描频率
+    uint8_t scan_frequence; //扫描频率(0.1Hz)，只填在一圈的第一个点
     uint8_t debugInfo; ///< debug information
     uint8_t index; //包序号
     uint8_t error_package; ///< error package state
@@ -187,3 +190,14 @@ struct function_state {
 struct offset_angle {
     int32_t angle;
 } __attribute__((packed))  ;
+
+
+/// LiDAR bring-up timeline, getms() ticks of each step, 0 if not reached yet
+struct startup_timing {
+    uint32_t connect_start;  ///< connect() entered
+    uint32_t connected;      ///< command and data channels ready
+    uint32_t scan_start;     ///< startScan() entered
+    uint32_t scan_started;   ///< start command acknowledged
+    uint32_t first_packet;   ///< first valid data packet decoded
+    uint32_t first_scan;     ///< first full revolution published
+};
@@ -38,6 +38,7 @@ typedef enum {
     LIDAR_TYPE_SERIAL = 0x0,/**< serial type.*/
     LIDAR_TYPE_TCP = 0x1,/**< socket tcp type.*/
     LIDAR_TYPC_UDP = 0x2,/**< socket udp type.*/
+    LIDAR_TYPE_REPLAY = 0x3,/**< capture file replay, LidarPropSerialPort is the file.*/
 } DeviceTypeID;
 
 /** Lidar Type ID */
@@ -53,6 +54,10 @@ typedef enum {
     /* char* properties */
     LidarPropSerialPort = 0,/**< Lidar serial port or network ipaddress */
     LidarPropIgnoreArray,/**< Lidar ignore angle array */
+    LidarPropRecordPath,/**< raw data capture file, empty disables recording */
+    LidarPropArchivePath,/**< compressed scan archive file, empty disables archiving */
+    LidarPropThreadCpus,/**< cpu list of the ingest threads like "2-3", empty for any cpu */
+    LidarPropMetricsPath,/**< Prometheus export, a file or "127.0.0.1:port", empty disables it */
     /* int properties */
     LidarPropSerialBaudrate = 10,/**< lidar serial baudrate or network port */
     LidarPropLidarType,/**< lidar type code */
@@ -60,12 +65,15 @@ typedef enum {
     LidarPropSampleRate,/**< lidar sample rate */
     LidarPropAbnormalCheckCount,/**< abnormal maximum check times */
     LidarPropIntenstiyBit,/**< lidar intensity bit count */
+    LidarPropLivenessTimeout,/**< maximum data packet gap before the link is dead(ms) */
+    LidarPropDataPort,/**< local UDP port the lidar streams to */
     /* float properties */
     LidarPropMaxRange = 20,/**< lidar maximum range */
     LidarPropMinRange,/**< lidar minimum range */
     LidarPropMaxAngle,/**< lidar maximum angle */
     LidarPropMinAngle,/**< lidar minimum angle */
     LidarPropScanFrequency,/**< lidar scanning frequency */
+    LidarPropReplaySpeed,/**< capture replay speed factor, 0 as fast as the scans are consumed */
     /* bool properties */
     LidarPropFixedResolution = 30,/**< fixed angle resolution flag */
     LidarPropReversion,/**< lidar reversion flag */
@@ -75,8 +83,59 @@ typedef enum {
     LidarPropIntenstiy,/**< lidar intensity flag */
     LidarPropSupportMotorDtrCtrl,/**< lidar support motor Dtr ctrl flag */
     LidarPropSupportHeartBeat,/**< lidar support heartbeat flag */
+    LidarPropReplayLoop,/**< restart the capture replay at its end */
+    /* int properties, continued */
+    LidarPropThreadPolicy = 50,/**< ingest thread scheduling, 0 normal, 1 SCHED_FIFO, 2 SCHED_RR */
+    LidarPropThreadPriority,/**< ingest thread real-time priority(1-99) */
+    LidarPropThreadStackSize,/**< ingest thread stack size(bytes), 0 for the system default */
+    LidarPropMetricsInterval,/**< Prometheus file export period(ms) */
 } LidarProperty;
 
+/** Link liveness state */
+typedef enum {
+    LinkStateUnknown = 0,/**< not monitored or no data received yet */
+    LinkStateAlive,/**< data and control channel healthy */
+    LinkStateDegraded,/**< data flowing, heartbeat or control channel failing */
+    LinkStateDead,/**< no data within the liveness timeout */
+} LinkState;
+
+/** Link fault flags */
+typedef enum {
+    LinkFaultNone = 0x0,/**< no fault */
+    LinkFaultData = 0x1,/**< data packet gap exceeded */
+    LinkFaultHeartBeat = 0x2,/**< heartbeat answer too old */
+    LinkFaultControl = 0x4,/**< control channel requests failing */
+} LinkFault;
+
+/**
+ * @brief link state transition callback
+ * @note called from an SDK thread, it must return quickly
+ * @param state     new link state
+ * @param previous  previous link state
+ * @param faults    LinkFault flags that caused the transition
+ * @param user      user data given when registering the callback
+ */
+typedef void (*LinkStateCallback)(LinkState state, LinkState previous, uint32_t faults, void *user);
+
+/** Driver lifecycle state */
+typedef enum {
+    DriverStateDisconnected = 0,/**< no connection to the lidar */
+    DriverStateConnecting,/**< opening the command and data ports */
+    DriverStateConfiguring,/**< connected and idle, parameters may be changed */
+    DriverStateScanning,/**< data is being received */
+    DriverStateReconnecting,/**< data lost while scanning, the link is being restored */
+    DriverStateStopping,/**< the scan is being stopped */
+} DriverState;
+
+/**
+ * @brief driver state transition callback
+ * @note called from an SDK thread, it must return quickly and must not call back into the driver
+ * @param state     new driver state
+ * @param previous  previous driver state
+ * @param user      user data given when registering the callback
+ */
+typedef void (*DriverStateCallback)(DriverState state, DriverState previous, void *user);
+
 /// lidar instance
 typedef struct {
     void *lidar;///< CLidar instance
@@ -185,7 +244,7 @@ typedef struct {
  */
 
 typedef struct {
-    uint64_t stamp;/// System time when first range was measured in nanoseconds
+    uint64_t stamp;/// Host time(getTime()) when first range was measured in nanoseconds, see ClockSyncState
     uint32_t npoints;/// Array of lidar points
     LaserPoint *points;
     LaserConfig config;/// Configuration of scan
@@ -205,6 +264,33 @@ typedef struct {
     string_t port[8];
 } LidarPort;
 
+/** Lidar discovery event */
+typedef enum {
+    DiscoveryAdded = 0,/**< first broadcast of a lidar */
+    DiscoveryChanged,/**< a known lidar broadcasts another ip, model or version */
+    DiscoveryRemoved,/**< no broadcast within the TTL */
+} DiscoveryEvent;
+
+/**
+  * @brief lidar heard on the broadcast port
+  */
+typedef struct {
+    string_t ip;/// address
+    string_t model;/// model
+    string_t hardware;/// hardware version
+    string_t software;/// firmware version
+    string_t serial;/// serial number, empty if the broadcast has none
+} DiscoveredLidar;
+
+/**
+ * @brief discovery event callback
+ * @note called from the discovery thread, it must return quickly
+ * @param event  added, changed or expired
+ * @param lidar  the lidar, its new values on DiscoveryChanged
+ * @param user   user data given when subscribing
+ */
+typedef void (*DiscoveryCallback)(DiscoveryEvent event, const DiscoveredLidar *lidar, void *user);
+
 /** The numeric version information struct.  */
 typedef struct {
     uint8_t hardware;   /**< Hardware version*/
@@ -216,6 +302,127 @@ typedef struct {
 
 #pragma pack()
 
+/** Buckets of LidarMetrics::decode_ns_buckets */
+#define LIDAR_METRICS_BUCKETS 16
+
+/**
+ * @brief Ingest pipeline counters, totals since the driver was created
+ * @note a packet is a datagram on the network, a DataFrame on a serial port
+ */
+typedef struct {
+    uint64_t stamp;             /**< getns() of the snapshot */
+    uint64_t packets;           /**< packets received from the lidar */
+    uint64_t bytes;             /**< bytes received from the lidar */
+    uint64_t sequence_gaps;     /**< packets dropped because of a sequence number gap */
+    uint64_t frame_errors;      /**< short packets, bad frame heads, lost serial alignment */
+    uint64_t foreign_packets;   /**< datagrams from another address, ignored */
+    uint64_t scans;             /**< revolutions published */
+    uint64_t scans_overwritten; /**< revolutions replaced before they were grabbed */
+    uint64_t scans_incomplete;  /**< revolutions published with ScanIncomplete */
+    uint64_t scans_truncated;   /**< revolutions published with ScanTruncated */
+    double packet_rate;         /**< packets per second over the last second */
+    double byte_rate;           /**< bytes per second over the last second */
+    uint64_t decode_count;      /**< decoded packets(network) or read chunks(serial) */
+    uint64_t decode_ns_sum;     /**< time spent decoding(ns) */
+    uint64_t decode_ns_max;     /**< longest decode(ns) */
+    /** decode times, bucket i counts the ones below 1024 << i ns, the last one all longer ones */
+    uint64_t decode_ns_buckets[LIDAR_METRICS_BUCKETS];
+    uint64_t scan_period_ns;    /**< filtered revolution period(ns), 0 until measured */
+    uint64_t scan_jitter_ns;    /**< mean deviation of the measured periods from scan_period_ns */
+    uint64_t scan_points;       /**< points of the last revolution */
+    double scan_frequency;      /**< 1e9 / scan_period_ns(Hz), 0 until measured */
+    double scan_speed_jitter;   /**< scan_jitter_ns / scan_period_ns, see ScanStats::speed_jitter */
+    double scan_max_gap;        /**< widest angular gap of the last revolution(degree) */
+    double scan_coverage;       /**< covered share of the last revolution, see ScanStats::coverage */
+} LidarMetrics;
+
+/**
+ * @brief Stages a revolution goes through, from the wire to the caller of doProcessSimple
+ */
+typedef enum {
+    TraceFirstReceive = 0,  /**< kernel receive of the first packet */
+    TraceLastReceive,       /**< kernel receive of the packet completing the revolution */
+    TraceDecoded,           /**< that packet decoded */
+    TraceAssembled,         /**< revolution assembled */
+    TracePublished,         /**< revolution handed over to the consumer */
+    TraceGrabbed,           /**< revolution grabbed by the consumer */
+    TraceConverted,         /**< LaserScan filled by doProcessSimple */
+    TraceStageCount,
+} TraceStage;
+
+/**
+ * @brief Timeline of one revolution
+ * @note stamps are getns(), 0 for a stage that was not recorded
+ */
+typedef struct {
+    uint64_t scan;                      /**< revolution number, LidarMetrics::scans at publication */
+    uint64_t stamp[TraceStageCount];    /**< indexed by TraceStage */
+} ScanTimeline;
+
+/**
+ * @brief Percentiles of a duration(ns)
+ */
+typedef struct {
+    uint64_t count;
+    uint64_t p50;
+    uint64_t p90;
+    uint64_t p99;
+    uint64_t p999;
+    uint64_t max;
+} LatencyPercentiles;
+
+/**
+ * @brief Latency of the revolutions converted since the lidar was initialized
+ */
+typedef struct {
+    /** stage[i] is the time from TraceStage i to TraceStage i + 1 */
+    LatencyPercentiles stage[TraceStageCount - 1];
+    /** TraceLastReceive to TraceConverted, the age of the newest point when the caller gets it */
+    LatencyPercentiles total;
+} ScanLatency;
+
+/**
+ * @brief Flags of a revolution, ScanStats::flags
+ */
+typedef enum {
+    ScanIncomplete = 0x01,  /**< packets were lost, or the revolution did not start at its zero crossing */
+    ScanTruncated = 0x02,   /**< the buffer filled up before the zero crossing, the rest follows as an incomplete revolution */
+} ScanFlag;
+
+/**
+ * @brief Motor speed and angular coverage of a revolution, measured by the assembler
+ * @note the period comes from the device stamps of the sync points, which are
+ * quantized to 1 ms: at 10 Hz about 0.3% of speed_jitter is the quantization.
+ */
+typedef struct {
+    uint64_t period;        /**< revolution period filtered over the last revolutions(ns), 0 until measured */
+    uint64_t jitter;        /**< mean deviation of the measured periods from period(ns) */
+    float frequency;        /**< 1e9 / period(Hz), 0 until measured */
+    float speed_jitter;     /**< jitter / period, motor stability: near 0 at constant speed, grows as the motor degrades */
+    uint32_t points;        /**< points of the revolution */
+    float max_gap;          /**< widest angle between neighbouring points, the wrap around included(degree) */
+    float coverage;         /**< share of the field of view covered at the configured point spacing, 1 without gaps */
+    uint32_t flags;         /**< ScanFlag bits, 0 for a complete revolution */
+} ScanStats;
+
+/**
+ * @brief Relation of the lidar clock to the host clock, estimated from the packet stamps
+ * @note host time is getTime(), the clock of the kernel receive stamps.\n
+ * host = device + offset + skew * (device - reference).\n
+ * The line is the lower envelope of the receive delays, so the fixed latency
+ * from the measurement to the receive stamp is not observable and left in.
+ */
+typedef struct {
+    uint64_t reference;     /**< device time the offset applies to(ns) */
+    int64_t offset;         /**< host time - device time at reference(ns) */
+    double skew;            /**< host clock rate over device clock rate - 1, 1e-6 is 1 ppm */
+    uint64_t error;         /**< spread of the minimum receive delays around the line(ns) */
+    uint64_t samples;       /**< packets accounted since the last resync, as of the last window */
+    uint32_t windows;       /**< minimum delay windows in the estimate */
+    uint32_t resyncs;       /**< restarts after a jump of either clock */
+    uint8_t synchronized;   /**< 1 once the skew is estimated, before that skew is 0 */
+} ClockSyncState;
+
 /**
  * @brief initialize LaserFan
  * @param to_init
@@ -42,6 +42,7 @@
 #pragma once
 #include "DriverInterface.h"
 #include "lidar_protocol.h"
+#include "AsyncLogger.h"
 #include <sstream>
 #include <vector>
 
@@ -324,12 +325,12 @@ inline void printHex(const uint8_t *data, int size)
     #define PURPLE             
 #endif
 
-#define LOG(Color, Severity, format, ...)  do{ printf(Color "[LIDAR SDK] [%s]> " COLOFF format "\n", #Severity, ##__VA_ARGS__); fflush(stdout); } while(0)
-#define LOGD(...) LOG(GREEN,  DEBUG,   __VA_ARGS__)
-#define LOGI(...) LOG(BLUE,   INFOR,   __VA_ARGS__)
-#define LOGW(...) LOG(YELLOW, WARRING, __VA_ARGS__)
-#define LOGE(...) LOG(RED,    ERROR,   __VA_ARGS__)
-#define LOGF(...) LOG(PURPLE, FALT,    __VA_ARGS__) 
+//formatted and written by the logger thread, see AsyncLogger
+#define LOGD(...) LIDAR_LOG(lidar::core::common::LogDebug, __VA_ARGS__)
+#define LOGI(...) LIDAR_LOG(lidar::core::common::LogInfo,  __VA_ARGS__)
+#define LOGW(...) LIDAR_LOG(lidar::core::common::LogWarn,  __VA_ARGS__)
+#define LOGE(...) LIDAR_LOG(lidar::core::common::LogError, __VA_ARGS__)
+#define LOGF(...) LIDAR_LOG(lidar::core::common::LogFatal, __VA_ARGS__)
 
 
 /// 短整型大小端互换
@@ -88,4 +88,6 @@ struct LidarListInfo {
     std::string hardware;
     /*! Hardware Device ID or "" if not available. */
     std::string software;
+    /*! Serial number or "" if the broadcast has none. */
+    std::string serial;
 };
@@ -57,7 +57,7 @@ CActiveSocket::CActiveSocket(CSocketType nType) : CSimpleSocket(nType) {
 // ConnectTCP() -
 //
 //------------------------------------------------------------------------------
-bool CActiveSocket::ConnectTCP(const char *pAddr, uint16_t nPort) {
+bool CActiveSocket::ConnectTCP(const char *pAddr, uint16_t nPort, bool bWait) {
   bool           bRetVal = false;
   struct in_addr stIpAddress;
   //------------------------------------------------------------------
@@ -114,7 +114,7 @@ bool CActiveSocket::ConnectTCP(const char *pAddr, uint16_t nPort) {
     if ((IsNonblocking()) &&
         ((GetSocketError() == CSimpleSocket::SocketEwouldblock) ||
          (GetSocketError() == CSimpleSocket::SocketEinprogress))) {
-      bRetVal = Select(GetConnectTimeoutSec(), GetConnectTimeoutUSec());
+      bRetVal = bWait ? Select(GetConnectTimeoutSec(), GetConnectTimeoutUSec()) : true;
     }
   } else {
     TranslateSocketError();
@@ -284,16 +284,83 @@ bool CActiveSocket::Open(const char *pAddr, uint16_t nPort) {
   // If successful then create a local copy of the address and port
   //--------------------------------------------------------------------------
   if (bRetVal) {
-    socklen_t nSockLen = sizeof(struct sockaddr);
+    ConnectDone();
+  }
+  return bRetVal;
+}
 
-    memset(&m_stServerSockaddr, 0, nSockLen);
-    getpeername(m_socket, (struct sockaddr *)&m_stServerSockaddr, &nSockLen);
+//------------------------------------------------------------------------------
+//
+// StartConnect() - Start a TCP connection without waiting for it
+//
+//------------------------------------------------------------------------------
+bool CActiveSocket::StartConnect(const char *pAddr, uint16_t nPort) {
+  if (IsSocketValid() == false) {
+    SetSocketError(CSimpleSocket::SocketInvalidSocket);
+    return false;
+  }
 
-    nSockLen = sizeof(struct sockaddr);
-    memset(&m_stClientSockaddr, 0, nSockLen);
-    getsockname(m_socket, (struct sockaddr *)&m_stClientSockaddr, &nSockLen);
+  if (pAddr == NULL) {
+    SetSocketError(CSimpleSocket::SocketInvalidAddress);
+    return false;
+  }
+
+  if (nPort == 0) {
+    SetSocketError(CSimpleSocket::SocketInvalidPort);
+    return false;
+  }
 
-    SetSocketError(SocketSuccess);
+  if (m_nSocketType != CSimpleSocket::SocketTypeTcp || !IsNonblocking()) {
+    SetSocketError(CSimpleSocket::SocketProtocolError);
+    return false;
   }
-  return bRetVal;
+
+  return ConnectTCP(pAddr, nPort, false);
+}
+
+//------------------------------------------------------------------------------
+//
+// FinishConnect() - Complete a connection started by StartConnect()
+//
+//------------------------------------------------------------------------------
+bool CActiveSocket::FinishConnect() {
+  int32_t nError = 0;
+  int32_t nLen = sizeof(nError);
+
+  if (IsSocketValid() == false) {
+    SetSocketError(CSimpleSocket::SocketInvalidSocket);
+    return false;
+  }
+
+  if (GETSOCKOPT(m_socket, SOL_SOCKET, SO_ERROR, &nError, &nLen) != 0) {
+    TranslateSocketError();
+    return false;
+  }
+
+  if (nError != 0) {
+    errno = nError;
+    TranslateSocketError();
+    return false;
+  }
+
+  ConnectDone();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+//
+// ConnectDone() - Keep the addresses of a connection made
+//
+//------------------------------------------------------------------------------
+void CActiveSocket::ConnectDone() {
+  socklen_t nSockLen = sizeof(struct sockaddr);
+
+  memset(&m_stServerSockaddr, 0, nSockLen);
+  getpeername(m_socket, (struct sockaddr *)&m_stServerSockaddr, &nSockLen);
+
+  nSockLen = sizeof(struct sockaddr);
+  memset(&m_stClientSockaddr, 0, nSockLen);
+  getsockname(m_socket, (struct sockaddr *)&m_stClientSockaddr, &nSockLen);
+
+  SetSocketError(SocketSuccess);
 }
@@ -75,10 +75,25 @@ class CActiveSocket : public CSimpleSocket {
   ///  @return true if successful connection made, otherwise false.
   virtual bool Open(const char *pAddr, uint16_t nPort);
 
+  /// Start a TCP connection on a nonblocking socket without waiting for it.
+  /// Once the socket is writable the connection is completed by FinishConnect().
+  ///  @param pAddr specifies the destination address to connect.
+  ///  @param nPort specifies the destination port.
+  ///  @return true if the connection is made or in progress, otherwise false.
+  bool StartConnect(const char *pAddr, uint16_t nPort);
+
+  /// Complete a connection started by StartConnect().
+  ///  @return true if the connection is made, otherwise false.
+  bool FinishConnect();
+
  private:
   /// Utility function used to create a TCP connection, called from Open().
+  ///  @param bWait wait for a nonblocking connection in progress.
   ///  @return true if successful connection made, otherwise false.
-  bool ConnectTCP(const char *pAddr, uint16_t nPort);
+  bool ConnectTCP(const char *pAddr, uint16_t nPort, bool bWait = true);
+
+  /// Keep the addresses of a connection made.
+  void ConnectDone();
 
   /// Utility function used to create a UDP connection, called from Open().
   ///  @return true if successful connection made, otherwise false.
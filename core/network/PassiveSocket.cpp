@@ -313,3 +313,28 @@ int32_t CPassiveSocket::Send(const uint8_t *pBuf, size_t bytesToSend) {
 
   return m_nBytesSent;
 }
+
+
+//------------------------------------------------------------------------------
+//
+// SetDestination() -
+//
+//------------------------------------------------------------------------------
+bool CPassiveSocket::SetDestination(const char *pAddr, uint16_t nPort) {
+#if defined(_WIN32)
+  ULONG          inAddr;
+#else
+  in_addr_t      inAddr;
+#endif
+
+  if ((pAddr == NULL) || ((inAddr = inet_addr(pAddr)) == INADDR_NONE)) {
+    SetSocketError(SocketInvalidAddress);
+    return false;
+  }
+
+  memset(&m_stClientSockaddr, 0, sizeof(m_stClientSockaddr));
+  m_stClientSockaddr.sin_family = AF_INET;
+  m_stClientSockaddr.sin_addr.s_addr = inAddr;
+  m_stClientSockaddr.sin_port = htons(nPort);
+  return true;
+}
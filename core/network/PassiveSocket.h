@@ -117,6 +117,13 @@ class CPassiveSocket : public CSimpleSocket {
   /// CSimpleSocket::SocketTypeUdp
   virtual int32_t Send(const uint8_t *pBuf, size_t bytesToSend);
 
+  /// Set the peer the datagrams of a bound UDP socket are sent to, replies
+  /// otherwise go to the sender of the last received datagram.
+  /// @param pAddr IPv4 address of the peer.
+  /// @param nPort port of the peer.
+  /// @return true if the address is valid.
+  bool SetDestination(const char *pAddr, uint16_t nPort);
+
  private:
   struct ip_mreq  m_stMulticastRequest;   /// group address for multicast
 
@@ -41,6 +41,7 @@
  * OF THE POSSIBILITY OF SUCH DAMAGE.
  *----------------------------------------------------------------------------*/
 #include "SimpleSocket.h"
+#include <core/base/timer.h>
 using namespace lidar;
 using namespace lidar::core;
 using namespace lidar::core::network;
@@ -350,6 +351,35 @@ bool CSimpleSocket::SetMulticast(bool bEnable, uint8_t multicastTTL) {
 }
 
 
+//------------------------------------------------------------------------------
+//
+// SetReceiveTimestamp()
+//
+//------------------------------------------------------------------------------
+bool CSimpleSocket::SetReceiveTimestamp(bool bEnable) {
+  bool bRetVal = false;
+  m_nReceiveTimestamp = 0;
+
+  if (GetSocketType() == CSimpleSocket::SocketTypeUdp) {
+    m_bReceiveTimestamp = bEnable;
+#if defined(__linux__) && defined(SO_TIMESTAMPNS)
+    int32_t nEnable = bEnable ? 1 : 0;
+
+    if (SETSOCKOPT(m_socket, SOL_SOCKET, SO_TIMESTAMPNS, &nEnable,
+                   sizeof(nEnable)) == SocketError) {
+      TranslateSocketError();
+    } else {
+      bRetVal = true;
+    }
+#endif
+  } else {
+    m_socketErrno = CSimpleSocket::SocketProtocolError;
+  }
+
+  return bRetVal;
+}
+
+
 //------------------------------------------------------------------------------
 //
 // SetSocketDscp()
@@ -898,6 +928,8 @@ int32_t CSimpleSocket::Receive(int32_t nMaxBytes, uint8_t *pBuffer) {
           break;
         }
 
+        //errno is only set on failure, a stale EAGAIN would discard the data
+        errno = 0;
         m_nBytesReceived = RECV(m_socket, (pWorkBuffer + m_nBytesReceived),
                                 nMaxBytes, m_nFlags);
         TranslateSocketError();
@@ -954,11 +986,43 @@ int32_t CSimpleSocket::Receive(int32_t nMaxBytes, uint8_t *pBuffer) {
             SetSocketError(CSimpleSocket::SocketTimedout);
             break;
           }
+          m_nReceiveTimestamp = 0;
+#if defined(__linux__) && defined(SO_TIMESTAMPNS)
+          if (m_bReceiveTimestamp) {
+            struct iovec iov;
+            struct msghdr msg;
+            char control[CMSG_SPACE(sizeof(struct timespec))];
+            iov.iov_base = pWorkBuffer;
+            iov.iov_len = nMaxBytes;
+            memset(&msg, 0, sizeof(msg));
+            msg.msg_name = &m_stClientSockaddr;
+            msg.msg_namelen = srcSize;
+            msg.msg_iov = &iov;
+            msg.msg_iovlen = 1;
+            msg.msg_control = control;
+            msg.msg_controllen = sizeof(control);
+            m_nBytesReceived = recvmsg(m_socket, &msg, 0);
+
+            for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); m_nBytesReceived > 0 && cmsg;
+                 cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+              if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+                struct timespec ts;
+                memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+                m_nReceiveTimestamp = (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+              }
+            }
+          } else
+#endif
           m_nBytesReceived = RECVFROM(m_socket, pWorkBuffer, nMaxBytes, 0,
                                       &m_stClientSockaddr, &srcSize);                                
 
           TranslateSocketError();
 
+          //no kernel timestamp, the time the datagram was handed over
+          if (m_bReceiveTimestamp && m_nBytesReceived > 0 && m_nReceiveTimestamp == 0) {
+            m_nReceiveTimestamp = getTime();
+          }
+
           if (m_nBytesReceived >= nMaxBytes) {
             break;
           }
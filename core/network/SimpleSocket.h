@@ -404,6 +404,18 @@ class CSimpleSocket : public ChannelDevice {
     return m_bIsMulticast;
   };
 
+  /// Enable/disable receive timestamps for a socket of type
+  /// CSimpleSocket::SocketTypeUdp. On Linux the kernel receive time is
+  /// used (SO_TIMESTAMPNS), elsewhere the time Receive returned.
+  /// @return true if the kernel timestamps could be enabled
+  bool SetReceiveTimestamp(bool bEnable);
+
+  /// Receive time of the last datagram, valid after SetReceiveTimestamp(true).
+  /// @return realtime clock in nanoseconds, 0 if unknown
+  uint64_t GetReceiveTimestamp() {
+    return m_nReceiveTimestamp;
+  };
+
   /// Bind socket to a specific interface when using multicast.
   /// @return true if successfully bound to interface
   bool BindInterface(const char *pInterface);
@@ -481,6 +493,11 @@ class CSimpleSocket : public ChannelDevice {
     return inet_ntoa(m_stClientSockaddr.sin_addr);
   };
 
+  /// Returns the client address of the last datagram or connection.
+  const struct sockaddr_in &GetClientSockaddr() {
+    return m_stClientSockaddr;
+  };
+
   /// Returns the port number on which the client is connected.
   ///  @return client port number.
   uint16_t GetClientPort() {
@@ -662,6 +679,8 @@ class CSimpleSocket : public ChannelDevice {
   uint32_t             m_nFlags;            /// socket flags
   bool                 m_bIsBlocking;       /// is socket blocking
   bool                 m_bIsMulticast = false;      /// is the UDP socket multicast;
+  bool                 m_bReceiveTimestamp = false; /// receive timestamps requested
+  uint64_t             m_nReceiveTimestamp = 0;     /// receive time of the last datagram(ns)
   struct timeval       m_stConnectTimeout;  /// connection timeout
   struct timeval       m_stRecvTimeout;     /// receive timeout
   struct timeval       m_stSendTimeout;     /// send timeout
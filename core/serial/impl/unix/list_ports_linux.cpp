@@ -24,6 +24,7 @@
 #include <unistd.h>
 
 #include <core/serial/serial.h>
+#include "list_ports_linux.h"
 using namespace lidar::core;
 using lidar::core::serial::PortInfo;
 using std::istringstream;
@@ -301,32 +302,32 @@ serial::list_ports() {
   while (iter != devices_found.end()) {
     string device = *iter++;
 
-    vector<string> sysfs_info = get_sysfs_info(device);
+    PortInfo device_entry = serial::describe_port(device);
 
-    string friendly_name = sysfs_info[0];
-
-    string hardware_id = sysfs_info[1];
-
-    string device_id = sysfs_info[2];
-
-    std::size_t found = hardware_id.find("10c4:ea60");
-    std::size_t found1 = hardware_id.find("0483:5740");
-
-
-    if (found != std::string::npos || found1 != std::string::npos) {
-      PortInfo device_entry;
-      device_entry.port = device;
-      device_entry.description = friendly_name;
-      device_entry.hardware_id = hardware_id;
-      device_entry.device_id = device_id;
+    if (serial::is_lidar_adapter(device_entry)) {
       results.push_back(device_entry);
     }
+  }
 
+  return results;
+}
 
+PortInfo
+serial::describe_port(const string &device) {
+  vector<string> sysfs_info = get_sysfs_info(device);
 
-  }
+  PortInfo device_entry;
+  device_entry.port = device;
+  device_entry.description = sysfs_info[0];
+  device_entry.hardware_id = sysfs_info[1];
+  device_entry.device_id = sysfs_info[2];
+  return device_entry;
+}
 
-  return results;
+bool
+serial::is_lidar_adapter(const PortInfo &port) {
+  return port.hardware_id.find("10c4:ea60") != std::string::npos ||
+         port.hardware_id.find("0483:5740") != std::string::npos;
 }
 
 #endif // defined(__linux__)
@@ -0,0 +1,24 @@
+#pragma once
+#if defined(__linux__)
+#include <string>
+#include <core/serial/serial.h>
+
+namespace lidar {
+namespace core {
+namespace serial {
+
+/*!
+* Describe one serial device from sysfs, as list_ports does for every port.
+*/
+PortInfo describe_port(const std::string &device);
+
+/*!
+* true for the USB adapters list_ports reports (CP210x, STM32 VCP).
+*/
+bool is_lidar_adapter(const PortInfo &port);
+
+} // namespace serial
+}// namespace core
+}// namespace lidar
+
+#endif // defined(__linux__)
@@ -0,0 +1,319 @@
+#if defined(__linux__)
+
+#include <map>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cerrno>
+
+#include <glob.h>
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/inotify.h>
+#include <linux/netlink.h>
+
+#include <core/serial/port_monitor.h>
+#include <core/base/thread.h>
+#include <core/base/locker.h>
+#include <core/base/stop_token.h>
+#include "list_ports_linux.h"
+
+using std::map;
+using std::vector;
+using std::string;
+using lidar::core::base::Thread;
+using lidar::core::base::thread_attr;
+using lidar::core::base::Locker;
+using lidar::core::base::ScopedLocker;
+using lidar::core::base::StopToken;
+
+namespace lidar {
+namespace core {
+namespace serial {
+
+static bool is_usb_tty(const char *name) {
+  return strncmp(name, "ttyUSB", 6) == 0 || strncmp(name, "ttyACM", 6) == 0;
+}
+
+class PortMonitor::MonitorImpl {
+ public:
+  MonitorImpl()
+    : callback_(NULL)
+    , user_(NULL)
+    , nl_fd_(-1)
+    , in_fd_(-1) {
+  }
+
+  ~MonitorImpl() {
+    stop();
+  }
+
+  bool start() {
+    if (isRunning()) {
+      return true;
+    }
+
+    // kernel uevents, the /dev node exists when they arrive (devtmpfs)
+    nl_fd_ = ::socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_KOBJECT_UEVENT);
+
+    if (nl_fd_ != -1) {
+      sockaddr_nl addr;
+      memset(&addr, 0, sizeof(addr));
+      addr.nl_family = AF_NETLINK;
+      addr.nl_groups = 1;
+
+      if (::bind(nl_fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == -1) {
+        ::close(nl_fd_);
+        nl_fd_ = -1;
+      }
+    }
+
+    // /dev as well: in containers the bind succeeds but no uevent ever arrives
+    in_fd_ = ::inotify_init1(IN_CLOEXEC);
+
+    if (in_fd_ != -1 &&
+        ::inotify_add_watch(in_fd_, "/dev", IN_CREATE | IN_DELETE) == -1) {
+      ::close(in_fd_);
+      in_fd_ = -1;
+    }
+
+    if (!isRunning() || stop_.fd() == -1) {
+      stop();
+      return false;
+    }
+
+    // subscribed first, so no device is missed between the scan and the loop
+    {
+      ScopedLocker lock(lock_);
+      ports_.clear();
+      glob_t found;
+      memset(&found, 0, sizeof(found));
+      ::glob("/dev/ttyUSB*", 0, NULL, &found);
+      ::glob("/dev/ttyACM*", GLOB_APPEND, NULL, &found);
+
+      // same table as list_ports(), whether or not the monitor runs
+      for (size_t i = 0; i < found.gl_pathc; i++) {
+        PortInfo info = describe_port(found.gl_pathv[i]);
+
+        if (is_lidar_adapter(info)) {
+          ports_[found.gl_pathv[i]] = info;
+        }
+      }
+
+      ::globfree(&found);
+    }
+
+    stop_.reset();
+    thread_attr attr("lidar-portmon");
+    thread_ = CLASS_THREAD_ATTR(MonitorImpl, monitorLoop, attr);
+
+    if (thread_.getHandle() == 0) {
+      stop();
+      return false;
+    }
+
+    return true;
+  }
+
+  void stop() {
+    stop_.requestStop();
+    thread_.join();
+
+    if (nl_fd_ != -1) {
+      ::close(nl_fd_);
+      nl_fd_ = -1;
+    }
+
+    if (in_fd_ != -1) {
+      ::close(in_fd_);
+      in_fd_ = -1;
+    }
+  }
+
+  bool isRunning() const {
+    return nl_fd_ != -1 || in_fd_ != -1;
+  }
+
+  int monitorLoop() {
+    char buf[4096] __attribute__((aligned(__alignof__(inotify_event))));
+
+    while (!stop_.stopRequested()) {
+      // a closed source is -1 and ignored by poll()
+      pollfd fds[3] = {{stop_.fd(), POLLIN, 0}, {nl_fd_, POLLIN, 0}, {in_fd_, POLLIN, 0}};
+      int r = ::poll(fds, 3, -1);
+
+      if (r < 0 && errno != EINTR) {
+        break;
+      }
+
+      if (r <= 0) {
+        continue;
+      }
+
+      if (fds[0].revents || stop_.stopRequested()) {
+        break;
+      }
+
+      if (fds[1].revents) {
+        // also on POLLERR, recvmsg() clears an ENOBUFS overrun
+        // only the kernel itself is trusted
+        sockaddr_nl addr;
+        iovec iov = {buf, sizeof(buf) - 1};
+        msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_name = &addr;
+        msg.msg_namelen = sizeof(addr);
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        ssize_t len = ::recvmsg(nl_fd_, &msg, 0);
+
+        if (len > 0 && addr.nl_pid == 0) {
+          buf[len] = 0;
+          parseUevent(buf, len);
+        }
+      }
+
+      if (fds[2].revents & POLLIN) {
+        ssize_t len = ::read(in_fd_, buf, sizeof(buf));
+
+        for (ssize_t pos = 0; pos + (ssize_t)sizeof(inotify_event) <= len;) {
+          const inotify_event *event = reinterpret_cast<const inotify_event *>(buf + pos);
+
+          if (event->len > 0 && is_usb_tty(event->name)) {
+            update(event->mask & IN_CREATE, event->name);
+          }
+
+          pos += sizeof(inotify_event) + event->len;
+        }
+      }
+    }
+
+    return 0;
+  }
+
+  /// "ACTION@DEVPATH\0KEY=VALUE\0..."
+  void parseUevent(const char *buf, size_t len) {
+    const char *action = NULL;
+    const char *subsystem = NULL;
+    const char *devname = NULL;
+
+    for (size_t pos = strlen(buf) + 1; pos < len; pos += strlen(buf + pos) + 1) {
+      const char *line = buf + pos;
+
+      if (strncmp(line, "ACTION=", 7) == 0) {
+        action = line + 7;
+      } else if (strncmp(line, "SUBSYSTEM=", 10) == 0) {
+        subsystem = line + 10;
+      } else if (strncmp(line, "DEVNAME=", 8) == 0) {
+        devname = line + 8;
+      }
+    }
+
+    if (!action || !subsystem || !devname || strcmp(subsystem, "tty") != 0 ||
+        !is_usb_tty(devname)) {
+      return;
+    }
+
+    if (strcmp(action, "add") == 0) {
+      update(true, devname);
+    } else if (strcmp(action, "remove") == 0) {
+      update(false, devname);
+    }
+  }
+
+  void update(bool added, const char *name) {
+    string port = string("/dev/") + name;
+    PortInfo info;
+    {
+      ScopedLocker lock(lock_);
+      map<string, PortInfo>::iterator it = ports_.find(port);
+
+      if (added) {
+        // netlink and inotify both report a port, the second one is dropped
+        if (it != ports_.end()) {
+          return;
+        }
+
+        // the sysfs device is complete when the uevent is sent
+        info = describe_port(port);
+
+        if (!is_lidar_adapter(info)) {
+          return;
+        }
+
+        ports_[port] = info;
+      } else {
+        if (it == ports_.end()) {
+          return;
+        }
+
+        info = it->second;
+        ports_.erase(it);
+      }
+    }
+
+    if (callback_) {
+      callback_(added ? PortAdded : PortRemoved, info, user_);
+    }
+  }
+
+  PortEventCallback callback_;
+  void *user_;
+  int nl_fd_;                       // kernel uevents, -1 if unavailable
+  int in_fd_;                       // inotify on /dev, -1 if unavailable
+  StopToken stop_;                  // stop() -> monitor thread
+  Thread thread_;
+  mutable Locker lock_;
+  map<string, PortInfo> ports_;
+};
+
+
+PortMonitor::PortMonitor()
+  : pimpl_(new MonitorImpl()) {
+}
+
+PortMonitor::~PortMonitor() {
+  delete pimpl_;
+}
+
+void PortMonitor::setCallback(PortEventCallback callback, void *user) {
+  pimpl_->callback_ = callback;
+  pimpl_->user_ = user;
+}
+
+bool PortMonitor::start() {
+  return pimpl_->start();
+}
+
+void PortMonitor::stop() {
+  pimpl_->stop();
+}
+
+bool PortMonitor::isRunning() const {
+  return pimpl_->isRunning();
+}
+
+vector<PortInfo> PortMonitor::ports() const {
+  ScopedLocker lock(pimpl_->lock_);
+  vector<PortInfo> result;
+
+  for (map<string, PortInfo>::const_iterator it = pimpl_->ports_.begin();
+       it != pimpl_->ports_.end(); ++it) {
+    result.push_back(it->second);
+  }
+
+  return result;
+}
+
+bool PortMonitor::hasPort(const string &port) const {
+  ScopedLocker lock(pimpl_->lock_);
+  return pimpl_->ports_.find(port) != pimpl_->ports_.end();
+}
+
+} // namespace serial
+}// namespace core
+}// namespace lidar
+
+#endif // defined(__linux__)
@@ -973,6 +973,99 @@ int Serial::SerialImpl::waitfordata(size_t data_count, uint32_t timeout,
 }
 
 
+int Serial::SerialImpl::readStream(uint8_t *buf, size_t size, uint32_t timeout,
+                                   size_t *returned_size, int wake_fd) {
+  size_t length = 0;
+
+  if (returned_size == NULL) {
+    returned_size = &length;
+  }
+
+  *returned_size = 0;
+
+  if (!is_open_) {
+    return -2;
+  }
+
+  // No inter-byte timer and no byte time sleeps: whatever the driver has
+  // is taken in one call, otherwise block until the next byte lands.
+  // With VMIN = VTIME = 0 an empty port reads 0 rather than EAGAIN.
+  ssize_t bytes_read_now = ::read(fd_, buf, size);
+
+  if (bytes_read_now == 0 ||
+      (bytes_read_now < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))) {
+    pollfd pfd[2] = {{ fd_, POLLIN, 0 }, { wake_fd, POLLIN, 0 }};
+    int r = ::poll(pfd, wake_fd == -1 ? 1 : 2, static_cast<int>(timeout));
+
+    if (r == 0 || (r < 0 && errno == EINTR)) {
+      return -1;
+    }
+
+    if (r < 0 || (pfd[0].revents & (POLLERR | POLLHUP | POLLNVAL))) {
+      return -2;
+    }
+
+    if (pfd[1].revents) {
+      return -3;
+    }
+
+    bytes_read_now = ::read(fd_, buf, size);
+  }
+
+  if (bytes_read_now == 0 ||
+      (bytes_read_now < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))) {
+    // Readable without data or interrupted: a hangup is reported by poll()
+    return -1;
+  }
+
+  if (bytes_read_now < 0) {
+    // EIO, ENXIO: the device is gone
+    return -2;
+  }
+
+  *returned_size = static_cast<size_t>(bytes_read_now);
+  return 0;
+}
+
+
+bool Serial::SerialImpl::setLowLatency(bool enable) {
+  if (!is_open_) {
+    return false;
+  }
+
+  // Reads never block in the driver, poll() does the waiting
+  termios tio;
+
+  if (getTermios(&tio) && (tio.c_cc[VMIN] != 0 || tio.c_cc[VTIME] != 0)) {
+    tio.c_cc[VMIN] = 0;
+    tio.c_cc[VTIME] = 0;
+    setTermios(&tio);
+  }
+
+#if defined(__linux__) && !defined(__ANDROID__)
+  // USB adapters then hand over every USB frame instead of waiting
+  // for their latency timer (16ms on FTDI)
+  struct serial_struct serial;
+  ::memset(&serial, 0, sizeof(serial));
+
+  if (::ioctl(fd_, TIOCGSERIAL, &serial) == -1) {
+    return false;
+  }
+
+  if (enable) {
+    serial.flags |= ASYNC_LOW_LATENCY;
+  } else {
+    serial.flags &= ~ASYNC_LOW_LATENCY;
+  }
+
+  return ::ioctl(fd_, TIOCSSERIAL, &serial) != -1;
+#else
+  (void)enable;
+  return false;
+#endif
+}
+
+
 void Serial::SerialImpl::waitByteTimes(size_t count) {
   timespec wait_time = { 0, static_cast<long>(byte_time_ns_ * count)};
   pselect(0, NULL, NULL, NULL, &wait_time, NULL);
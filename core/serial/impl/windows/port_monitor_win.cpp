@@ -0,0 +1,57 @@
+#if defined(_WIN32)
+#include <core/serial/port_monitor.h>
+
+using std::vector;
+using std::string;
+
+namespace lidar {
+namespace core {
+namespace serial {
+
+// Device notifications need a window on Windows, ports are listed on demand.
+class PortMonitor::MonitorImpl {
+};
+
+PortMonitor::PortMonitor()
+  : pimpl_(new MonitorImpl()) {
+}
+
+PortMonitor::~PortMonitor() {
+  delete pimpl_;
+}
+
+void PortMonitor::setCallback(PortEventCallback /*callback*/, void * /*user*/) {
+}
+
+bool PortMonitor::start() {
+  return false;
+}
+
+void PortMonitor::stop() {
+}
+
+bool PortMonitor::isRunning() const {
+  return false;
+}
+
+vector<PortInfo> PortMonitor::ports() const {
+  return list_ports();
+}
+
+bool PortMonitor::hasPort(const string &port) const {
+  vector<PortInfo> lst = list_ports();
+
+  for (vector<PortInfo>::const_iterator it = lst.begin(); it != lst.end(); ++it) {
+    if (it->port == port) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+} // namespace serial
+}// namespace core
+}// namespace lidar
+
+#endif // defined(_WIN32)
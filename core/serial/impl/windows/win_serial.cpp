@@ -1,5 +1,6 @@
 #if defined(_WIN32)
 #include "win_serial.h"
+#include <algorithm>
 
 namespace lidar {
 namespace core {
@@ -581,6 +582,29 @@ void Serial::SerialImpl::waitByteTimes(size_t /*count*/) {
   return ;
 }
 
+int Serial::SerialImpl::readStream(uint8_t *buf, size_t size, uint32_t timeout,
+                                   size_t *returned_size, int /*wake_fd*/) {
+  size_t length = 0;
+
+  if (returned_size == NULL) {
+    returned_size = &length;
+  }
+
+  int ans = waitfordata(1, timeout, returned_size);
+
+  if (ans != 0) {
+    *returned_size = 0;
+    return ans;
+  }
+
+  *returned_size = read(buf, (std::min)(size, *returned_size));
+  return *returned_size > 0 ? 0 : -2;
+}
+
+bool Serial::SerialImpl::setLowLatency(bool /*enable*/) {
+  return false;
+}
+
 int  Serial::SerialImpl::waitfordata(size_t data_count, uint32_t timeout,
                                      size_t *returned_size) {
   if (!is_open_) {
@@ -53,6 +53,11 @@ class Serial::SerialImpl {
 
   int waitfordata(size_t data_count, uint32_t timeout, size_t *returned_size);
 
+  int readStream(uint8_t *buf, size_t size, uint32_t timeout, size_t *returned_size,
+                 int wake_fd);
+
+  bool setLowLatency(bool enable);
+
   size_t read(uint8_t *buf, size_t size = 1);
 
   size_t write(const uint8_t *data, size_t length);
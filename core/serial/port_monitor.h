@@ -0,0 +1,67 @@
+#ifndef SERIAL_PORT_MONITOR_H
+#define SERIAL_PORT_MONITOR_H
+
+#include <vector>
+#include <string>
+#include <core/serial/serial.h>
+
+namespace lidar {
+namespace core {
+namespace serial {
+
+/*!
+* Event driven view of the USB serial ports (ttyUSB*, ttyACM*).
+*
+* The device table is read from sysfs once by start(), then kept up to date
+* from kernel uevents (netlink) and from /dev changes (inotify), which keeps
+* working where uevents are not delivered, so nothing is polled. Plug and unplug are reported to
+* the callback from the monitor thread within milliseconds.
+*/
+class PortMonitor {
+ public:
+  typedef enum {
+    PortAdded,
+    PortRemoved
+  } PortEvent;
+
+  /*! Called from the monitor thread, must not call stop(). */
+  typedef void (*PortEventCallback)(PortEvent event, const PortInfo &port,
+                                    void *user);
+
+  PortMonitor();
+
+  ~PortMonitor();
+
+  /*! Set before start(). */
+  void setCallback(PortEventCallback callback, void *user);
+
+  /*!
+  * Fill the device table and start watching.
+  * \return false if neither netlink nor inotify is available
+  */
+  bool start();
+
+  void stop();
+
+  bool isRunning() const;
+
+  /*! Ports currently present, from the cached table. */
+  std::vector<PortInfo> ports() const;
+
+  /*! Whether a port path is currently present, from the cached table. */
+  bool hasPort(const std::string &port) const;
+
+ private:
+  // Disable copy constructors
+  PortMonitor(const PortMonitor &);
+  PortMonitor &operator=(const PortMonitor &);
+
+  class MonitorImpl;
+  MonitorImpl *pimpl_;
+};
+
+} // namespace serial
+}// namespace core
+}// namespace lidar
+
+#endif // SERIAL_PORT_MONITOR_H
@@ -105,6 +105,16 @@ int Serial::waitfordata(size_t data_count, uint32_t timeout,
   return pimpl_->waitfordata(data_count, timeout, returned_size);
 }
 
+int Serial::readStream(uint8_t *data, size_t size, uint32_t timeout,
+            size_t *returned_size, int wake_fd) {
+  ScopedReadLock lock(this->pimpl_);
+  return pimpl_->readStream(data, size, timeout, returned_size, wake_fd);
+}
+
+bool Serial::setLowLatency(bool enable) {
+  return pimpl_->setLowLatency(enable);
+}
+
 size_t Serial::writeData(const uint8_t *data, size_t size) {
   return write(data, size);
 }
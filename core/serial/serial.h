@@ -233,6 +233,31 @@ class Serial : public ChannelDevice {
   virtual int waitfordata(size_t data_count, uint32_t timeout,
                           size_t *returned_size);
 
+  /**
+   * @brief Streaming receive: returns as soon as any data has landed. \n
+   * Everything the driver holds is taken in one read, without the inter-byte
+   * timeout and byte time waits of ::read, so the latency is that of the
+   * port itself (one USB frame with ::setLowLatency).
+   * @param data buffer of at least size bytes
+   * @param size buffer size
+   * @param timeout longest wait for the first byte(ms)
+   * @param returned_size bytes read
+   * @param wake_fd descriptor that ends the wait once readable, -1 for none
+   * (ignored on Windows)
+   * @return 0 on data, -1 on timeout, -2 if the port failed or was unplugged,
+   * -3 if woken by wake_fd
+   */
+  int readStream(uint8_t *data, size_t size, uint32_t timeout,
+                 size_t *returned_size, int wake_fd = -1);
+
+  /**
+   * @brief Ask the driver to deliver received bytes immediately \n
+   * Sets ASYNC_LOW_LATENCY on Linux, USB adapters then skip their latency
+   * timer. Must be called after ::open.
+   * @return false if the driver has no such setting
+   */
+  bool setLowLatency(bool enable = true);
+
 
   /*! Write a string to the serial port.
   *
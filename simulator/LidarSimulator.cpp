@@ -0,0 +1,335 @@
+#include "LidarSimulator.h"
+#include <core/base/timer.h>
+#include <core/common/lidar_help.h>
+#include <core/tools/cJSON.h>
+#include <math.h>
+#include <stdlib.h>
+#include <chrono>
+#include <thread>
+
+namespace lidar {
+
+/// JSON name of a LidarConfig field, as the driver sends it
+static std::string registerName(const char *descriptor) {
+    char name[64] = {0};
+    strncpy(name, descriptor, sizeof(name) - 1);
+    valLastName(name);
+    return name;
+}
+
+
+LidarSimulator::LidarSimulator(const simulator_config &config)
+    : m_config(config)
+    , m_listener(CSimpleSocket::SocketTypeTcp)
+    , m_client(NULL)
+    , m_dataSocket(CSimpleSocket::SocketTypeUdp)
+    , m_listSocket(CSimpleSocket::SocketTypeUdp)
+    , m_StopEvent(false, false)
+    , m_running(false)
+    , m_online(true)
+    , m_scanning(false)
+    , m_packets(0)
+    , m_commands(0)
+    , m_angle(0)
+    , m_sequence(0) {
+    if (m_config.serial.empty()) {
+        m_config.serial = "SIM" + m_config.ip;
+    }
+
+    m_registers[registerName(valName(regs.samplerate))] = m_config.samplerate;
+    m_registers[registerName(valName(regs.motorSpeed))] = m_config.motor_speed;
+    m_registers[registerName(valName(regs.angleCompensation))] = 0;
+    m_registers[registerName(valName(regs.isMultiPoint))] = 0;
+    m_registers[registerName(valName(regs.APD))] = 0;
+    m_registers[registerName(valName(regs.LD))] = 0;
+    m_registers[registerName(valName(regs.distanceCompensation))] = 0;
+    m_registers[registerName(valName(regs.measureMode))] = 0;
+    m_registers[registerName(valName(regs.calMode))] = 0;
+    m_registers[registerName(valName(regs.heartbeat))] = 1;
+    m_registers[registerName(valName(regs.scanType))] = -1;
+    m_registers[registerName(valName(regs.restart))] = 0;
+}
+
+
+LidarSimulator::~LidarSimulator() {
+    stop();
+}
+
+
+bool LidarSimulator::start() {
+    if (m_running) {
+        return true;
+    }
+    if (!openConfigPort()) {
+        LOGE("Simulator %s cannot open %s:%u", m_config.ip.c_str(), m_config.ip.c_str(), m_config.cmd_port);
+        return false;
+    }
+    //the source address of the datagrams identifies the lidar
+    if (!m_dataSocket.Initialize() || !m_dataSocket.Listen(m_config.ip.c_str(), 0) ||
+        !m_dataSocket.SetDestination(m_config.host.c_str(), m_config.data_port)) {
+        LOGE("Simulator %s cannot open its data socket", m_config.ip.c_str());
+        closeConfigPort();
+        m_dataSocket.Close();
+        return false;
+    }
+    if (m_config.list_port != 0) {
+        if (!m_listSocket.Initialize() || !m_listSocket.Listen(m_config.ip.c_str(), 0) ||
+            !m_listSocket.SetDestination(m_config.host.c_str(), m_config.list_port)) {
+            LOGW("Simulator %s does not broadcast", m_config.ip.c_str());
+            m_listSocket.Close();
+        }
+    }
+
+    m_running = true;
+    m_StopEvent.set(false);
+    m_ConfigThread = CLASS_THREAD(LidarSimulator, configLoop);
+    m_DataThread = CLASS_THREAD(LidarSimulator, dataLoop);
+    return true;
+}
+
+
+void LidarSimulator::stop() {
+    if (!m_running) {
+        return;
+    }
+    m_running = false;
+    m_StopEvent.set();
+    m_ConfigThread.join();
+    m_DataThread.join();
+    closeConfigPort();
+    m_dataSocket.Close();
+    m_listSocket.Close();
+    m_scanning = false;
+}
+
+
+void LidarSimulator::setOnline(bool online) {
+    m_online = online;
+}
+
+
+bool LidarSimulator::openConfigPort() {
+    if (m_listener.IsSocketValid()) {
+        return true;
+    }
+    if (!m_listener.Initialize() || !m_listener.Listen(m_config.ip.c_str(), m_config.cmd_port)) {
+        m_listener.Close();
+        return false;
+    }
+    //accept is polled, the loop also serves the connection and the broadcasts
+    m_listener.SetNonblocking();
+    return true;
+}
+
+
+void LidarSimulator::closeConfigPort() {
+    dropClient();
+    m_listener.Close();
+}
+
+
+void LidarSimulator::dropClient() {
+    if (m_client) {
+        m_client->Close();
+        delete m_client;
+        m_client = NULL;
+    }
+}
+
+
+void LidarSimulator::broadcast() {
+    if (!m_listSocket.IsSocketValid()) {
+        return;
+    }
+    LidarListInfo info;
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, registerName(valName(info.ip)).c_str(), m_config.ip.c_str());
+    cJSON_AddStringToObject(root, registerName(valName(info.model)).c_str(), m_config.model.c_str());
+    cJSON_AddStringToObject(root, registerName(valName(info.hardware)).c_str(), "SIM");
+    cJSON_AddStringToObject(root, registerName(valName(info.software)).c_str(), "SIM");
+    cJSON_AddStringToObject(root, registerName(valName(info.serial)).c_str(), m_config.serial.c_str());
+    char *text = cJSON_PrintUnformatted(root);
+    if (text) {
+        m_listSocket.Send(reinterpret_cast<const uint8_t *>(text), strlen(text));
+        cJSON_free(text);
+    }
+    cJSON_Delete(root);
+}
+
+
+int LidarSimulator::registerValue(const std::string &name) {
+    ScopedLocker lock(m_Lock);
+    std::map<std::string, int>::const_iterator it = m_registers.find(name);
+    return it != m_registers.end() ? it->second : 0;
+}
+
+
+void LidarSimulator::handleCommand(const char *request, std::string &answer) {
+    cJSON *root = cJSON_Parse(request);
+    cJSON *reply = cJSON_CreateObject();
+
+    //unknown names are left out of the answer, the driver then reports a failure
+    if (root) {
+        cJSON *read = cJSON_GetObjectItem(root, "Read");
+        ScopedLocker lock(m_Lock);
+        if (read && cJSON_IsString(read)) {
+            std::map<std::string, int>::const_iterator it = m_registers.find(read->valuestring);
+            if (it != m_registers.end()) {
+                cJSON_AddNumberToObject(reply, it->first.c_str(), it->second);
+            }
+        } else {
+            for (cJSON *item = root->child; item; item = item->next) {
+                std::map<std::string, int>::iterator it = m_registers.find(item->string ? item->string : "");
+                if (it == m_registers.end() || !cJSON_IsNumber(item)) {
+                    continue;
+                }
+                it->second = item->valueint;
+                cJSON_AddNumberToObject(reply, it->first.c_str(), it->second);
+                if (it->first == registerName(valName(regs.scanType))) {
+                    m_scanning = it->second == 0;
+                } else if (it->first == registerName(valName(regs.restart)) && it->second != 0) {
+                    //a restart stops the motor and the packet numbering starts over
+                    m_registers[registerName(valName(regs.scanType))] = -1;
+                    m_scanning = false;
+                    m_sequence = 0;
+                }
+            }
+        }
+        cJSON_Delete(root);
+    }
+
+    char *text = cJSON_PrintUnformatted(reply);
+    answer = text ? text : "{}";
+    cJSON_free(text);
+    cJSON_Delete(reply);
+    m_commands++;
+}
+
+
+int LidarSimulator::configLoop() {
+    uint8_t buf[512];
+    uint32_t last_broadcast = getms() - BROADCAST_INTERVAL;
+    std::string answer;
+
+    while (m_running) {
+        if (!m_online) {
+            closeConfigPort();
+            m_StopEvent.wait(POLL_INTERVAL);
+            continue;
+        }
+        if (!openConfigPort()) {
+            m_StopEvent.wait(POLL_INTERVAL * 10);
+            continue;
+        }
+        if (getms() - last_broadcast >= BROADCAST_INTERVAL) {
+            broadcast();
+            last_broadcast = getms();
+        }
+
+        //the device serves one config connection, a new one replaces it
+        CActiveSocket *client = m_listener.Accept();
+        if (client) {
+            dropClient();
+            m_client = client;
+            m_client->SetBlocking();
+            m_client->SetReceiveTimeout(0, POLL_INTERVAL * 1000);
+        }
+        if (!m_client) {
+            m_StopEvent.wait(POLL_INTERVAL);
+            continue;
+        }
+
+        int32_t len = m_client->Receive(sizeof(buf) - 1, buf);
+        if (len > 0) {
+            //one command per request, the driver waits for each answer
+            buf[len] = '\0';
+            handleCommand(reinterpret_cast<const char *>(buf), answer);
+            m_client->Send(reinterpret_cast<const uint8_t *>(answer.c_str()), answer.size());
+        } else if (len == 0 || (m_client->GetSocketError() != CSimpleSocket::SocketEwouldblock &&
+                                m_client->GetSocketError() != CSimpleSocket::SocketTimedout)) {
+            dropClient();
+        }
+    }
+    return 0;
+}
+
+
+size_t LidarSimulator::fillFrame(DataFrame &frame, double step) {
+    size_t count = 0;
+    memset(&frame, 0, sizeof(frame));
+
+    for (int i = 0; i < DATABLOCK_COUNT; i++) {
+        DataBlock &block = frame.dataBlock[i];
+        uint16_t last = static_cast<uint16_t>(m_angle + 0.5) % 36000;
+        block.frameHead = BigLittleSwap16(FRAME_PREAMBLE);
+        block.startAngle = BigLittleSwap16(last);
+
+        for (int j = 0; j < DATA_COUNT; j++) {
+            uint16_t angle = static_cast<uint16_t>(m_angle + 0.5) % 36000;
+            //the increment has 6 bits, a zero crossing or a larger step starts the next block
+            if (angle < last || angle - last > 0x3f) {
+                break;
+            }
+            //a room with a wall 2-4m away
+            uint32_t distance = static_cast<uint32_t>(3000 + 1000 * sin(angle * M_PI / 6000.0));
+            uint32_t intensity = 100;
+            block.data[j] = BigLittleSwap32(((uint32_t)(angle - last) << 24) | (intensity << 16) | distance);
+            last = angle;
+            count++;
+
+            m_angle += step;
+            if (m_angle >= 36000) {
+                m_angle -= 36000;
+            }
+        }
+    }
+
+    uint64_t stamp = getTime() / 1000000;
+    frame.timeStamp_s = BigLittleSwap32(static_cast<uint32_t>(stamp / 1000));
+    frame.timeStamp_ms = BigLittleSwap32(static_cast<uint32_t>(stamp % 1000));
+    frame.factory = BigLittleSwap32(((uint32_t)(m_sequence & 0x0F) << 24) | 0x00123456);
+    m_sequence++;
+    return count;
+}
+
+
+int LidarSimulator::dataLoop() {
+    typedef std::chrono::steady_clock clock;
+    const std::string samplerate = registerName(valName(regs.samplerate));
+    const std::string motor_speed = registerName(valName(regs.motorSpeed));
+    DataFrame frame;
+    clock::time_point next = clock::now();
+
+    while (m_running) {
+        if (!m_scanning || !m_online) {
+            m_StopEvent.wait(POLL_INTERVAL);
+            next = clock::now();
+            continue;
+        }
+
+        //settings written while scanning apply to the next packet
+        double rate = registerValue(samplerate) * 1000.0;
+        double speed = registerValue(motor_speed);
+        if (rate <= 0 || speed <= 0) {
+            m_StopEvent.wait(POLL_INTERVAL);
+            next = clock::now();
+            continue;
+        }
+        size_t count = fillFrame(frame, 36000.0 * speed / rate);
+        if (m_config.drop_rate <= 0 || rand() >= m_config.drop_rate * RAND_MAX) {
+            m_dataSocket.Send(reinterpret_cast<const uint8_t *>(&frame), sizeof(frame));
+        }
+        m_packets++;
+
+        //the packets leave at the pace the points are measured
+        next += std::chrono::nanoseconds(static_cast<int64_t>(count * 1e9 / rate));
+        clock::time_point now = clock::now();
+        if (now - next > std::chrono::milliseconds(MAX_LAG)) {
+            next = now;
+        }
+        std::this_thread::sleep_until(next);
+    }
+    return 0;
+}
+
+}//namespace lidar
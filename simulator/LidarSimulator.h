@@ -0,0 +1,147 @@
+#ifndef LIDAR_SIMULATOR_H
+#define LIDAR_SIMULATOR_H
+#include <core/base/thread.h>
+#include <core/base/locker.h>
+#include <core/common/lidar_protocol.h>
+#include <core/network/PassiveSocket.h>
+#include <atomic>
+#include <map>
+#include <string>
+
+namespace lidar {
+
+using namespace core::base;
+using namespace core::network;
+
+/// settings of one simulated lidar
+struct simulator_config {
+    std::string ip;              ///< lidar address, every 127.x.x.x works on loopback
+    uint16_t cmd_port;           ///< TCP JSON config port
+    std::string host;            ///< host the data and the broadcasts are sent to
+    uint16_t data_port;          ///< UDP data port of the host
+    uint16_t list_port;          ///< broadcast port of the host, 0 disables the broadcasts
+    int samplerate;              ///< sample rate at power on(kHz)
+    int motor_speed;             ///< motor speed at power on(Hz)
+    float drop_rate;             ///< fraction of the data packets not sent, the sequence still advances
+    std::string model;           ///< model in the broadcasts
+    std::string serial;          ///< serial number in the broadcasts, derived from ip if empty
+
+    simulator_config()
+        : ip("127.0.0.2")
+        , cmd_port(8090)
+        , host("127.0.0.1")
+        , data_port(8000)
+        , list_port(7777)
+        , samplerate(20)
+        , motor_speed(10)
+        , drop_rate(0)
+        , model("LIDAR") {
+    }
+};
+
+/**
+ * @brief Simulated network lidar \n
+ * Answers the JSON config commands on its TCP port like the device, streams
+ * DataFrame packets with sequence numbers and device timestamps at the
+ * configured sample rate and motor speed while scanType is 0, and
+ * broadcasts its identity once a second. Every unit needs its own
+ * address, many units run on 127.0.0.x without any network setup.
+ */
+class LidarSimulator {
+public:
+    enum {
+        BROADCAST_INTERVAL = 1000,   /**< Discovery broadcast period(ms). */
+        POLL_INTERVAL = 10,          /**< Config port poll period(ms). */
+        MAX_LAG = 100,               /**< Stream lag dropped instead of sent in a burst(ms). */
+    };
+
+    explicit LidarSimulator(const simulator_config &config);
+    ~LidarSimulator();
+
+    /**
+     * @brief open the ports and start the lidar, the motor is stopped until a scanType 0 command
+     * @return false if the config port cannot be opened
+     */
+    bool start();
+
+    /**
+     * @brief stop the lidar and close its ports
+     */
+    void stop();
+
+    /**
+     * @brief simulate a link outage \n
+     * offline the config port is closed and no packet is sent, the lidar
+     * keeps its settings and resumes streaming when back online
+     */
+    void setOnline(bool online);
+
+    bool isOnline() const {
+        return m_online;
+    }
+
+    /**
+     * @brief whether the motor runs and data is streamed
+     */
+    bool isScanning() const {
+        return m_scanning;
+    }
+
+    /**
+     * @brief data packets produced, dropped ones included
+     */
+    uint64_t packets() const {
+        return m_packets;
+    }
+
+    /**
+     * @brief config commands answered
+     */
+    uint64_t commands() const {
+        return m_commands;
+    }
+
+    const simulator_config &config() const {
+        return m_config;
+    }
+
+private:
+    int configLoop();
+    int dataLoop();
+    bool openConfigPort();
+    void closeConfigPort();
+    void dropClient();
+    void broadcast();
+    void handleCommand(const char *request, std::string &answer);
+    int registerValue(const std::string &name);
+
+    /**
+     * @brief fill one packet and advance the rotor
+     * @param step  angle between two points(0.01°)
+     * @return number of points in the packet
+     */
+    size_t fillFrame(DataFrame &frame, double step);
+
+private:
+    simulator_config m_config;
+    CPassiveSocket m_listener;              ///< config port
+    CActiveSocket *m_client;                ///< config connection, a new one replaces it
+    CPassiveSocket m_dataSocket;            ///< data stream, bound to the lidar address
+    CPassiveSocket m_listSocket;            ///< broadcasts, bound to the lidar address
+    Thread m_ConfigThread;
+    Thread m_DataThread;
+    Event m_StopEvent;
+    Locker m_Lock;                          ///< m_registers
+    std::map<std::string, int> m_registers; ///< JSON command values by name
+    std::atomic<bool> m_running;
+    std::atomic<bool> m_online;
+    std::atomic<bool> m_scanning;
+    std::atomic<uint64_t> m_packets;
+    std::atomic<uint64_t> m_commands;
+    double m_angle;                         ///< rotor angle(0.01°)
+    std::atomic<uint8_t> m_sequence;        ///< packet sequence number, 4 bits on the wire
+};
+
+}//namespace lidar
+
+#endif // LIDAR_SIMULATOR_H
@@ -0,0 +1,129 @@
+#include "LidarSimulator.h"
+#include "CLidar.h"
+#include <core/base/timer.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <memory>
+#include <string>
+#include <vector>
+using namespace lidar;
+
+static void usage(const char *name) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  -n <count>       number of simulated lidars(1)\n"
+            "  -a <ip>          address of the first lidar, the next ones count up(127.0.0.2)\n"
+            "  -c <port>        TCP config port of every lidar(8090)\n"
+            "  -H <ip>          host receiving the data and the broadcasts(127.0.0.1)\n"
+            "  -p <port>        UDP data port of the host(8000)\n"
+            "  -s <step>        data port increment per lidar, 0 sends all to one port(1)\n"
+            "  -b <port>        broadcast port of the host, 0 disables(7777)\n"
+            "  -r <kHz>         sample rate at power on(20)\n"
+            "  -f <Hz>          motor speed at power on(10)\n"
+            "  -d <percent>     data packets dropped(0)\n"
+            "  -o <every,ms>    link outage of ms milliseconds every 'every' milliseconds\n",
+            name);
+}
+
+
+int main(int argc, char *argv[]) {
+    simulator_config config;
+    int count = 1;
+    int port_step = 1;
+    uint32_t outage_every = 0;
+    uint32_t outage_length = 0;
+
+    for (int i = 1; i < argc; i++) {
+        const char *opt = argv[i];
+        const char *val = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strlen(opt) != 2 || opt[0] != '-' || !val) {
+            usage(argv[0]);
+            return 1;
+        }
+        switch (opt[1]) {
+            case 'n': count = atoi(val); break;
+            case 'a': config.ip = val; break;
+            case 'c': config.cmd_port = atoi(val); break;
+            case 'H': config.host = val; break;
+            case 'p': config.data_port = atoi(val); break;
+            case 's': port_step = atoi(val); break;
+            case 'b': config.list_port = atoi(val); break;
+            case 'r': config.samplerate = atoi(val); break;
+            case 'f': config.motor_speed = atoi(val); break;
+            case 'd': config.drop_rate = atof(val) / 100.f; break;
+            case 'o':
+                if (sscanf(val, "%u,%u", &outage_every, &outage_length) != 2) {
+                    usage(argv[0]);
+                    return 1;
+                }
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+        i++;
+    }
+
+    unsigned int ip[4];
+    if (count <= 0 || (outage_every > 0 && outage_length >= outage_every) ||
+        sscanf(config.ip.c_str(), "%u.%u.%u.%u", &ip[0], &ip[1], &ip[2], &ip[3]) != 4 ||
+        ip[3] + count > 255) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    lidar::os_init();
+    std::vector<std::shared_ptr<LidarSimulator> > units;
+    for (int i = 0; i < count; i++) {
+        char addr[32];
+        simulator_config unit = config;
+        snprintf(addr, sizeof(addr), "%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3] + i);
+        unit.ip = addr;
+        unit.data_port = config.data_port + i * port_step;
+        std::shared_ptr<LidarSimulator> sim(new LidarSimulator(unit));
+        if (!sim->start()) {
+            return 1;
+        }
+        printf("lidar %s: config %u, data -> %s:%u\n", addr, unit.cmd_port, unit.host.c_str(), unit.data_port);
+        units.push_back(sim);
+    }
+    fflush(stdout);
+
+    uint32_t started = getms();
+    uint32_t last_report = started;
+    uint64_t last_packets = 0;
+    bool online = true;
+    while (lidar::os_isOk()) {
+        delay(50);
+        uint32_t now = getms();
+        if (outage_every > 0) {
+            bool up = (now - started) % outage_every < outage_every - outage_length;
+            if (up != online) {
+                online = up;
+                for (size_t i = 0; i < units.size(); i++) {
+                    units[i]->setOnline(online);
+                }
+                printf("link %s\n", online ? "up" : "down");
+            }
+        }
+        if (now - last_report >= 1000) {
+            uint64_t packets = 0;
+            int scanning = 0;
+            for (size_t i = 0; i < units.size(); i++) {
+                packets += units[i]->packets();
+                scanning += units[i]->isScanning() ? 1 : 0;
+            }
+            printf("%d/%d scanning, %.0f packets/s\n", scanning, count,
+                   (packets - last_packets) * 1000.0 / (now - last_report));
+            fflush(stdout);
+            last_packets = packets;
+            last_report = now;
+        }
+    }
+
+    for (size_t i = 0; i < units.size(); i++) {
+        units[i]->stop();
+    }
+    return 0;
+}
@@ -33,6 +33,11 @@
 #include "core/common/lidar_help.h"
 #include "core/common/lidar_def.h"
 #include "LidarDriver.h"
+#include "LidarDiscovery.h"
+#include "ReplayDriver.h"
+#include "SerialDriver.h"
+#include "record/ScanArchiveWriter.h"
+#include "MetricsExporter.h"
 #include <core/serial/serial.h>
 #ifdef _WIN32
 #include <synchapi.h>
@@ -45,7 +50,10 @@
 -------------------------------------------------------------*/
 CLidar::CLidar() {
     m_lidarPtr = nullptr;
+    m_archive = NULL;
+    m_exporter = NULL;
     m_global_nodes = new node_info[DriverInterface::MAX_SCAN_NODES];
+    m_global_size = DriverInterface::MAX_SCAN_NODES;
     m_field_of_view = 300;
     m_lidar_model = DriverInterface::LIDAR;
 
@@ -58,8 +66,22 @@ CLidar::CLidar() {
     m_MaxRange = 64.0;
     m_MinRange = 0.01f;
     m_LidarType = TYPE_LIDAR;
+    m_DeviceType = LIDAR_TYPC_UDP;
+    m_ReplaySpeed = 1.f;
+    m_ReplayLoop = false;
     m_ScanFrequency = 10.f;
     m_sampleRate = 20;
+    m_LivenessTimeout = 100;
+    m_DataPort = DriverInterface::DEFAULT_DATA_PORT;
+    m_SupportHeartBeat = false;
+    m_ThreadPolicy = ThreadPolicyNormal;
+    m_ThreadPriority = 0;
+    m_ThreadStackSize = 0;
+    m_MetricsInterval = MetricsExporter::DEFAULT_INTERVAL;
+    m_LinkCallback = NULL;
+    m_LinkCallbackUser = NULL;
+    m_StateCallback = NULL;
+    m_StateCallbackUser = NULL;
 }
 
 /*-------------------------------------------------------------
@@ -67,6 +89,13 @@ CLidar::CLidar() {
 -------------------------------------------------------------*/
 CLidar::~CLidar(){
     disconnecting();
+    while (!m_discovery.empty()) {
+        unsubscribeDiscovery(m_discovery.back().first, m_discovery.back().second);
+    }
+    delete m_archive;
+    m_archive = NULL;
+    delete m_exporter;
+    m_exporter = NULL;
     if (m_global_nodes)
     {
         delete[] m_global_nodes;
@@ -87,7 +116,16 @@ bool CLidar::setlidaropt(int optname, const void *optval, int optlen) {
         return false;
     }
 
-    if (optname >= LidarPropFixedResolution) {
+    if (optname >= LidarPropThreadPolicy) {
+        if (optlen != sizeof(int)) {
+#if defined(_WIN32)
+            SetLastError(EINVAL);
+#else
+            errno = EINVAL;
+#endif
+            return false;
+        }
+    } else if (optname >= LidarPropFixedResolution) {
         if (optlen != sizeof(bool)) {
 #if defined(_WIN32)
             SetLastError(EINVAL);
@@ -124,10 +162,54 @@ bool CLidar::setlidaropt(int optname, const void *optval, int optlen) {
             m_LidarType = *(int *)(optval);
             break;
 
+        case LidarPropDeviceType:
+            m_DeviceType = *(int *)(optval);
+            break;
+
+        case LidarPropReplaySpeed:
+            m_ReplaySpeed = *(float *)(optval);
+            break;
+
+        case LidarPropReplayLoop:
+            m_ReplayLoop = *(bool *)(optval);
+            break;
+
         case LidarPropSerialPort:
             m_SerialPort = (const char *)optval;
             break;
 
+        case LidarPropRecordPath:
+            m_RecordPath = (const char *)optval;
+            break;
+
+        case LidarPropArchivePath:
+            m_ArchivePath = (const char *)optval;
+            break;
+
+        case LidarPropThreadCpus:
+            m_ThreadCpus = (const char *)optval;
+            break;
+
+        case LidarPropMetricsPath:
+            m_MetricsPath = (const char *)optval;
+            break;
+
+        case LidarPropMetricsInterval:
+            m_MetricsInterval = *(int *)(optval);
+            break;
+
+        case LidarPropThreadPolicy:
+            m_ThreadPolicy = *(int *)(optval);
+            break;
+
+        case LidarPropThreadPriority:
+            m_ThreadPriority = *(int *)(optval);
+            break;
+
+        case LidarPropThreadStackSize:
+            m_ThreadStackSize = *(int *)(optval);
+            break;
+
         case LidarPropSerialBaudrate:
             m_SerialBaudrate = *(int *)(optval);
             break;
@@ -164,6 +246,18 @@ bool CLidar::setlidaropt(int optname, const void *optval, int optlen) {
 	    m_Reversion = *(bool *)(optval);
             break;
 
+        case LidarPropLivenessTimeout:
+            m_LivenessTimeout = *(int *)(optval);
+            break;
+
+        case LidarPropDataPort:
+            m_DataPort = *(int *)(optval);
+            break;
+
+        case LidarPropSupportHeartBeat:
+            m_SupportHeartBeat = *(bool *)(optval);
+            break;
+
         default:
             ret = false;
             break;
@@ -184,7 +278,16 @@ bool CLidar::getlidaropt(int optname, void *optval, int optlen) {
         return false;
     }
 
-    if (optname >= LidarPropFixedResolution) {
+    if (optname >= LidarPropThreadPolicy) {
+        if (optlen != sizeof(int)) {
+#if defined(_WIN32)
+            SetLastError(EINVAL);
+#else
+            errno = EINVAL;
+#endif
+            return false;
+        }
+    } else if (optname >= LidarPropFixedResolution) {
         if (optlen != sizeof(bool)) {
 #if defined(_WIN32)
             SetLastError(EINVAL);
@@ -221,10 +324,54 @@ bool CLidar::getlidaropt(int optname, void *optval, int optlen) {
             memcpy(optval, &m_LidarType, optlen);
             break;
 
+        case LidarPropDeviceType:
+            memcpy(optval, &m_DeviceType, optlen);
+            break;
+
+        case LidarPropReplaySpeed:
+            memcpy(optval, &m_ReplaySpeed, optlen);
+            break;
+
+        case LidarPropReplayLoop:
+            memcpy(optval, &m_ReplayLoop, optlen);
+            break;
+
         case LidarPropSerialPort:
             memcpy(optval, m_SerialPort.c_str(), optlen);
             break;
 
+        case LidarPropRecordPath:
+            strncpy((char *)optval, m_RecordPath.c_str(), optlen);
+            break;
+
+        case LidarPropArchivePath:
+            strncpy((char *)optval, m_ArchivePath.c_str(), optlen);
+            break;
+
+        case LidarPropThreadCpus:
+            strncpy((char *)optval, m_ThreadCpus.c_str(), optlen);
+            break;
+
+        case LidarPropMetricsPath:
+            strncpy((char *)optval, m_MetricsPath.c_str(), optlen);
+            break;
+
+        case LidarPropMetricsInterval:
+            memcpy(optval, &m_MetricsInterval, optlen);
+            break;
+
+        case LidarPropThreadPolicy:
+            memcpy(optval, &m_ThreadPolicy, optlen);
+            break;
+
+        case LidarPropThreadPriority:
+            memcpy(optval, &m_ThreadPriority, optlen);
+            break;
+
+        case LidarPropThreadStackSize:
+            memcpy(optval, &m_ThreadStackSize, optlen);
+            break;
+
         case LidarPropSerialBaudrate:
             memcpy(optval, &m_SerialBaudrate, optlen);
             break;
@@ -252,6 +399,18 @@ bool CLidar::getlidaropt(int optname, void *optval, int optlen) {
         case LidarPropScanFrequency:
             memcpy(optval, &m_ScanFrequency, optlen);
             break;
+        case LidarPropLivenessTimeout:
+            memcpy(optval, &m_LivenessTimeout, optlen);
+            break;
+
+        case LidarPropDataPort:
+            memcpy(optval, &m_DataPort, optlen);
+            break;
+
+        case LidarPropSupportHeartBeat:
+            memcpy(optval, &m_SupportHeartBeat, optlen);
+            break;
+
         case LidarPropSampleRate:
             memcpy(optval, &m_sampleRate, optlen);
         default:
@@ -285,7 +444,11 @@ bool CLidar::initialize() {
 -------------------------------------------------------------*/
 bool CLidar::checkCOMMs() {
     if (!m_lidarPtr) {
-        if (isLidar(m_LidarType)) {
+        if (m_DeviceType == LIDAR_TYPE_REPLAY) {
+            m_lidarPtr = new lidar::ReplayDriver(m_ReplaySpeed, m_ReplayLoop);
+        } else if (m_DeviceType == LIDAR_TYPE_SERIAL) {
+            m_lidarPtr = new lidar::SerialDriver();
+        } else if (isLidar(m_LidarType)) {
             m_lidarPtr = new lidar::LidarDriver();
         } else {
             //LOGW("An unsupported model:%d", m_LidarType);
@@ -295,6 +458,17 @@ bool CLidar::checkCOMMs() {
             fprintf(stderr, "Create lidar fail");
             return false;
         }
+        m_lidarPtr->setLinkStateCallback(m_LinkCallback, m_LinkCallbackUser);
+        m_lidarPtr->setDriverStateCallback(m_StateCallback, m_StateCallbackUser);
+
+        if (!m_MetricsPath.empty()) {
+            if (!m_exporter) {
+                m_exporter = new MetricsExporter();
+            }
+            //failures are logged by the exporter, the lidar works without it
+            m_exporter->start(m_lidarPtr, m_MetricsPath, m_SerialPort,
+                              m_MetricsInterval > 0 ? m_MetricsInterval : 0);
+        }
        
         //LOGD("SDK Version: %s", m_lidarPtr->getSDKVersion().c_str());
     } else {
@@ -305,6 +479,13 @@ bool CLidar::checkCOMMs() {
         return true;
     }
     //make connection...
+    m_lidarPtr->setDataPort(m_DataPort);
+    thread_attr attr;
+    attr.cpus = m_ThreadCpus;
+    attr.policy = m_ThreadPolicy;
+    attr.priority = m_ThreadPriority;
+    attr.stack_size = m_ThreadStackSize > 0 ? m_ThreadStackSize : 0;
+    m_lidarPtr->setThreadAttr(attr);
     result_t op_result = m_lidarPtr->connect(m_SerialPort.c_str(), m_SerialBaudrate);
     if (!IS_OK(op_result)) {
         //LOGE("[CLidar] Error, cannot bind to the specified IP Address[%s]", m_SerialPort.c_str());     
@@ -331,17 +512,51 @@ bool CLidar::turnOn() {
         _scan_frequency.frequency = m_ScanFrequency;
         sampling_rate _sampling_rate;
         _sampling_rate.rate =  m_sampleRate;
-		#ifdef _WIN32
-		Sleep(1000);
-		#else
-        usleep(1000);
-		#endif
+        //values already applied in this session are not written again
         m_lidarPtr->setScanFrequency(_scan_frequency);
         m_lidarPtr->setSamplingRate(_sampling_rate);
     }
 
+    //一圈的缓存按采样率和扫描频率分配
+    size_t capacity = ScanAssembler::capacity(m_sampleRate, m_ScanFrequency, DATABLOCK_COUNT * DATA_COUNT,
+                                              DriverInterface::MAX_SCAN_NODES);
+    m_lidarPtr->setScanCapacity((uint32_t)capacity);
+    //覆盖率按采样率的点间距和视场角统计
+    m_lidarPtr->setScanSpacing(ScanAssembler::spacing(m_sampleRate, m_ScanFrequency));
+    float fov = m_MaxAngle > m_MinAngle ? m_MaxAngle - m_MinAngle : 360.f;
+    m_lidarPtr->setFieldOfView((uint32_t)(fov * 100 + 0.5f));
+    if (capacity != m_global_size) {
+        delete[] m_global_nodes;
+        m_global_nodes = new node_info[capacity];
+        m_global_size = capacity;
+    }
+
+    liveness_config liveness;
+    liveness.data_timeout = m_LivenessTimeout > 0 ? m_LivenessTimeout : 0;
+    liveness.heartbeat_interval = m_SupportHeartBeat ? DriverInterface::DEFAULT_HEART_BEAT : 0;
+    liveness.heartbeat_timeout = 3 * DriverInterface::DEFAULT_HEART_BEAT;
+    liveness.control_fail_count = 3;
+    m_lidarPtr->setLivenessConfig(liveness);
+
+    //recording starts before the first datagram
+    if (!m_RecordPath.empty() && !IS_OK(m_lidarPtr->startRecord(m_RecordPath.c_str()))) {
+        LOGW("Failed to record to %s", m_RecordPath.c_str());
+    }
+    if (!m_ArchivePath.empty()) {
+        if (!m_archive) {
+            m_archive = new ScanArchiveWriter();
+        }
+        if (!m_archive->open(m_ArchivePath.c_str())) {
+            LOGW("Failed to archive scans to %s", m_ArchivePath.c_str());
+        }
+    }
+
     result_t op_result = m_lidarPtr->startScan();
     if (!IS_OK(op_result)) {
+        m_lidarPtr->stopRecord();
+        if (m_archive) {
+            m_archive->close();
+        }
         //LOGE("[CLidar] Failed to start scan mode: %x", op_result);
         return false;
     }
@@ -365,6 +580,10 @@ bool CLidar::turnOff() {
     }
 
     result_t op_result = m_lidarPtr->stopScan();
+    m_lidarPtr->stopRecord();
+    if (m_archive) {
+        m_archive->close();
+    }
     if (!IS_OK(op_result)) {
         //LOGE("[CLidar] Failed to stop scan mode: %x", op_result);
         return false;
@@ -377,7 +596,7 @@ bool CLidar::turnOff() {
                         doProcessSimple
 -------------------------------------------------------------*/
 bool CLidar::doProcessSimple(LaserScan &outscan) {
-    size_t count = DriverInterface::MAX_SCAN_NODES;
+    size_t count = m_global_size;
     //从缓存中获取已采集的一圈扫描数据
     result_t op_result = m_lidarPtr->grabScanData(m_global_nodes, count);
     outscan.points.clear();
@@ -386,17 +605,39 @@ bool CLidar::doProcessSimple(LaserScan &outscan) {
     if (!IS_OK(op_result)) {
         return false;
     }
+    if (m_archive && m_archive->isOpen()) {
+        m_archive->write(m_global_nodes, count, getTime());
+    }
 
+    outscan.stats = m_lidarPtr->getScanStats();
     outscan.config.min_angle = math::from_degrees(m_MinAngle);
     outscan.config.max_angle = math::from_degrees(m_MaxAngle);
-    outscan.config.scan_time = (m_global_nodes[count - 1].stamp - m_global_nodes[0].stamp) * 0.001;//单位：s
+    //测得的转速周期，第一圈之前用首尾点时间戳
+    if (outscan.stats.period) {
+        outscan.config.scan_time = outscan.stats.period * 1e-9;//单位：s
+    } else {
+        outscan.config.scan_time = (m_global_nodes[count - 1].stamp - m_global_nodes[0].stamp) * 1e-9;//单位：s
+    }
     outscan.config.angle_increment = math::from_degrees(m_field_of_view) / count;
-    outscan.config.time_increment = outscan.config.scan_time / count;
+    //相邻两点的平均间隔，只由首尾点时间戳决定，与转速周期无关
+    if (count > 1) {
+        outscan.config.time_increment = (m_global_nodes[count - 1].stamp - m_global_nodes[0].stamp) * 1e-9 / (count - 1);//单位：s
+    } else {
+        outscan.config.time_increment = 0;
+    }
     outscan.config.min_range = m_MinRange;
     outscan.config.max_range = m_MaxRange;
 
-    //将一圈中第一个点采集时间作为该圈数据采集时间
-    outscan.stamp = (m_global_nodes[0].stamp > 0) ? m_global_nodes[0].stamp : 0;
+    //将一圈中第一个点采集时间作为该圈数据采集时间，换算到主机时钟
+    outscan.device_stamp = m_global_nodes[0].stamp;
+    ClockSyncState clock = m_lidarPtr->getClockSync();
+    if (clock.samples) {
+        outscan.stamp = ClockSync::toHost(clock, outscan.device_stamp);
+        outscan.stamp_error = clock.windows ? clock.error : UINT64_MAX;
+    } else {
+        outscan.stamp = outscan.device_stamp;
+        outscan.stamp_error = UINT64_MAX;
+    }
 
     float range = 0.0;
     float intensity = 0.0;
@@ -415,6 +656,10 @@ bool CLidar::doProcessSimple(LaserScan &outscan) {
         point.intensity = intensity;
         outscan.points.push_back(point);
     }
+
+    ScanTimeline timeline = m_lidarPtr->getScanTimeline();
+    timeline.stamp[TraceConverted] = getns();
+    m_tracer.record(timeline);
     return true;
 }
 
@@ -422,6 +667,9 @@ bool CLidar::doProcessSimple(LaserScan &outscan) {
                         disconnecting
 -------------------------------------------------------------*/
 void CLidar::disconnecting() {
+    if (m_exporter) {
+        m_exporter->stop();
+    }
     if (m_lidarPtr) {
         m_lidarPtr->disconnect();
         delete m_lidarPtr;
@@ -451,6 +699,126 @@ DriverError CLidar::getDriverError() const {
     return er;
 }
 
+/*-------------------------------------------------------------
+                        getStartupTiming
+-------------------------------------------------------------*/
+startup_timing CLidar::getStartupTiming() const {
+    startup_timing timing;
+    memset(&timing, 0, sizeof(timing));
+    if (m_lidarPtr) {
+        return m_lidarPtr->getStartupTiming();
+    }
+    return timing;
+}
+
+/*-------------------------------------------------------------
+                        getMetrics
+-------------------------------------------------------------*/
+LidarMetrics CLidar::getMetrics() const {
+    LidarMetrics metrics;
+    memset(&metrics, 0, sizeof(metrics));
+    if (m_lidarPtr) {
+        return m_lidarPtr->getMetrics();
+    }
+    return metrics;
+}
+
+/*-------------------------------------------------------------
+                        getMetricsText
+-------------------------------------------------------------*/
+string CLidar::getMetricsText() const {
+    string text;
+    MetricsExporter::format(getMetrics(), m_SerialPort, text);
+    return text;
+}
+
+/*-------------------------------------------------------------
+                        getScanLatency
+-------------------------------------------------------------*/
+void CLidar::getScanLatency(ScanLatency &latency) const {
+    m_tracer.latency(latency);
+}
+
+/*-------------------------------------------------------------
+                        getScanTimeline
+-------------------------------------------------------------*/
+ScanTimeline CLidar::getScanTimeline() const {
+    return m_tracer.last();
+}
+
+/*-------------------------------------------------------------
+                        getScanStats
+-------------------------------------------------------------*/
+ScanStats CLidar::getScanStats() const {
+    ScanStats stats;
+    memset(&stats, 0, sizeof(stats));
+    if (m_lidarPtr) {
+        return m_lidarPtr->getScanStats();
+    }
+    return stats;
+}
+
+/*-------------------------------------------------------------
+                        getClockSync
+-------------------------------------------------------------*/
+ClockSyncState CLidar::getClockSync() const {
+    ClockSyncState clock;
+    memset(&clock, 0, sizeof(clock));
+    if (m_lidarPtr) {
+        return m_lidarPtr->getClockSync();
+    }
+    return clock;
+}
+
+/*-------------------------------------------------------------
+                        writeLatencyTrace
+-------------------------------------------------------------*/
+bool CLidar::writeLatencyTrace(const string &path) const {
+    return m_tracer.writeTrace(path, "lidar " + m_SerialPort);
+}
+
+/*-------------------------------------------------------------
+                     setLinkStateCallback
+-------------------------------------------------------------*/
+void CLidar::setLinkStateCallback(LinkStateCallback callback, void *user) {
+    m_LinkCallback = callback;
+    m_LinkCallbackUser = user;
+    if (m_lidarPtr) {
+        m_lidarPtr->setLinkStateCallback(callback, user);
+    }
+}
+
+/*-------------------------------------------------------------
+                        getLinkState
+-------------------------------------------------------------*/
+LinkState CLidar::getLinkState() const {
+    if (m_lidarPtr) {
+        return m_lidarPtr->getLinkState();
+    }
+    return LinkStateUnknown;
+}
+
+/*-------------------------------------------------------------
+                    setDriverStateCallback
+-------------------------------------------------------------*/
+void CLidar::setDriverStateCallback(DriverStateCallback callback, void *user) {
+    m_StateCallback = callback;
+    m_StateCallbackUser = user;
+    if (m_lidarPtr) {
+        m_lidarPtr->setDriverStateCallback(callback, user);
+    }
+}
+
+/*-------------------------------------------------------------
+                        getDriverState
+-------------------------------------------------------------*/
+DriverState CLidar::getDriverState() const {
+    if (m_lidarPtr) {
+        return m_lidarPtr->getDriverState();
+    }
+    return DriverStateDisconnected;
+}
+
 /*-------------------------------------------------------------
                         lidarPortList
 -------------------------------------------------------------*/
@@ -464,6 +832,38 @@ map<string, string> CLidar::lidarPortList()
     return lstMap;
 }
 
+/*-------------------------------------------------------------
+                      subscribeDiscovery
+-------------------------------------------------------------*/
+bool CLidar::subscribeDiscovery(DiscoveryCallback callback, void *user) {
+    if (!callback) {
+        return false;
+    }
+    //subscribed first, no lidar heard by a listener started here is missed
+    LidarDiscovery::instance().subscribe(callback, user);
+    if (!LidarDiscovery::instance().acquire()) {
+        LidarDiscovery::instance().unsubscribe(callback, user);
+        return false;
+    }
+    m_discovery.push_back(make_pair(callback, user));
+    return true;
+}
+
+/*-------------------------------------------------------------
+                     unsubscribeDiscovery
+-------------------------------------------------------------*/
+bool CLidar::unsubscribeDiscovery(DiscoveryCallback callback, void *user) {
+    vector<pair<DiscoveryCallback, void *> >::iterator it =
+        find(m_discovery.begin(), m_discovery.end(), make_pair(callback, user));
+    if (it == m_discovery.end()) {
+        return false;
+    }
+    m_discovery.erase(it);
+    LidarDiscovery::instance().unsubscribe(callback, user);
+    LidarDiscovery::instance().release();
+    return true;
+}
+
 namespace lidar{
     
 void os_init() {
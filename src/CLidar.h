@@ -3,20 +3,31 @@
 #include <core/base/utils.h>
 #include <core/common/lidar_def.h>
 #include <core/common/DriverInterface.h>
+#include <core/common/LatencyTracer.h>
 #include <string>
 #include <map>
+#include <vector>
+#include <utility>
 
 using namespace std;
 using namespace lidar;
 using namespace lidar::core;
 using namespace lidar::core::common;
 
+namespace lidar {
+class ScanArchiveWriter;
+class MetricsExporter;
+}
+
 class LIDAR_API CLidar {
     private:
         DriverInterface *m_lidarPtr;      ///< LiDAR Driver Interface pointer
         string m_SerialPort;              ///< LiDAR serial port or network ip
         int m_SerialBaudrate;             ///< LiDAR serial baudrate or network port
         int m_LidarType;                  ///< LiDAR type
+        int m_DeviceType;                 ///< LiDAR connection type
+        float m_ReplaySpeed;              ///< capture replay speed factor
+        bool m_ReplayLoop;                ///< restart the capture replay at its end
         int m_lidar_model;                ///< LiDAR Model
         bool m_AutoReconnect;             ///< LiDAR hot plug 
         float m_MaxAngle;                 ///< LiDAR maximum angle
@@ -27,7 +38,27 @@ class LIDAR_API CLidar {
         float m_ScanFrequency;            ///< LiDAR scanning frequency
         int m_sampleRate;                 ///< Lidar sample rate
 	bool m_Reversion = false;
+        int m_LivenessTimeout;            ///< LiDAR data gap before the link is dead(ms)
+        int m_DataPort;                   ///< local UDP data port
+        bool m_SupportHeartBeat;          ///< LiDAR heartbeat on the command port
+        LinkStateCallback m_LinkCallback; ///< link state transition callback
+        void *m_LinkCallbackUser;         ///< link state callback user data
+        DriverStateCallback m_StateCallback; ///< driver state transition callback
+        void *m_StateCallbackUser;        ///< driver state callback user data
+        vector<pair<DiscoveryCallback, void *> > m_discovery; ///< discovery subscriptions, each holds the listener
+        string m_RecordPath;              ///< raw data capture file, empty if not recording
+        string m_ArchivePath;             ///< compressed scan archive, empty if not archiving
+        ScanArchiveWriter *m_archive;     ///< scan archive writer, NULL if not archiving
+        string m_ThreadCpus;              ///< cpu list of the ingest threads, empty for any
+        int m_ThreadPolicy;               ///< ingest thread scheduling policy
+        int m_ThreadPriority;             ///< ingest thread real-time priority
+        int m_ThreadStackSize;            ///< ingest thread stack size, 0 for the default
+        string m_MetricsPath;             ///< Prometheus export file or address, empty if not exporting
+        int m_MetricsInterval;            ///< Prometheus file export period(ms)
+        MetricsExporter *m_exporter;      ///< Prometheus exporter, NULL if not exporting
+        LatencyTracer m_tracer;           ///< stage latencies of the converted revolutions
         node_info *m_global_nodes;  
+        size_t m_global_size;             ///< points m_global_nodes holds
 
     public:
         /**
@@ -109,11 +140,109 @@ class LIDAR_API CLidar {
          */
         DriverError getDriverError() const;
 
+        /**
+         * @brief Get the bring-up timeline of the LiDAR
+         * @return getms() ticks of connect, start and first scan,
+         * first_scan - connect_start is the time to first revolution.
+         */
+        startup_timing getStartupTiming() const;
+
+        /**
+         * @brief Get the ingest pipeline metrics
+         * @return packet, byte, error and revolution counters and the decode time histogram,
+         * totals since ::initialize created the driver
+         */
+        LidarMetrics getMetrics() const;
+
+        /**
+         * @brief Get the ingest pipeline metrics in Prometheus text format
+         * @return metrics labelled with the serial port or ip
+         */
+        string getMetricsText() const;
+
+        /**
+         * @brief Get the latency percentiles of every stage a revolution goes through
+         * @param[out] latency  percentiles of the revolutions converted by ::doProcessSimple
+         */
+        void getScanLatency(ScanLatency &latency) const;
+
+        /**
+         * @brief Get the timeline of the revolution returned by the last ::doProcessSimple
+         * @return stage stamps, zeroed before the first revolution
+         */
+        ScanTimeline getScanTimeline() const;
+
+        /**
+         * @brief Get the measured speed and coverage of the revolution returned by the last ::doProcessSimple
+         * @return the LaserScan::stats of that revolution, zeroed before the first one
+         * @note call it from the thread calling ::doProcessSimple
+         */
+        ScanStats getScanStats() const;
+
+        /**
+         * @brief Get the relation of the lidar clock to the host clock \n
+         * LaserScan::stamp is LaserScan::device_stamp mapped with it.
+         * @return offset, skew and error bound, zeroed before the first packet
+         */
+        ClockSyncState getClockSync() const;
+
+        /**
+         * @brief Write the timelines of the last revolutions as a Chrome trace \n
+         * The file loads in chrome://tracing and ui.perfetto.dev, one track per stage.
+         * @param path  json file
+         * @return true if the file is written
+         */
+        bool writeLatencyTrace(const string &path) const;
+
+        /**
+         * @brief Set the link state transition callback
+         * @param callback  called from an SDK thread on every transition, NULL to disable
+         * @param user      user data passed to the callback
+         */
+        void setLinkStateCallback(LinkStateCallback callback, void *user);
+
+        /**
+         * @brief Get the link liveness state
+         * @return link state
+         */
+        LinkState getLinkState() const;
+
+        /**
+         * @brief Set the driver state transition callback
+         * @param callback  called on every lifecycle transition, NULL to disable
+         * @param user      user data passed to the callback
+         */
+        void setDriverStateCallback(DriverStateCallback callback, void *user);
+
+        /**
+         * @brief Get the driver lifecycle state
+         * @return driver state
+         */
+        DriverState getDriverState() const;
+
         /**
          * @brief Get lidar lists
          * @return online lidars
          */
         map<string, string> lidarPortList();
+
+        /**
+         * @brief Subscribe to the lidars heard on the broadcast port
+         * @param callback  called from the discovery thread on every add, change and expiry
+         * @param user      user data passed to the callback
+         * @return false if the broadcast port is taken by another process
+         * @note the listener is shared by the process and runs while a subscription
+         * or a network connection holds it, lidars already online are in ::lidarPortList
+         */
+        bool subscribeDiscovery(DiscoveryCallback callback, void *user);
+
+        /**
+         * @brief Unsubscribe a callback given to ::subscribeDiscovery
+         * @param callback  event callback
+         * @param user      user data given to ::subscribeDiscovery
+         * @return false if the callback was not subscribed by this object
+         */
+        bool unsubscribeDiscovery(DiscoveryCallback callback, void *user);
 };	// End of class
 #endif // CLIDAR_H
 
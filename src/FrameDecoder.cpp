@@ -0,0 +1,107 @@
+#include "FrameDecoder.h"
+#include <core/common/lidar_help.h>
+
+namespace lidar {
+
+FrameDecoder::FrameDecoder()
+    : m_metrics(NULL) {
+    reset();
+}
+
+
+void FrameDecoder::reset() {
+    m_lastPacketNum = 0xff;
+    m_lastPointAngle = 0;
+    m_lastTimeStamp = 0;
+}
+
+
+result_t FrameDecoder::decode(const uint8_t *data, size_t len, node_info *nodebuffer, size_t &count) {
+    const DataFrame &frame = *reinterpret_cast<const DataFrame *>(data);
+    count = 0;
+
+    if (len < sizeof(DataFrame)) {
+        if (m_metrics) {
+            m_metrics->frame_errors.add();
+        }
+        return RESULT_FAIL;
+    }
+
+    for(int i = 0; i < DATABLOCK_COUNT; i++) {
+        if (BigLittleSwap16(frame.dataBlock[i].frameHead) != 0xFFEE) {
+            //LOGE("data error, frameHead[%d] != 0xFFEE", i);
+            if (m_metrics) {
+                m_metrics->frame_errors.add();
+            }
+            return RESULT_FAIL;
+        }
+    }
+
+    // if((BigLittleSwap32(frame.factory) & 0xFFF0FFFF) != 0x21300000) {
+    //     LOGE("(data error, factory & 0xFFF0FFFF) != 0x21300000");
+    //     return RESULT_FAIL;
+    // }
+    // if((BigLittleSwap32(frame.factory) & 0xF0FFFFFF) != 0x00123456) {
+    //     LOGE("(data error, factory & 0xF0FFFFFF) != 0x00123456");
+    //     return RESULT_FAIL;
+    // }
+
+
+    for(int i = 0; i < DATABLOCK_COUNT; i++) {
+        uint16_t startAngle = BigLittleSwap16(frame.dataBlock[i].startAngle);
+        uint16_t addAngle = 0;
+        for(int j = 0; j < DATA_COUNT; j++) {
+            if (!decodePoint(startAngle, addAngle, BigLittleSwap32(frame.dataBlock[i].data[j]), nodebuffer[count])) {
+                break;
+            }
+            count++;
+        }
+    }
+
+    uint64_t TimeStampTmp = deviceTime(BigLittleSwap32(frame.timeStamp_s), BigLittleSwap32(frame.timeStamp_ms));
+    result_t ans = finish(BigLittleSwap32(frame.factory), TimeStampTmp, nodebuffer, count);
+    if (!IS_OK(ans)) {
+        count = 0;
+    }
+    return ans;
+}
+
+
+result_t FrameDecoder::finish(uint32_t factory, uint64_t stamp, node_info *nodebuffer, size_t count) {
+    node_info *n = NULL;
+    //uint8_t curNum = (factory & 0x000F0000) >> 16;
+    uint8_t curNum = (factory & 0x0F000000) >> 24;
+    //the first packet after a (re)start has nothing to be compared with
+    if(m_lastPacketNum != 0xff && (curNum - m_lastPacketNum != 1) && (curNum - m_lastPacketNum != -15)) {
+        //LOGE("data packet dropout, curNum = %d, lastNum = %d", curNum, m_lastPacketNum);
+        if (m_metrics) {
+            m_metrics->sequence_gaps.add();
+        }
+        m_lastPacketNum = curNum;
+        //the points of the next packet are spread from this one, not across the gap
+        m_lastTimeStamp = stamp;
+        return RESULT_FAIL;
+    }
+    m_lastPacketNum = curNum;
+    for (size_t i = 0; i < count; i++) {
+        n = nodebuffer + i;
+        n->sync_flag = (n->angle_q6_checkbit < m_lastPointAngle) ? Node_Sync : Node_NotSync;//当前点的角度小于上一个点的角度，则认为当前点为零位点
+        m_lastPointAngle = n->angle_q6_checkbit;
+    }
+
+    //a stream resuming after an outage may keep its sequence, its points are not spread over the outage
+    if (m_lastTimeStamp == 0 || stamp < m_lastTimeStamp ||
+        stamp - m_lastTimeStamp > MAX_PACKET_SPAN_MS * 1000000ULL) {
+        m_lastTimeStamp = stamp;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        n = nodebuffer + i;
+        n->stamp = stamp - (stamp - m_lastTimeStamp) * (count - i - 1) / count;  //ns
+    }
+    m_lastTimeStamp = stamp;
+
+    return RESULT_OK;
+}
+
+}//namespace lidar
@@ -0,0 +1,100 @@
+#ifndef FRAME_DECODER_H
+#define FRAME_DECODER_H
+#include <core/base/v8stdint.h>
+#include <core/common/lidar_protocol.h>
+#include <core/common/lidar_datatype.h>
+#include <core/common/lidar_def.h>
+#include <core/common/MetricsRegistry.h>
+
+namespace lidar {
+
+/**
+ * @brief Decoder of the UDP DataFrame \n
+ * Checks frame heads and the packet sequence, then converts the data
+ * blocks into points with interpolated timestamps. Live data and replayed
+ * captures go through the same decoder.
+ */
+class FrameDecoder {
+public:
+    enum {
+        MAX_PACKET_SPAN_MS = 200,     ///< longest time a packet may span, DATABLOCK_COUNT * DATA_COUNT points at 1 kHz
+    };
+
+    FrameDecoder();
+
+    /**
+     * @brief Reset the packet sequence, angle and timestamp tracking \n
+     * so the first packet after a (re)start is decoded instead of dropped.
+     */
+    void reset();
+
+    /**
+     * @brief count sequence gaps and bad frame heads
+     * @param metrics  registry of the decoding thread, NULL to disable
+     */
+    void setMetrics(core::common::MetricsRegistry *metrics) {
+        m_metrics = metrics;
+    }
+
+    /**
+     * @brief decode one datagram
+     * @param[in]  data        datagram payload
+     * @param[in]  len         payload length
+     * @param[out] nodebuffer  at least DATABLOCK_COUNT * DATA_COUNT points
+     * @param[out] count       decoded point count
+     * @return result status
+     * @retval RESULT_OK       success
+     * @retval RESULT_FAIL     short datagram, bad frame head or packet dropout
+     */
+    result_t decode(const uint8_t *data, size_t len, node_info *nodebuffer, size_t &count);
+
+    /**
+     * @brief decode one data word of a block
+     * @param[in]     startAngle  start angle of the block
+     * @param[in,out] addAngle    angle increment of the block so far, 0 at the first word
+     * @param[in]     data        data word, host byte order
+     * @param[out]    n           point, the sync flag and stamp are set by ::finish
+     * @return false if the word ends the block
+     */
+    static inline bool decodePoint(uint16_t startAngle, uint16_t &addAngle, uint32_t data, node_info &n) {
+        if (data == 0) {
+            return false;
+        }
+        addAngle += ((data & 0x3f000000) >> 24);
+        n.angle_q6_checkbit = startAngle + addAngle;
+        n.sync_quality = (data & 0xff0000) >> 16;
+        n.distance_q2 = (data & 0xffff) >> 0;
+        return true;
+    }
+
+    /**
+     * @brief check the packet sequence, then set the sync flags and stamps of a frame
+     * @param factory     factory word, host byte order
+     * @param stamp       device time of the frame(ns), see ::deviceTime
+     * @param nodebuffer  points decoded with ::decodePoint
+     * @param count       point count
+     * @return result status
+     * @retval RESULT_OK       success
+     * @retval RESULT_FAIL     packet dropout
+     */
+    result_t finish(uint32_t factory, uint64_t stamp, node_info *nodebuffer, size_t count);
+
+    /**
+     * @brief device time of a frame(ns)
+     * @param sec  timeStamp_s, host byte order
+     * @param ms   timeStamp_ms, host byte order
+     */
+    static uint64_t deviceTime(uint32_t sec, uint32_t ms) {
+        return ((uint64_t)sec * 1000 + ms) * 1000000ULL;
+    }
+
+private:
+    core::common::MetricsRegistry *m_metrics;
+    uint8_t m_lastPacketNum;          ///< sequence number of the last packet, 0xff before the first one
+    uint16_t m_lastPointAngle;        ///< angle of the last decoded point
+    uint64_t m_lastTimeStamp;         ///< device time of the last packet (ns), 0 before the first one
+};
+
+}//namespace lidar
+
+#endif // FRAME_DECODER_H
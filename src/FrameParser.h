@@ -0,0 +1,190 @@
+#ifndef FRAME_PARSER_H
+#define FRAME_PARSER_H
+#include "FrameDecoder.h"
+
+namespace lidar {
+
+/**
+ * @brief Incremental DataFrame parser for byte streams \n
+ * Serial links deliver frames in arbitrary pieces. The parser keeps its
+ * position inside the frame between calls and decodes every data word as
+ * soon as its last byte arrives, so each byte is looked at once and never
+ * copied. Frame heads are checked at every block, the sequence and stamps
+ * are handled by the FrameDecoder shared with the UDP path.
+ *
+ * After a lost byte the parser hunts for the next 0xFFEE. A hunt may lock
+ * onto any block of a frame, the first head mismatch then marks the frame
+ * trailer and the frame after it is aligned again.
+ */
+class FrameParser {
+public:
+    explicit FrameParser(FrameDecoder &decoder)
+        : m_decoder(decoder) {
+        reset();
+    }
+
+    /**
+     * @brief forget the partial frame and hunt for the next block head
+     */
+    void reset() {
+        m_state = StateHunt;
+        m_prev = 0;
+        m_block = 0;
+        m_pos = 0;
+        m_count = 0;
+        m_discard = false;
+        m_frames = 0;
+        m_resyncs = 0;
+    }
+
+    /**
+     * @brief parse received bytes
+     * @param data     bytes
+     * @param len      byte count
+     * @param publish  called as publish(result_t ans, const node_info *nodes, size_t count)
+     *                 for every frame, RESULT_FAIL for a dropped or partial frame
+     */
+    template <typename Publisher>
+    void feed(const uint8_t *data, size_t len, Publisher publish) {
+        for (const uint8_t *p = data, *end = data + len; p < end; p++) {
+            uint8_t b = *p;
+            switch (m_state) {
+            case StateHunt:
+                if (m_prev == 0xFF && b == 0xEE) {
+                    beginFrame(false);
+                    m_pos = 2;
+                }
+                m_prev = b;
+                break;
+
+            case StateBlock:
+                if (m_pos == 0 && b != 0xFF) {
+                    if (m_block > 0) {
+                        //not a head but the trailer, the frame was joined in the middle
+                        m_state = StateTrailer;
+                        m_discard = true;
+                        m_pos = 0;
+                        trailerByte(b, publish);
+                    } else {
+                        lost(b);
+                    }
+                    break;
+                }
+                if (m_pos == 1 && b != 0xEE) {
+                    lost(b);
+                    break;
+                }
+                blockByte(b);
+                break;
+
+            case StateTrailer:
+                trailerByte(b, publish);
+                break;
+            }
+        }
+    }
+
+    /**
+     * @brief frames parsed, dropped ones included
+     */
+    uint64_t frames() const {
+        return m_frames;
+    }
+
+    /**
+     * @brief times the parser lost the frame alignment
+     */
+    uint64_t resyncs() const {
+        return m_resyncs;
+    }
+
+private:
+    enum State {
+        StateHunt,                    ///< looking for 0xFFEE
+        StateBlock,                   ///< inside a data block
+        StateTrailer,                 ///< inside the stamps and factory word
+    };
+
+    enum {
+        BLOCK_SIZE = sizeof(DataBlock),
+        TRAILER_SIZE = sizeof(DataFrame) - DATABLOCK_COUNT * sizeof(DataBlock),
+    };
+
+    void beginFrame(bool discard) {
+        m_state = StateBlock;
+        m_block = 0;
+        m_pos = 0;
+        m_count = 0;
+        m_discard = discard;
+    }
+
+    void lost(uint8_t b) {
+        m_state = StateHunt;
+        m_prev = b;
+        m_resyncs++;
+    }
+
+    void blockByte(uint8_t b) {
+        if (m_pos == 2) {
+            m_angle = b;
+            m_addAngle = 0;
+            m_blockEnded = false;
+        } else if (m_pos == 3) {
+            m_angle = (m_angle << 8) | b;
+        } else if (m_pos >= 4) {
+            m_word = (m_word << 8) | b;
+            if ((m_pos & 3) == 3 && !m_blockEnded) {
+                //the first zero word ends the points of the block
+                m_blockEnded = !FrameDecoder::decodePoint(m_angle, m_addAngle, m_word, m_nodes[m_count]);
+                if (!m_blockEnded) {
+                    m_count++;
+                }
+            }
+        }
+        if (++m_pos == BLOCK_SIZE) {
+            m_pos = 0;
+            if (++m_block == DATABLOCK_COUNT) {
+                m_state = StateTrailer;
+            }
+        }
+    }
+
+    template <typename Publisher>
+    void trailerByte(uint8_t b, Publisher &publish) {
+        m_trailer[m_pos / 4] = (m_pos & 3) ? (m_trailer[m_pos / 4] << 8) | b : b;
+        if (++m_pos < TRAILER_SIZE) {
+            return;
+        }
+        m_frames++;
+        if (m_discard) {
+            m_resyncs++;
+            publish(RESULT_FAIL, m_nodes, 0);
+        } else {
+            uint64_t stamp = FrameDecoder::deviceTime(m_trailer[0], m_trailer[1]);
+            result_t ans = m_decoder.finish(m_trailer[2], stamp, m_nodes, m_count);
+            publish(ans, m_nodes, IS_OK(ans) ? m_count : 0);
+        }
+        beginFrame(false);
+    }
+
+private:
+    FrameDecoder &m_decoder;
+    State m_state;
+    uint8_t m_prev;                   ///< last byte seen while hunting
+    int m_block;                      ///< block being parsed
+    int m_pos;                        ///< byte offset inside the block or trailer
+    uint16_t m_angle;                 ///< start angle of the block
+    uint16_t m_addAngle;              ///< angle increment of the block so far
+    uint32_t m_word;                  ///< data word being assembled
+    bool m_blockEnded;                ///< a zero word ended the points of the block
+    bool m_discard;                   ///< the frame was joined in the middle
+    uint32_t m_trailer[TRAILER_SIZE / 4]; ///< timeStamp_s, timeStamp_ms, factory
+    size_t m_count;                   ///< points of the frame so far
+    node_info m_nodes[DATABLOCK_COUNT * DATA_COUNT];
+    uint64_t m_frames;
+    uint64_t m_resyncs;
+};
+
+}//namespace lidar
+
+#endif // FRAME_PARSER_H
@@ -0,0 +1,284 @@
+#include "LidarDiscovery.h"
+#include <core/serial/common.h>
+#include <core/tools/cJSON.h>
+#include <core/common/lidar_help.h>
+
+namespace lidar {
+
+LidarDiscovery &LidarDiscovery::instance() {
+    static LidarDiscovery discovery;
+    return discovery;
+}
+
+
+LidarDiscovery::LidarDiscovery()
+    : m_socket(NULL)
+    , m_refs(0)
+    , m_ttl(DEFAULT_TTL) {
+}
+
+
+LidarDiscovery::~LidarDiscovery() {
+    ScopedLocker lock(m_RefLock);
+    m_stop.requestStop();
+    m_thread.join();
+    if (m_socket) {
+        m_socket->Close();
+        delete m_socket;
+        m_socket = NULL;
+    }
+}
+
+
+bool LidarDiscovery::acquire(uint32_t port, const thread_attr &attr) {
+    ScopedLocker lock(m_RefLock);
+    if (m_refs > 0) {
+        m_refs++;
+        return true;
+    }
+
+    if (!m_socket) {
+        m_socket = new CPassiveSocket(CSimpleSocket::SocketTypeUdp);
+        m_socket->SetSocketType(CSimpleSocket::SocketTypeUdp);
+    }
+    if (!m_socket->IsSocketValid()) {
+        if (!m_socket->Initialize() || !m_socket->Listen(NULL, port)) {
+            m_socket->Close();
+            return false;
+        }
+    }
+    m_socket->SetReceiveTimeout(RECEIVE_TIMEOUT / 1000, (RECEIVE_TIMEOUT % 1000) * 1000);
+
+    m_stop.reset();
+    m_thread = CLASS_THREAD_ATTR(LidarDiscovery, listenLoop, attr);
+    if (m_thread.getHandle() == 0) {
+        m_socket->Close();
+        return false;
+    }
+    m_refs = 1;
+    return true;
+}
+
+
+void LidarDiscovery::release() {
+    ScopedLocker lock(m_RefLock);
+    if (m_refs == 0 || --m_refs > 0) {
+        return;
+    }
+    m_stop.requestStop();
+    m_thread.join();
+    if (m_socket) {
+        m_socket->Close();
+    }
+}
+
+
+void LidarDiscovery::setTTL(uint32_t ttl) {
+    ScopedLocker lock(m_Lock);
+    m_ttl = ttl;
+}
+
+
+void LidarDiscovery::subscribe(DiscoveryCallback callback, void *user) {
+    if (!callback) {
+        return;
+    }
+    Subscriber subscriber = {callback, user};
+    ScopedLocker lock(m_SubscriberLock);
+    m_subscribers.push_back(subscriber);
+}
+
+
+bool LidarDiscovery::unsubscribe(DiscoveryCallback callback, void *user) {
+    ScopedLocker lock(m_SubscriberLock);
+    for (std::vector<Subscriber>::iterator it = m_subscribers.begin(); it != m_subscribers.end(); ++it) {
+        if (it->callback == callback && it->user == user) {
+            m_subscribers.erase(it);
+            return true;
+        }
+    }
+    return false;
+}
+
+
+LidarDiscovery::Snapshot LidarDiscovery::snapshot() {
+    ScopedLocker lock(m_Lock);
+    if (!m_snapshot) {
+        std::shared_ptr<List> lst = std::make_shared<List>();
+        lst->reserve(m_registry.size());
+        for (std::unordered_map<std::string, Entry>::const_iterator it = m_registry.begin();
+             it != m_registry.end(); ++it) {
+            lst->push_back(it->second.info);
+        }
+        m_snapshot = lst;
+    }
+    return m_snapshot;
+}
+
+
+int LidarDiscovery::listenLoop() {
+    char buf[512];
+    std::vector<Change> events;
+    uint32_t last_sweep = getms();
+
+    while (!m_stop.stopRequested()) {
+        int wait = m_stop.waitReadable((int)m_socket->GetSocketDescriptor(), RECEIVE_TIMEOUT);
+        if (wait == StopToken::WAIT_STOPPED) {
+            break;
+        }
+        int32_t len = wait == StopToken::WAIT_READABLE ?
+                      m_socket->Receive(sizeof(buf) - 1, reinterpret_cast<uint8_t *>(buf)) : 0;
+        uint32_t now = getms();
+        events.clear();
+
+        if (len > 0) {
+            buf[len] = '\0';
+            update(m_socket->GetClientAddr(), buf, now, events);
+        }
+        if (now - last_sweep >= RECEIVE_TIMEOUT) {
+            expire(now, events);
+            last_sweep = now;
+        }
+        notify(events);
+    }
+    return RESULT_OK;
+}
+
+
+bool LidarDiscovery::parse(const char *payload, LidarListInfo &info) {
+    char name[64] = {0};
+    cJSON *item = NULL;
+    cJSON *root = cJSON_Parse(payload);
+    if (!root) {
+        return false;
+    }
+
+    strncpy(name, (const char*)valName(info.ip), sizeof(name));
+    valLastName(name);
+    item = cJSON_GetObjectItem(root, name);
+    if (!item || !cJSON_IsString(item)) {
+        cJSON_Delete(root);
+        return false;
+    }
+    info.ip = item->valuestring;
+
+    strncpy(name, (const char*)valName(info.model), sizeof(name));
+    valLastName(name);
+    item = cJSON_GetObjectItem(root, name);
+    info.model = item && cJSON_IsString(item) ? item->valuestring : "";
+
+    strncpy(name, (const char*)valName(info.hardware), sizeof(name));
+    valLastName(name);
+    item = cJSON_GetObjectItem(root, name);
+    info.hardware = item && cJSON_IsString(item) ? item->valuestring : "";
+
+    strncpy(name, (const char*)valName(info.software), sizeof(name));
+    valLastName(name);
+    item = cJSON_GetObjectItem(root, name);
+    info.software = item && cJSON_IsString(item) ? item->valuestring : "";
+
+    strncpy(name, (const char*)valName(info.serial), sizeof(name));
+    valLastName(name);
+    item = cJSON_GetObjectItem(root, name);
+    info.serial = item && cJSON_IsString(item) ? item->valuestring : "";
+
+    cJSON_Delete(root);
+    return true;
+}
+
+
+void LidarDiscovery::update(const char *source, const char *payload, uint32_t now, std::vector<Change> &events) {
+    ScopedLocker lock(m_Lock);
+    Source &src = m_sources[source];
+
+    //a lidar repeats the same broadcast, only a new payload is parsed
+    if (!src.key.empty() && src.payload == payload) {
+        std::unordered_map<std::string, Entry>::iterator it = m_registry.find(src.key);
+        if (it != m_registry.end()) {
+            it->second.last_seen = now;
+            return;
+        }
+    }
+
+    LidarListInfo info;
+    if (!parse(payload, info)) {
+        m_sources.erase(source);
+        return;
+    }
+    std::string key = info.serial.empty() ? info.ip : info.serial;
+    //a sender that changes its identity leaves the old entry to expire by TTL
+    src.payload = payload;
+    src.key = key;
+
+    std::unordered_map<std::string, Entry>::iterator it = m_registry.find(key);
+    if (it == m_registry.end()) {
+        Entry entry;
+        entry.info = info;
+        entry.last_seen = now;
+        m_registry[key] = entry;
+        m_snapshot.reset();
+        Change change = {info, DiscoveryAdded};
+        events.push_back(change);
+        //LOGD("Find a new device, ip: %s, model: %s, hardware: %s, software: %s ",
+              //info.ip.c_str(), info.model.c_str(), info.hardware.c_str(), info.software.c_str());
+        return;
+    }
+    it->second.last_seen = now;
+    if (it->second.info.ip != info.ip || it->second.info.model != info.model ||
+        it->second.info.hardware != info.hardware || it->second.info.software != info.software) {
+        it->second.info = info;
+        m_snapshot.reset();
+        Change change = {info, DiscoveryChanged};
+        events.push_back(change);
+    }
+}
+
+
+void LidarDiscovery::expire(uint32_t now, std::vector<Change> &events) {
+    ScopedLocker lock(m_Lock);
+    for (std::unordered_map<std::string, Entry>::iterator it = m_registry.begin(); it != m_registry.end();) {
+        if (now - it->second.last_seen > m_ttl) {
+            Change change = {it->second.info, DiscoveryRemoved};
+            events.push_back(change);
+            it = m_registry.erase(it);
+            m_snapshot.reset();
+        } else {
+            ++it;
+        }
+    }
+    for (std::unordered_map<std::string, Source>::iterator it = m_sources.begin(); it != m_sources.end();) {
+        if (m_registry.find(it->second.key) == m_registry.end()) {
+            it = m_sources.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+
+void LidarDiscovery::notify(const std::vector<Change> &events) {
+    if (events.empty()) {
+        return;
+    }
+    //a callback may subscribe or unsubscribe, it runs on a copy without the lock
+    std::vector<Subscriber> subscribers;
+    {
+        ScopedLocker lock(m_SubscriberLock);
+        subscribers = m_subscribers;
+    }
+    for (size_t i = 0; i < events.size(); i++) {
+        DiscoveredLidar lidar;
+        memset(&lidar, 0, sizeof(lidar));
+        const LidarListInfo &info = events[i].info;
+        snprintf(lidar.ip.data, sizeof(lidar.ip.data), "%s", info.ip.c_str());
+        snprintf(lidar.model.data, sizeof(lidar.model.data), "%s", info.model.c_str());
+        snprintf(lidar.hardware.data, sizeof(lidar.hardware.data), "%s", info.hardware.c_str());
+        snprintf(lidar.software.data, sizeof(lidar.software.data), "%s", info.software.c_str());
+        snprintf(lidar.serial.data, sizeof(lidar.serial.data), "%s", info.serial.c_str());
+        for (size_t j = 0; j < subscribers.size(); j++) {
+            subscribers[j].callback(events[i].event, &lidar, subscribers[j].user);
+        }
+    }
+}
+
+}//namespace lidar
@@ -0,0 +1,133 @@
+#ifndef LIDAR_DISCOVERY_H
+#define LIDAR_DISCOVERY_H
+#include <core/base/thread.h>
+#include <core/base/locker.h>
+#include <core/base/stop_token.h>
+#include <core/common/lidar_def.h>
+#include <core/common/lidar_protocol.h>
+#include <core/network/PassiveSocket.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+namespace lidar {
+
+using namespace core::base;
+using namespace core::network;
+
+/**
+ * @brief Process-wide listener of the lidar broadcasts \n
+ * All drivers of a process share one socket on the broadcast port.
+ * Lidars are kept in a hashed registry keyed by serial number, or by IP
+ * when the broadcast has no serial number, and expire when no broadcast
+ * was heard within the TTL. Unchanged broadcasts only refresh the entry,
+ * they are not parsed again, a changed one is reported as DiscoveryChanged.
+ */
+class LidarDiscovery {
+public:
+    enum {
+        DEFAULT_LIST_PORT = 7777,    /**< Broadcast port. */
+        DEFAULT_TTL = 5000,          /**< Entry lifetime without broadcast(ms). */
+        RECEIVE_TIMEOUT = 500,       /**< Receive timeout of the listener(ms). */
+    };
+
+    typedef std::vector<LidarListInfo> List;
+    typedef std::shared_ptr<const List> Snapshot;
+
+    /**
+     * @brief the process-wide instance
+     */
+    static LidarDiscovery &instance();
+
+    /**
+     * @brief start listening, the listener is shared and reference counted
+     * @param port  broadcast port, only the first caller's port is used
+     * @param attr  listener thread attributes, only the first caller's are used
+     * @return true if the listener is running, only then ::release must be called
+     */
+    bool acquire(uint32_t port = DEFAULT_LIST_PORT, const thread_attr &attr = thread_attr("lidar-discovery"));
+
+    /**
+     * @brief stop listening when the last user releases the listener
+     */
+    void release();
+
+    /**
+     * @brief set the entry lifetime
+     * @param ttl  lifetime without broadcast(ms)
+     */
+    void setTTL(uint32_t ttl);
+
+    /**
+     * @brief subscribe to add/change/remove events
+     * @param callback  event callback
+     * @param user      user data passed to the callback
+     */
+    void subscribe(DiscoveryCallback callback, void *user);
+
+    /**
+     * @brief unsubscribe a callback given to ::subscribe
+     * @param callback  event callback
+     * @param user      user data given to ::subscribe
+     * @return false if the callback was not subscribed
+     * @note events already being delivered by the listener thread may still reach the callback
+     */
+    bool unsubscribe(DiscoveryCallback callback, void *user);
+
+    /**
+     * @brief online lidars
+     * @return immutable list, shared until the registry changes
+     */
+    Snapshot snapshot();
+
+private:
+    struct Entry {
+        LidarListInfo info;
+        uint32_t last_seen;   ///< getms() of the last broadcast
+    };
+
+    struct Source {
+        std::string payload;  ///< last raw broadcast of the sender
+        std::string key;      ///< registry key of the sender
+    };
+
+    struct Subscriber {
+        DiscoveryCallback callback;
+        void *user;
+    };
+
+    struct Change {
+        LidarListInfo info;
+        DiscoveryEvent event;
+    };
+
+    LidarDiscovery();
+    ~LidarDiscovery();
+    LidarDiscovery(const LidarDiscovery &);
+    LidarDiscovery &operator=(const LidarDiscovery &);
+
+    int listenLoop();
+    bool parse(const char *payload, LidarListInfo &info);
+    void update(const char *source, const char *payload, uint32_t now, std::vector<Change> &events);
+    void expire(uint32_t now, std::vector<Change> &events);
+    void notify(const std::vector<Change> &events);
+
+private:
+    CPassiveSocket *m_socket;
+    Thread m_thread;
+    StopToken m_stop;          ///< ends the listener
+    int m_refs;
+    uint32_t m_ttl;
+    Locker m_RefLock;          ///< listener start/stop
+    Locker m_Lock;             ///< registry
+    Locker m_SubscriberLock;   ///< subscribers, events are delivered in order by the listener thread
+    std::unordered_map<std::string, Entry> m_registry;
+    std::unordered_map<std::string, Source> m_sources;
+    std::vector<Subscriber> m_subscribers;
+    Snapshot m_snapshot;       ///< NULL when the registry changed since the last snapshot
+};
+
+}//namespace lidar
+
+#endif // LIDAR_DISCOVERY_H
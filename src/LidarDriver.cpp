@@ -1,6 +1,7 @@
 #include "LidarDriver.h"
 #include <core/serial/common.h>
 #include <math.h>
+#include <algorithm>
 #include <core/tools/cJSON.h>
 #include <core/base/thread.h>
 #include <core/common/lidar_help.h>
@@ -10,22 +11,27 @@ namespace lidar {
 LidarDriver::LidarDriver() {
     m_ip = "192.168.0.11";
     m_cmd_port = 8090;
-    m_data_port = 8000;
     m_list_port = 7777;
+    m_dataTimeout = DEFAULT_TIMEOUT;
     m_socket_cmd = new CActiveSocket(CSimpleSocket::SocketTypeTcp);
     m_socket_cmd->SetConnectTimeout(DEFAULT_CONNECTION_TIMEOUT_SEC, DEFAULT_CONNECTION_TIMEOUT_USEC);
     m_socket_data = new CPassiveSocket(CSimpleSocket::SocketTypeUdp);
     m_socket_data->SetSocketType(CSimpleSocket::SocketTypeUdp);
-    m_socket_list = new CPassiveSocket(CSimpleSocket::SocketTypeUdp);
-    m_socket_list->SetSocketType(CSimpleSocket::SocketTypeUdp);
+    m_discovering = false;
+    m_cmdConnecting = false;
+    memset(&m_lidarConfig, -1, sizeof(m_lidarConfig));
+    m_decoder.setMetrics(&m_Metrics);
+    //drivers started together still reconnect apart
+    m_jitter.seed((uint32_t)(getns() ^ (uint64_t)(uintptr_t)this));
 
     //父类成员变量
-    m_ScanNodeBuf = new node_info[MAX_SCAN_NODES];
+    allocScanBuffer();
 }
 
 
 LidarDriver::~LidarDriver() {
     disconnect();
+    m_State.cancel();
     ScopedLocker data_lock(m_DataLock);
     if (m_socket_data) {
         delete m_socket_data;
@@ -36,11 +42,6 @@ LidarDriver::~LidarDriver() {
         delete m_socket_cmd;
         m_socket_cmd = NULL;
     }
-    ScopedLocker list_lock(m_ListLock);
-    if (m_socket_list) {
-        delete m_socket_list;
-        m_socket_list = NULL;
-    }
     if (m_ScanNodeBuf) {
         delete[]  m_ScanNodeBuf;
         m_ScanNodeBuf = nullptr;
@@ -51,21 +52,34 @@ LidarDriver::~LidarDriver() {
                                                      本类的私有函数
 ---------------------------------------------------------------------------------------------------------------*/
 
-bool LidarDriver::configPortConnect(const char *lidarIP, int tcpPort, uint32_t timeout) {
-    ScopedLocker lock(m_CmdLock);
-    if (!m_socket_cmd) {
-        return false;
-    }
-
-    if (!m_socket_cmd->IsSocketValid()) {
+bool LidarDriver::configPortConnect(const char *lidarIP, int tcpPort, uint32_t timeout, uint32_t connect_timeout) {
+    int fd = -1;
+    {
+        ScopedLocker lock(m_CmdLock);
+        if (!m_socket_cmd || m_cmdConnecting) {
+            return false;
+        }
+        if (m_socket_cmd->IsSocketValid()) {
+            return true;
+        }
         if (!m_socket_cmd->Initialize()) {
             return false;
         }
-    }else {
-        return m_socket_cmd->IsSocketValid();
+        m_socket_cmd->SetNonblocking();
+        if (!m_socket_cmd->StartConnect(lidarIP, tcpPort)) {
+            m_socket_cmd->Close();
+            return false;
+        }
+        m_cmdConnecting = true;
+        fd = (int)m_socket_cmd->GetSocketDescriptor();
     }
-    m_socket_cmd->SetNonblocking();
-    if (!m_socket_cmd->Open(lidarIP, tcpPort)) { 
+
+    //an unreachable lidar holds neither the lock nor a stopping thread
+    int wait = m_StopToken.waitWritable(fd, connect_timeout);
+
+    ScopedLocker lock(m_CmdLock);
+    m_cmdConnecting = false;
+    if (wait != StopToken::WAIT_READABLE || !m_socket_cmd->FinishConnect()) {
         m_socket_cmd->Close();
         return false;
     }
@@ -82,6 +96,9 @@ bool LidarDriver::configPortDisconnect() {
     if (!m_socket_cmd) {
             return false;
     }
+    if (m_cmdConnecting) {
+        return false;//closed by the connect if it fails
+    }
     return m_socket_cmd->Close();
 }
 
@@ -98,7 +115,9 @@ bool LidarDriver::configPortTransfer(char *transBuf, int transLen, char *recvBuf
     }while(len < transLen);
     
     //LOGD("TCP SEND(%d):\n%s", len, transBuf);
-    if (m_socket_cmd->Select(0, 800000)) {
+    //a stop ends the wait at once
+    if (m_StopToken.waitReadable((int)m_socket_cmd->GetSocketDescriptor(), ANSWER_TIMEOUT) ==
+        StopToken::WAIT_READABLE) {
         if(m_socket_cmd->Receive(recvMaxSize, reinterpret_cast<uint8_t *>(recvBuf)) > 0) {
             return true;
         }
@@ -129,9 +148,14 @@ result_t LidarDriver::configMessage(char op, const char *descriptor, int &value,
         return RESULT_FAIL;
     }    
     if(!configPortTransfer(transbuf, strlen(transbuf), recvbuf, sizeof(recvbuf))) {
+        //a late answer must not be read by the next command
         configPortDisconnect();
+        if (!m_StopToken.stopRequested()) {
+            m_Liveness.onControl(false, getms());
+        }
         return RESULT_FAIL;
     }
+    m_Liveness.onControl(true, getms());
     //configPortDisconnect();
 
     root = cJSON_Parse(recvbuf);
@@ -180,7 +204,8 @@ bool LidarDriver::dataPortConnect(const char *lidarIP, int localPort) {
                 m_socket_data->Close();
                 return false;
             }
-            m_socket_data->SetReceiveTimeout(DEFAULT_TIMEOUT / 1000, (DEFAULT_TIMEOUT % 1000) * 1000);
+            m_socket_data->SetReceiveTimeout(m_dataTimeout / 1000, (m_dataTimeout % 1000) * 1000);
+            m_socket_data->SetReceiveTimestamp(true);
         }
     }
     return m_socket_data->IsSocketValid();
@@ -199,64 +224,67 @@ bool LidarDriver::dataPortDisconnect() {
 
 
 void LidarDriver::disableDataGrabbing() {
-    ScopedLocker l(m_Lock);
+    //the ingest thread takes m_Lock to publish, join without it
+    m_StopToken.requestStop();
     m_DataEvent.set();
     m_Thread.join();
+    //the heartbeat is joined before, the commands that follow wait again
+    m_StopToken.reset();
 }
 
 
-bool LidarDriver::listPortConnect(const char *lidarIP, int localPort) {
-    ScopedLocker lock(m_ListLock);
-
-    if (!m_socket_list) {
-        return false;
-    }
-    if (!m_socket_list->IsSocketValid()) {
-        if (m_socket_list->Initialize()) {
-            if (!m_socket_list->Listen(NULL, localPort)) {
-                m_socket_list->Close();
-                return false;
-            }
-            //m_socket_list->SetReceiveTimeout(DEFAULT_TIMEOUT / 1000, (DEFAULT_TIMEOUT % 1000) * 1000);
-        }
-    }
-
-    if (!IS_OK(createGetListThread())){
-        return false;
-    }
-
-    return m_socket_list->IsSocketValid();
+bool LidarDriver::probeConfigPort(uint32_t timeout) {
+    return configPortConnect(m_ip.c_str(), m_cmd_port, DEFAULT_TIMEOUT, timeout);
 }
 
 
-bool LidarDriver::listPortDisconnect() {
-    ScopedLocker lock(m_ListLock);
-    if (!m_socket_list) {
-        return false;
-    }
-    m_ListThread.join();
-    return m_socket_list->Close();
-}
-
+result_t LidarDriver::checkAutoConnecting(node_info *nodebuffer, size_t &count) {
+    uint32_t backoff = DEFAULT_RECONNECT_MIN_DELAY;
+    result_t ans = RESULT_TIMEOUT;
 
-result_t LidarDriver::checkAutoConnecting() {
-    int retryConnect = 0;
-    setIsAutoconnting(true);
-    while(getIsAutoReconnect()) {
-        disconnect();
-        retryConnect = retryConnect > 25 ? 25 : retryConnect + 1;
-        for(int i = 0; i < retryConnect; i++){
-            delay(200);    
+    count = 0;
+    if (!m_State.transition(DriverStateMachine::mask(DriverStateScanning), DriverStateReconnecting)) {
+        return RESULT_FAIL;//stopping
+    }
+    //the command connection is most likely stale, the data port stays bound
+    configPortDisconnect();
+    while(getIsAutoReconnect() && getIsAutoconnting() && !m_StopToken.stopRequested()) {
+        //listen for frames during a jittered backoff period, a valid frame of the lidar means the link is back
+        uint32_t period = backoff / 2 + m_jitter() % (backoff / 2 + 1);
+        uint32_t start = getms();
+        while (getIsAutoReconnect() && getIsAutoconnting() && !m_StopToken.stopRequested() &&
+               getms() - start < period) {
+            ans = waitScanData(nodebuffer, count);
+            m_Liveness.update(getms());
+            if (IS_OK(ans)) {
+                break;
+            }
+            count = 0;
         }
-        LOGD("Reconnecting...");
-        if(!IS_OK(connect(m_ip.c_str(), m_cmd_port))) {
-            setDriverError(NotOpenError);
-        }else {
+        if (IS_OK(ans)) {
+            LOGD("Data stream resumed");
             setDriverError(NoError);
             break;
         }
+
+        //every step until frames arrive, a lidar still booting accepts the connection before it can scan
+        if (getIsAutoReconnect() && getIsAutoconnting() && !m_StopToken.stopRequested()) {
+            LOGD("Reconnecting...");
+            //a failing heartbeat would close the port between the probe and the start
+            ScopedLocker lock(m_ReconnectLock);
+            if (!probeConfigPort(backoff)) {
+                setDriverError(NotOpenError);
+            } else if (!IS_OK(startMeasure())) {
+                //the lidar may have restarted, asked again at the next step
+                LOGD("Start command not accepted yet");
+            }
+        }
+        backoff = std::min<uint32_t>(backoff * 2, DEFAULT_RECONNECT_MAX_DELAY);
+    }
+    //stopScan moves the driver to DriverStateStopping, the receiving thread has to exit
+    if (!m_State.transition(DriverStateMachine::mask(DriverStateReconnecting), DriverStateScanning)) {
+        return RESULT_FAIL;
     }
-    setIsAutoconnting(false);
     return RESULT_OK;
 }
 
@@ -267,17 +295,23 @@ int32_t LidarDriver::receiveData(uint8_t *buf, uint32_t len) {
     if (!m_socket_data) {
             return -1;
     }
-    return m_socket_data->Receive(len, buf);
+    //a stop ends the wait at once, the receive timeout stays as a fallback
+    if (m_StopToken.waitReadable((int)m_socket_data->GetSocketDescriptor(), m_dataTimeout) !=
+        StopToken::WAIT_READABLE) {
+        return -1;
+    }
+    int32_t ret = m_socket_data->Receive(len, buf);
+    if (ret > 0 && m_recorder.isOpen()) {
+        const struct sockaddr_in &src = m_socket_data->GetClientSockaddr();
+        m_recorder.write(m_socket_data->GetReceiveTimestamp(), src.sin_addr.s_addr,
+                         ntohs(src.sin_port), buf, ret);
+    }
+    return ret;
 }
 
 
 
 result_t LidarDriver::waitScanData(node_info *nodebuffer, size_t &count, uint32_t timeout) {
-
-    DataFrame frame; 
-    node_info *n = NULL;
-    static uint16_t lastPointAngle = 0;
-    static uint8_t lastNum = 0xff;
     count = 0;
 
     // if (!getIsConnected()) {
@@ -285,147 +319,113 @@ result_t LidarDriver::waitScanData(node_info *nodebuffer, size_t &count, uint32_
     //     return RESULT_FAIL;
     // }
 
-    int len = receiveData((uint8_t*)&frame, sizeof(frame));
+    int len = receiveData(m_frameBuf, sizeof(m_frameBuf));
     if(len <= 0){
         return RESULT_TIMEOUT;
-    } else if(len < sizeof(frame)){
-        return RESULT_FAIL;
-    } else if (strcmp(m_ip.c_str(), m_socket_data->GetClientAddr()) != 0) {
-        return RESULT_OTHER;
     }
-
-    for(int i = 0; i < DATABLOCK_COUNT; i++) {
-        if (BigLittleSwap16(frame.dataBlock[i].frameHead) != 0xFFEE) {
-            //LOGE("data error, frameHead[%d] != 0xFFEE", i);
-            return RESULT_FAIL;
-        }
-    }
-
-    // if((BigLittleSwap32(frame.factory) & 0xFFF0FFFF) != 0x21300000) {
-    //     LOGE("(data error, factory & 0xFFF0FFFF) != 0x21300000");
-    //     return RESULT_FAIL;
-    // }
-    // if((BigLittleSwap32(frame.factory) & 0xF0FFFFFF) != 0x00123456) {
-    //     LOGE("(data error, factory & 0xF0FFFFFF) != 0x00123456");
-    //     return RESULT_FAIL;
-    // }
-
-
-    //uint8_t curNum = (BigLittleSwap32(frame.factory) & 0x000F0000) >> 16;
-    uint8_t curNum = (BigLittleSwap32(frame.factory) & 0x0F000000) >> 24;
-    static bool isFirst = true;
-    if((curNum - lastNum != 1) && (curNum - lastNum != -15)) {
-	if (!isFirst) {
-            //LOGE("data packet dropout, curNum = %d, lastNum = %d", curNum, lastNum);
-	}
-	isFirst = false;
-        lastNum = curNum;
+    uint64_t start = getns();
+    //kernel receive time moved from the realtime clock to getns()
+    uint64_t received = start;
+    uint64_t kernel = m_socket_data->GetReceiveTimestamp();
+    uint64_t wall = getTime();
+    if (kernel && kernel < wall) {
+        received -= std::min(wall - kernel, start);
+    }
+    //datagrams of other hosts are not errors of this lidar, whatever their size
+    if (strcmp(m_ip.c_str(), m_socket_data->GetClientAddr()) != 0) {
+        m_Metrics.foreign_packets.add();
+        return RESULT_OTHER;
+    } else if (len < (int)sizeof(DataFrame)) {
+        m_Metrics.onPacket(len, start);
+        m_Metrics.frame_errors.add();
         return RESULT_FAIL;
     }
-    lastNum = curNum;
-    for(int i = 0; i < DATABLOCK_COUNT; i++) {
-        uint16_t startAngle = BigLittleSwap16(frame.dataBlock[i].startAngle);
-        uint16_t addAngle = 0;
-        for(int j = 0; j < DATA_COUNT; j++) {
-            uint32_t data = BigLittleSwap32(frame.dataBlock[i].data[j]);
-            if(data != 0) {
-                n = nodebuffer + count;
-                addAngle += ((data & 0x3f000000) >> 24);
-                n->angle_q6_checkbit = startAngle + addAngle;
-                n->sync_flag = (n->angle_q6_checkbit < lastPointAngle) ? Node_Sync : Node_NotSync;//当前点的角度小于上一个点的角度，则认为当前点为零位点
-                n->sync_quality = (data & 0xff0000) >> 16;
-                n->distance_q2 = (data & 0xffff) >> 0;
-                //n->stamp = timeStamp;
-                lastPointAngle = n->angle_q6_checkbit;
-                count++;
-            }else {
-                break;
-                i = DATABLOCK_COUNT;
-            }
+    m_Metrics.onPacket(len, start);
+    result_t ans = m_decoder.decode(m_frameBuf, len, nodebuffer, count);
+    uint64_t decoded = getns();
+    m_Metrics.decode.record(decoded - start);
+    if (IS_OK(ans)) {
+        tracePacket(received, decoded);
+        if (count) {
+            //the last point carries the stamp of the packet
+            m_Clock.sample(nodebuffer[count - 1].stamp, kernel && kernel < wall ? kernel : wall);
         }
     }
-
-    static uint64_t lastTimeStamp = 0;
-    static uint64_t TimeStampTmp = 0;
-
-    TimeStampTmp = BigLittleSwap32(frame.timeStamp_s) * 1000 + BigLittleSwap32(frame.timeStamp_ms); //ms
-
-    for (int i = 0; i < count; i++) {
-        n = nodebuffer + i;
-        n->stamp = TimeStampTmp - (TimeStampTmp - lastTimeStamp) * (count - i - 1) / count;  //ms
-    }
-    lastTimeStamp = TimeStampTmp;
-
-    return RESULT_OK;
+    return ans;
 }
 
 
 result_t LidarDriver::cacheScanData() {
     //LOGD("Thread Start:  [%s]", __func__);
     node_info      local_buf[DATABLOCK_COUNT * DATA_COUNT];
-    node_info      local_scan[MAX_SCAN_NODES];
-    size_t         timeout_count = 0;
-    size_t         scan_count = 0;
+    ScanAssembler  assembler(getScanCapacity(), getScanSpacing(), getFieldOfView());
+    uint32_t       last_data_time = getms();
+    bool           receiving = false;
     size_t         count = 0;
     result_t       ans = RESULT_FAIL;
 
+    //the decoder writes the same fields of every point, the others stay zero
     memset(&local_buf, 0, sizeof(local_buf));
-    memset(&local_scan, 0, sizeof(local_scan));
-    while (!IS_OK(waitScanData(local_buf, count)));//丢弃一包
+    allocScanBuffer();
+    traceReset();
 
-    while (getIsScanning()) {
+    //no packet is discarded on startup, the first revolution starts at the first sync point
+    while (getIsScanning() && !m_StopToken.stopRequested()) {
         count = 0;
-        memset(local_buf, 0, sizeof(local_buf));
         ans = waitScanData(local_buf, count);
+        if (IS_OK(ans)) {
+            m_Liveness.onPacket(getms());
+        }
+        m_Liveness.update(getms());
         if(IS_FAIL(ans)){
             LOGE("bad data block!!!");
-            waitScanData(local_buf, count);//丢弃一包
-            local_scan[0].sync_flag = Node_Sync;    
+            assembler.markSync();
             continue;
         }else if(IS_TIMEOUT(ans)){
-            timeout_count++;
-            //LOGE("get data timeout(%d)!!!", timeout_count);
-            if(timeout_count > DEFAULT_TIMEOUT_COUNT){
-                setDriverError(TimeoutError);
-                if(IS_OK(checkAutoConnecting())) {
-                    waitScanData(local_buf, count);//丢弃一包
-                    local_scan[0].sync_flag = Node_Sync;  
-                    timeout_count = 0;
-                }else {
-                    LOGE("exit scanning thread!!!");
-                    return RESULT_FAIL;
-                }
+            //the receive timeout follows the liveness timeout, the silence before reconnecting does not,
+            //the motor spin-up is given the full timeout
+            uint32_t silence = receiving ? DEFAULT_HEART_BEAT : DEFAULT_TIMEOUT * (DEFAULT_TIMEOUT_COUNT + 1);
+            //LOGE("get data timeout(%u ms)!!!", getms() - last_data_time);
+            if(getms() - last_data_time <= silence){
+                continue;
             }
-            continue;
+            setDriverError(TimeoutError);
+            if(!IS_OK(checkAutoConnecting(local_buf, count))) {
+                LOGE("exit scanning thread!!!");
+                return RESULT_FAIL;
+            }
+            last_data_time = getms();
+            if (count == 0) {
+                continue;
+            }
+            //the first frame after the outage continues the revolution being assembled
+            m_Liveness.onPacket(last_data_time);
         } else if (IS_OTHER(ans)) {
             continue;
         } else{
-            timeout_count = 0;
+            last_data_time = getms();
+            receiving = true;
+            markStartup(m_StartupTiming.first_packet);
         }
 
-        for (size_t pos = 0; pos < count; pos++) {
-            if (local_buf[pos].sync_flag & Node_Sync) {
-                if ((local_scan[0].sync_flag & Node_Sync)) {
-                    m_Lock.lock();//timeout lock, wait resource copy
-                    memcpy(m_ScanNodeBuf, local_scan, scan_count * sizeof(node_info));
-                    m_ScanNodeCount = scan_count;
-                    m_DataEvent.set();
-                    m_Lock.unlock();
-                }
-                scan_count = 0;
-            }
-            local_scan[scan_count++] = local_buf[pos];
-            if (scan_count == _countof(local_scan)) {
-                scan_count -= 1;
+        assembler.push(local_buf, count, [this](const node_info *scan, size_t scan_count, const ScanStats &stats) {
+            publishScan(scan, scan_count, stats);
+            if (markStartup(m_StartupTiming.first_scan)) {
+                LOGD("Time to first scan: %u ms (connect %u ms, start %u ms, first packet %u ms)",
+                     m_StartupTiming.first_scan - m_StartupTiming.connect_start,
+                     m_StartupTiming.connected - m_StartupTiming.connect_start,
+                     m_StartupTiming.scan_started - m_StartupTiming.scan_start,
+                     m_StartupTiming.first_packet - m_StartupTiming.scan_start);
             }
-        }       
+        });
     }
     return RESULT_OK;
 }
 
 
 result_t LidarDriver::createThread() {
-    m_Thread = CLASS_THREAD(LidarDriver, cacheScanData);
+    thread_attr attr = ingestAttr("lidar-ingest");
+    m_Thread = CLASS_THREAD_ATTR(LidarDriver, cacheScanData, attr);
     if (m_Thread.getHandle() == 0) {
         return RESULT_FAIL;
     }
@@ -433,99 +433,85 @@ result_t LidarDriver::createThread() {
 }
 
 
-result_t LidarDriver::GetListInfo() {
-    //LOGD("Thread Start:  [%s]", __func__);
-    char name[64] = {0};
-    char buf[256] = {0};
-    int i;
-    
-    while (1) {
-        if (!m_socket_list) {
-            return -1;
-        }
-        memset(buf, 0, sizeof(buf));
+int LidarDriver::heartBeatLoop() {
+    uint32_t interval = m_Liveness.getConfig().heartbeat_interval;
+    int value = 0;
 
-        if(m_socket_list->Receive(sizeof(buf), (uint8_t*)buf) > 0) {
-            LidarListInfo lst;
-            cJSON *item = NULL;
-            cJSON *root = cJSON_Parse(buf);
-            if (!root){
-                return RESULT_FAIL;
-            }
-
-            strncpy(name, (const char*)valName(lst.ip), sizeof(name));
-            valLastName(name); 
-            item = cJSON_GetObjectItem(root, name);
-            lst.ip = item->valuestring;
-
-            strncpy(name, (const char*)valName(lst.model), sizeof(name));
-            valLastName(name); 
-            item = cJSON_GetObjectItem(root, name);
-            lst.model = item->valuestring;
-
-            strncpy(name, (const char*)valName(lst.hardware), sizeof(name));
-            valLastName(name); 
-            item = cJSON_GetObjectItem(root, name);
-            lst.hardware = item->valuestring;
-
-            strncpy(name, (const char*)valName(lst.software), sizeof(name));
-            valLastName(name); 
-            item = cJSON_GetObjectItem(root, name);
-            lst.software = item->valuestring;
-            for(i = 0; i < m_lidarList.size(); i++) {
-                if(m_lidarList[i].ip == lst.ip) {
-                    break;
-                }
-            }
-            if(i >= m_lidarList.size()) {
-                m_lidarList.push_back(lst);
-                //LOGD("Find a new device, ip: %s, model: %s, hardware: %s, software: %s ", 
-                      //lst.ip.c_str(), lst.model.c_str(), lst.hardware.c_str(), lst.software.c_str());
+    while (getIsScanning()) {
+        {
+            //the reconnect owns the command port until frames are back
+            ScopedLocker lock(m_ReconnectLock);
+            if (!m_State.in(DriverStateMachine::mask(DriverStateReconnecting))) {
+                //the answer is recorded by configMessage
+                configMessage('r', valName(m_lidarConfig.heartbeat), value, interval);
             }
-            cJSON_Delete(root);
+        }
+        m_Liveness.update(getms());
+        if (!m_StopToken.sleep(interval)) {
+            break;
         }
     }
     return RESULT_OK;
 }
 
 
-result_t LidarDriver::createGetListThread() {
-    m_ListThread = CLASS_THREAD(LidarDriver, GetListInfo);
-    if (m_ListThread.getHandle() == 0) {
+result_t LidarDriver::createHeartBeatThread() {
+    thread_attr attr("lidar-heartbeat");
+    m_HeartBeatThread = CLASS_THREAD_ATTR(LidarDriver, heartBeatLoop, attr);
+    if (m_HeartBeatThread.getHandle() == 0) {
         return RESULT_FAIL;
     }
     return RESULT_OK;
 }
 
 
-
-
-
 /*--------------------------------------------------------------------------------------------------------------
                                         从DriverInterface虚基类继承的纯虚函数
 ---------------------------------------------------------------------------------------------------------------*/
 
 result_t LidarDriver::connect(const char *port_path, uint32_t baudrate) {
+    //reconnects while scanning keep the original bring-up timeline
+    if (!getIsScanning()) {
+        memset(&m_StartupTiming, 0, sizeof(m_StartupTiming));
+        m_StartupTiming.connect_start = getms();
+    }
+    if (!m_State.transition(DriverStateMachine::mask(DriverStateDisconnected) |
+                            DriverStateMachine::mask(DriverStateConfiguring), DriverStateConnecting)) {
+        LOGW("Cannot connect while scanning");
+        return RESULT_FAIL;
+    }
     m_ip = port_path;
     m_cmd_port = baudrate;
+    memset(&m_lidarConfig, -1, sizeof(m_lidarConfig));
 
+    //the command channel stays open, parameters and the start command reuse it
     if (!configPortConnect(port_path, baudrate)) {
         setDriverError(NotOpenError);
+        m_State.transition(DriverStateDisconnected);
         return RESULT_FAIL;
     }
-    configPortDisconnect();
 
-    if (!dataPortConnect(NULL, m_data_port)) {
+    if (!dataPortConnect(NULL, m_DataPort)) {
         setDriverError(NotOpenError);
+        m_State.transition(DriverStateDisconnected);
         return RESULT_FAIL;
     }
 
-    // if (!listPortConnect(NULL, m_list_port)) {
-    //     setDriverError(NotOpenError);
-    //     return RESULT_FAIL;
-    // }
+    //discovery is optional, another process may own the broadcast port
+    if (!m_discovering) {
+        //kept on the ingest cpus, without the real-time policy
+        thread_attr attr("lidar-discovery");
+        attr.cpus = m_ThreadAttr.cpus;
+        m_discovering = LidarDiscovery::instance().acquire(m_list_port, attr);
+        if (!m_discovering) {
+            LOGW("Lidar discovery is unavailable on port %u", m_list_port);
+        }
+    }
 
-    setIsConnected(true);
+    m_State.transition(DriverStateConfiguring);
+    if (m_StartupTiming.connected == 0) {
+        m_StartupTiming.connected = getms();
+    }
 
     LOGD("Network connect success!");
     return RESULT_OK;
@@ -533,10 +519,17 @@ result_t LidarDriver::connect(const char *port_path, uint32_t baudrate) {
 
 
 void LidarDriver::disconnect() {
+    //an active scan ends here as well, its threads see the state change and exit
+    m_State.transition(DriverStateDisconnected);
+    m_StopToken.requestStop();
+    m_HeartBeatThread.join();
+    disableDataGrabbing();
     configPortDisconnect();
     dataPortDisconnect();
-    // listPortDisconnect();
-    setIsConnected(false);
+    if (m_discovering) {
+        LidarDiscovery::instance().release();
+        m_discovering = false;
+    }
     LOGD("Network disconnection!");
 }
 
@@ -559,6 +552,7 @@ result_t LidarDriver::grabScanData(node_info *nodebuffer, size_t &count, uint32_
             memcpy(nodebuffer, m_ScanNodeBuf, size_to_copy * sizeof(node_info));
             count = size_to_copy;
             m_ScanNodeCount = 0;
+            traceGrab();
             return RESULT_OK;
         }
         
@@ -574,37 +568,71 @@ result_t LidarDriver::startScan(uint32_t timeout) {
         LOGD("The lidar is scanning");
         return RESULT_OK;
     }
-    if (!IS_OK(startMeasure())){
-        stopMeasure();
+    m_StartupTiming.scan_start = getms();
+    m_decoder.reset();
+
+    //wake up often enough to notice a data gap within the liveness timeout
+    liveness_config liveness = m_Liveness.getConfig();
+    m_dataTimeout = liveness.data_timeout / 2;
+    if (m_dataTimeout == 0 || m_dataTimeout > DEFAULT_TIMEOUT) {
+        m_dataTimeout = DEFAULT_TIMEOUT;
+    }
+    {
+        ScopedLocker lock(m_DataLock);
+        if (m_socket_data && m_socket_data->IsSocketValid()) {
+            m_socket_data->SetReceiveTimeout(m_dataTimeout / 1000, (m_dataTimeout % 1000) * 1000);
+        }
+    }
+    m_Liveness.start(getms());
+
+    //the receiving thread is already waiting when the first packet arrives
+    if (!m_State.transition(DriverStateMachine::mask(DriverStateConfiguring), DriverStateScanning)) {
+        LOGE("The lidar is not connected");
         return RESULT_FAIL;
     }
-    setIsScanning(true);  
+    m_StopToken.reset();
     if (!IS_OK(createThread())){
-        setIsScanning(false);  
+        m_State.transition(DriverStateConfiguring);
+        return RESULT_FAIL;
+    }
+    if (!IS_OK(startMeasure())){
+        m_State.transition(DriverStateConfiguring);
+        disableDataGrabbing();
         stopMeasure();
         return RESULT_FAIL;
     }
+    m_StartupTiming.scan_started = getms();
+    if (liveness.heartbeat_interval) {
+        if (!IS_OK(createHeartBeatThread())) {
+            LOGW("Failed to start the heartbeat");
+        }
+    }
     LOGD("The radar starts scanning");
     return RESULT_OK;
 }
 
 
 result_t LidarDriver::stopScan(uint32_t timeout) {
-    if(!getIsScanning()){
+    //a reconnect in progress is abandoned by the state change, nothing to wait for
+    if (!m_State.transition(DriverStateMachine::mask(DriverStateScanning) |
+                            DriverStateMachine::mask(DriverStateReconnecting), DriverStateStopping)) {
         LOGD("The lidar is not scanning");
         return RESULT_OK;
     }
-    if(getIsAutoconnting()){
-        setIsAutoReconnect(false);
-        while(getIsAutoconnting());
-        setIsAutoReconnect(true);
-    }
+    m_StopToken.requestStop();
+    m_HeartBeatThread.join();
+    disableDataGrabbing();
+    m_Liveness.stop();
 
-    if (!IS_OK(stopMeasure())){
+    //the command port may have been closed by a reconnect
+    result_t ans = RESULT_FAIL;
+    if (configPortConnect(m_ip.c_str(), m_cmd_port)) {
+        ans = stopMeasure();
+    }
+    m_State.transition(DriverStateMachine::mask(DriverStateStopping), DriverStateConfiguring);
+    if (!IS_OK(ans)) {
         return RESULT_FAIL;
     }
-    setIsScanning(false);  
-    disableDataGrabbing();
     LOGD("Radar stop scanning");
     return RESULT_OK;
 }
@@ -620,10 +648,15 @@ result_t LidarDriver::getScanFrequency(scan_frequency &frequency, uint32_t timeo
 
 
 result_t LidarDriver::setScanFrequency(scan_frequency &frequency, uint32_t timeout) {
-    m_lidarConfig.motorSpeed = frequency.frequency;
-    if(!IS_OK(configMessage('w', valName(m_lidarConfig.motorSpeed), m_lidarConfig.motorSpeed))) {
+    int motorSpeed = frequency.frequency;
+    if (motorSpeed == m_lidarConfig.motorSpeed) {
+        return RESULT_OK;//already applied
+    }
+    if(!IS_OK(configMessage('w', valName(m_lidarConfig.motorSpeed), motorSpeed))) {
+        m_lidarConfig.motorSpeed = -1;
         return RESULT_FAIL;
     }
+    m_lidarConfig.motorSpeed = motorSpeed;
     return RESULT_OK;
 }
 
@@ -637,10 +670,15 @@ result_t LidarDriver::getSamplingRate(sampling_rate &rate, uint32_t timeout) {
 
 
 result_t LidarDriver::setSamplingRate(sampling_rate &rate, uint32_t timeout) {
-    m_lidarConfig.samplerate = rate.rate;
-    if(!IS_OK(configMessage('w', valName(m_lidarConfig.samplerate), m_lidarConfig.samplerate))) {
+    int samplerate = rate.rate;
+    if (samplerate == m_lidarConfig.samplerate) {
+        return RESULT_OK;//already applied
+    }
+    if(!IS_OK(configMessage('w', valName(m_lidarConfig.samplerate), samplerate))) {
+        m_lidarConfig.samplerate = -1;
         return RESULT_FAIL;
     }
+    m_lidarConfig.samplerate = samplerate;
     return RESULT_OK;
 }
 
@@ -656,11 +694,26 @@ const char* LidarDriver::DescribeError(bool isTCP) {
 }
 
 
+result_t LidarDriver::startRecord(const char *path) {
+    if (!path || !path[0]) {
+        return RESULT_FAIL;
+    }
+    ScopedLocker lock(m_DataLock);
+    return m_recorder.open(path) ? RESULT_OK : RESULT_FAIL;
+}
+
+
+void LidarDriver::stopRecord() {
+    ScopedLocker lock(m_DataLock);
+    m_recorder.close();
+}
+
+
 map<string, string> LidarDriver::lidarPortList() {
-    vector<LidarListInfo> lst = m_lidarList;
+    LidarDiscovery::Snapshot lst = LidarDiscovery::instance().snapshot();
     map<string, string> ports;
 
-    for (vector<LidarListInfo>::iterator it = lst.begin(); it != lst.end(); it++) {
+    for (LidarDiscovery::List::const_iterator it = lst->begin(); it != lst->end(); it++) {
         string port = "lidar" + (*it).ip;
         ports[port] = (*it).model;
     }
@@ -1,8 +1,12 @@
 #ifndef LIDAR_DRIVER_H
 #define LIDAR_DRIVER_H
 #include <stdlib.h>
+#include <random>
 #include <core/common/DriverInterface.h>
 #include <core/network/PassiveSocket.h>
+#include "LidarDiscovery.h"
+#include "FrameDecoder.h"
+#include "record/CaptureWriter.h"
 
 namespace lidar {
 
@@ -17,15 +21,24 @@ class LidarDriver : public DriverInterface {
 private:
     string m_ip;
     uint32_t m_cmd_port;
-    uint32_t m_data_port;
     uint32_t m_list_port;
     CActiveSocket *m_socket_cmd;
     CPassiveSocket *m_socket_data;
-    CPassiveSocket *m_socket_list;
-    Locker m_ListLock;
-    Thread m_ListThread;
-    vector<LidarListInfo> m_lidarList;
-    LidarConfig m_lidarConfig;
+    Thread m_HeartBeatThread;
+    uint32_t m_dataTimeout;           ///< receive timeout of the data port (ms)
+    bool m_discovering;               ///< holds a reference on the shared broadcast listener
+    LidarConfig m_lidarConfig;        ///< last values confirmed by the lidar, -1 if unknown
+    FrameDecoder m_decoder;           ///< DataFrame decoder, shared with capture replay
+    std::minstd_rand m_jitter;        ///< reconnect backoff jitter, receiving thread only
+    CaptureWriter m_recorder;         ///< raw datagram capture, open while recording
+    uint8_t m_frameBuf[sizeof(DataFrame) + 64]; ///< last received datagram
+    bool m_cmdConnecting;             ///< the command port connect is in progress, under m_CmdLock
+    Locker m_ReconnectLock;           ///< a heartbeat command or the probe and start of a reconnect step
+
+    enum {
+        ANSWER_TIMEOUT = 800,         ///< wait for the answer of a command(ms)
+        CONNECT_TIMEOUT = DEFAULT_CONNECTION_TIMEOUT_SEC * 1000 + DEFAULT_CONNECTION_TIMEOUT_USEC / 1000,///< command port connect(ms)
+    };
 
 public:
     /**
@@ -47,14 +60,18 @@ private:
 
     /**
      * @brief TCP connect(8090) \n
-     * @param[in] lidarIP    Ip Address
-     * @param[in] tcpPort     network port
-     * @param[in] timeout     timeout
+     * The connect is waited for without m_CmdLock and ends on a stop request,
+     * another caller fails while it is in progress.
+     * @param[in] lidarIP          Ip Address
+     * @param[in] tcpPort          network port
+     * @param[in] timeout          send and receive timeout(ms)
+     * @param[in] connect_timeout  connect timeout(ms)
      * @return connection status
      * @retval true  success
-     * @retval fase  failed
+     * @retval false failed
      */
-    bool configPortConnect(const char *lidarIP, int tcpPort = 8090, uint32_t timeout = DEFAULT_TIMEOUT);
+    bool configPortConnect(const char *lidarIP, int tcpPort = 8090, uint32_t timeout = DEFAULT_TIMEOUT,
+                           uint32_t connect_timeout = CONNECT_TIMEOUT);
 
     /**
      * @brief TCP disconnect(8090).
@@ -68,7 +85,7 @@ private:
      * @param[out] recvBuf      recv buffer
      * @param[out] recvMaxSize  recv max size
      * @retval true  success
-     * @retval fase  failed
+     * @retval false failed
      */
     bool configPortTransfer(char *transBuf, int transLen, char *recvBuf, int recvMaxSize);
 
@@ -79,7 +96,7 @@ private:
      * @param[out] recvBuf      The recv buffer
      * @param[out] recvMaxSize  recv max size
      * @retval true  success
-     * @retval fase  failed
+     * @retval false failed
      */
     result_t configMessage(char opn, const char *descriptor, int &value, uint32_t timeout = DEFAULT_TIMEOUT);
 
@@ -108,7 +125,7 @@ private:
      * @param[in] timeout     timeout
      * @return connection status
      * @retval true  success
-     * @retval fase  failed
+     * @retval false failed
      */
     bool dataPortConnect(const char *lidarIP, int localPort = 8000);
 
@@ -123,28 +140,25 @@ private:
     void disableDataGrabbing();
 
     /**
-     * @brief UDP connect(8001) \n
-     * @param[in] lidarIP    Ip Address
-     * @param[in] tcpPort     network port
-     * @param[in] timeout     timeout
-     * @return connection status
+     * @brief Probe the command port with a bounded timeout \n
+     * @param[in] timeout     connect timeout(ms)
      * @retval true  success
-     * @retval fase  failed
-     */
-    bool listPortConnect(const char *lidarIP, int localPort = 7777);
-
-    /**
-     * @brief UDP disconnect(8001).
+     * @retval false failed
      */
-    bool listPortDisconnect();
+    bool probeConfigPort(uint32_t timeout);
 
     /**
      * @brief Reconnect to the network \n
+     * The bound data port and the revolution being assembled are kept,
+     * the command port is probed with exponential backoff plus jitter
+     * and the function returns as soon as valid frames arrive again.
+     * @param[out] nodebuffer  points of the first frame after the outage
+     * @param[out] count       point count, 0 if no point is ready yet
      * @return result status
      * @retval RESULT_OK       success
      * @retval RESULT_FAILE    failed
      */
-    result_t checkAutoConnecting();
+    result_t checkAutoConnecting(node_info *nodebuffer, size_t &count);
 
     /**
      * @brief Receiving the scan data \n
@@ -167,14 +181,15 @@ private:
     result_t createThread();  
 
     /**
-     * @brief Receiving broadcast data \n
+     * @brief Periodic heartbeat request on the command port \n
      */
-    int GetListInfo();
+    int heartBeatLoop();
 
     /**
-     * @brief Creating a Process to receiving broadcast data \n
+     * @brief Creating a Process to send heartbeat requests \n
      */
-    result_t createGetListThread(); 
+    result_t createHeartBeatThread();
+
 
 
 
@@ -284,6 +299,18 @@ public:
      * @return online lidars
      */
     virtual map<string, string> lidarPortList(); 
+
+    /**
+     * @brief Start recording the raw datagrams of the data port
+     * @param path  capture file
+     * @return result status
+     */
+    virtual result_t startRecord(const char *path);
+
+    /**
+     * @brief Stop recording and close the capture file
+     */
+    virtual void stopRecord();
 };
 
 }// namespace lidar
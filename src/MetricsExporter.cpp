@@ -0,0 +1,307 @@
+#include "MetricsExporter.h"
+#include <core/serial/common.h>
+#include <core/common/lidar_help.h>
+#include <stddef.h>
+#include <stdio.h>
+
+namespace lidar {
+
+namespace {
+
+struct CounterInfo {
+    const char *name;
+    const char *help;
+    size_t offset;              ///< uint64_t field of LidarMetrics
+};
+
+const CounterInfo counters[] = {
+    {"lidar_packets_total", "Packets received from the lidar.", offsetof(LidarMetrics, packets)},
+    {"lidar_bytes_total", "Bytes received from the lidar.", offsetof(LidarMetrics, bytes)},
+    {"lidar_sequence_gaps_total", "Packets dropped because of a sequence number gap.", offsetof(LidarMetrics, sequence_gaps)},
+    {"lidar_frame_errors_total", "Short packets, bad frame heads and lost serial alignment.", offsetof(LidarMetrics, frame_errors)},
+    {"lidar_foreign_packets_total", "Datagrams from another address.", offsetof(LidarMetrics, foreign_packets)},
+    {"lidar_scans_total", "Revolutions published.", offsetof(LidarMetrics, scans)},
+    {"lidar_scans_overwritten_total", "Revolutions replaced before they were grabbed.", offsetof(LidarMetrics, scans_overwritten)},
+    {"lidar_scans_incomplete_total", "Revolutions published with lost packets or without their start.", offsetof(LidarMetrics, scans_incomplete)},
+    {"lidar_scans_truncated_total", "Revolutions cut because the scan buffer filled up.", offsetof(LidarMetrics, scans_truncated)},
+};
+
+struct GaugeInfo {
+    const char *name;
+    const char *help;
+    size_t offset;              ///< double field of LidarMetrics
+};
+
+const GaugeInfo gauges[] = {
+    {"lidar_scan_frequency_hertz", "Measured scan frequency, filtered.", offsetof(LidarMetrics, scan_frequency)},
+    {"lidar_scan_speed_jitter_ratio", "Revolution period jitter over the period, grows as the motor degrades.",
+     offsetof(LidarMetrics, scan_speed_jitter)},
+    {"lidar_scan_max_gap_degrees", "Widest angle between neighbouring points of the last revolution.",
+     offsetof(LidarMetrics, scan_max_gap)},
+    {"lidar_scan_coverage_ratio", "Share of the last revolution covered at the usual point spacing.",
+     offsetof(LidarMetrics, scan_coverage)},
+};
+
+/// label value with \, " and newlines escaped
+std::string escape(const std::string &value) {
+    std::string out;
+    for (size_t i = 0; i < value.size(); i++) {
+        if (value[i] == '\\' || value[i] == '"') {
+            out.push_back('\\');
+            out.push_back(value[i]);
+        } else if (value[i] == '\n') {
+            out.append("\\n");
+        } else {
+            out.push_back(value[i]);
+        }
+    }
+    return out;
+}
+
+void header(std::string &out, const char *name, const char *help, const char *type) {
+    out.append("# HELP ").append(name).append(" ").append(help).append("\n");
+    out.append("# TYPE ").append(name).append(" ").append(type).append("\n");
+}
+
+/**
+ * @brief split "host:port"
+ * @return false if the target is a file path
+ */
+bool parseAddress(const std::string &target, std::string &host, uint16_t &port) {
+    size_t colon = target.rfind(':');
+    if (colon == std::string::npos || colon + 1 == target.size() ||
+        target.find_first_of("/\\") != std::string::npos) {
+        return false;
+    }
+    unsigned long value = 0;
+    for (size_t i = colon + 1; i < target.size(); i++) {
+        if (target[i] < '0' || target[i] > '9') {
+            return false;
+        }
+        value = value * 10 + (target[i] - '0');
+        if (value > 0xFFFF) {
+            return false;
+        }
+    }
+    host = target.substr(0, colon);
+    port = (uint16_t)value;
+    return true;
+}
+
+}//namespace
+
+
+MetricsExporter::MetricsExporter()
+    : m_driver(NULL)
+    , m_interval(DEFAULT_INTERVAL)
+    , m_socket(NULL) {
+}
+
+
+MetricsExporter::~MetricsExporter() {
+    stop();
+}
+
+
+bool MetricsExporter::start(DriverInterface *driver, const std::string &target, const std::string &label,
+                            uint32_t interval) {
+    stop();
+    if (!driver || target.empty()) {
+        return false;
+    }
+    m_target = target;
+    m_label = label;
+    m_interval = interval > 0 ? interval : (uint32_t)DEFAULT_INTERVAL;
+
+    std::string host;
+    uint16_t port = 0;
+    if (parseAddress(target, host, port)) {
+        //never on every interface unless asked for
+        if (host.empty() || host == "localhost") {
+            host = "127.0.0.1";
+        }
+        if (inet_addr(host.c_str()) == INADDR_NONE) {
+            LOGW("Invalid metrics address %s", target.c_str());
+            return false;
+        }
+        m_socket = new CPassiveSocket(CSimpleSocket::SocketTypeTcp);
+        if (!m_socket->Initialize() || !m_socket->Listen(host.c_str(), port)) {
+            LOGW("Failed to export metrics on %s: %s", target.c_str(), m_socket->DescribeError());
+            m_socket->Close();
+            delete m_socket;
+            m_socket = NULL;
+            return false;
+        }
+    }
+
+    m_driver = driver;
+    m_stop.reset();
+    thread_attr attr("lidar-metrics");
+    if (m_socket) {
+        m_thread = CLASS_THREAD_ATTR(MetricsExporter, socketLoop, attr);
+    } else {
+        m_thread = CLASS_THREAD_ATTR(MetricsExporter, fileLoop, attr);
+    }
+    if (m_thread.getHandle() == 0) {
+        stop();
+        return false;
+    }
+    return true;
+}
+
+
+void MetricsExporter::stop() {
+    m_stop.requestStop();
+    m_thread.join();
+    if (m_socket) {
+        m_socket->Close();
+        delete m_socket;
+        m_socket = NULL;
+    }
+    m_driver = NULL;
+}
+
+
+int MetricsExporter::fileLoop() {
+    bool failed = !writeFile();
+    if (failed) {
+        LOGW("Failed to export metrics to %s", m_target.c_str());
+    }
+    while (m_stop.sleep(m_interval)) {
+        //reported once, not every interval
+        bool ok = writeFile();
+        if (!ok && !failed) {
+            LOGW("Failed to export metrics to %s", m_target.c_str());
+        }
+        failed = !ok;
+    }
+    writeFile();
+    return RESULT_OK;
+}
+
+
+bool MetricsExporter::writeFile() {
+    m_text.clear();
+    format(m_driver->getMetrics(), m_label, m_text);
+
+    std::string tmp = m_target + ".tmp";
+    FILE *fp = fopen(tmp.c_str(), "wb");
+    if (!fp) {
+        return false;
+    }
+    bool ok = fwrite(m_text.data(), 1, m_text.size(), fp) == m_text.size();
+    ok = fclose(fp) == 0 && ok;
+#if defined(_WIN32)
+    remove(m_target.c_str());
+#endif
+    return ok && rename(tmp.c_str(), m_target.c_str()) == 0;
+}
+
+
+int MetricsExporter::socketLoop() {
+    while (!m_stop.stopRequested()) {
+        int wait = m_stop.waitReadable((int)m_socket->GetSocketDescriptor(), 0xFFFFFFFF);
+        if (wait == StopToken::WAIT_STOPPED || wait == StopToken::WAIT_FAILED) {
+            break;
+        }
+        if (wait != StopToken::WAIT_READABLE) {
+            continue;
+        }
+        CActiveSocket *client = m_socket->Accept();
+        if (client) {
+            serve(client);
+            client->Close();
+            delete client;
+        }
+    }
+    return RESULT_OK;
+}
+
+
+void MetricsExporter::serve(CActiveSocket *client) {
+    //whatever is asked, the answer is the metrics
+    uint8_t request[1024];
+    if (m_stop.waitReadable((int)client->GetSocketDescriptor(), REQUEST_TIMEOUT) == StopToken::WAIT_READABLE) {
+        client->Receive(sizeof(request), request);
+    }
+
+    std::string body;
+    format(m_driver->getMetrics(), m_label, body);
+    char head[128];
+    snprintf(head, sizeof(head), "HTTP/1.0 200 OK\r\n"
+             "Content-Type: text/plain; version=0.0.4\r\n"
+             "Content-Length: %u\r\n\r\n", (unsigned int)body.size());
+    m_text.assign(head);
+    m_text.append(body);
+
+    size_t sent = 0;
+    while (sent < m_text.size()) {
+        int32_t len = client->Send(reinterpret_cast<const uint8_t *>(m_text.data()) + sent, m_text.size() - sent);
+        if (len <= 0) {
+            break;
+        }
+        sent += len;
+    }
+}
+
+
+void MetricsExporter::format(const LidarMetrics &metrics, const std::string &label, std::string &out) {
+    char value[64];
+    std::string lidar = "{lidar=\"" + escape(label) + "\"";
+    std::string labels = lidar + "}";
+
+    for (size_t i = 0; i < sizeof(counters) / sizeof(counters[0]); i++) {
+        const CounterInfo &c = counters[i];
+        uint64_t v = *reinterpret_cast<const uint64_t *>(reinterpret_cast<const uint8_t *>(&metrics) + c.offset);
+        header(out, c.name, c.help, "counter");
+        snprintf(value, sizeof(value), " %" PRIu64 "\n", v);
+        out.append(c.name).append(labels).append(value);
+    }
+
+    header(out, "lidar_packet_rate", "Packets per second over the last second.", "gauge");
+    snprintf(value, sizeof(value), " %.1f\n", metrics.packet_rate);
+    out.append("lidar_packet_rate").append(labels).append(value);
+    header(out, "lidar_byte_rate", "Bytes per second over the last second.", "gauge");
+    snprintf(value, sizeof(value), " %.1f\n", metrics.byte_rate);
+    out.append("lidar_byte_rate").append(labels).append(value);
+
+    header(out, "lidar_decode_seconds", "Time spent decoding a packet or a serial read chunk.", "histogram");
+    uint64_t cumulative = 0;
+    for (int i = 0; i < LIDAR_METRICS_BUCKETS; i++) {
+        cumulative += metrics.decode_ns_buckets[i];
+        if (i + 1 < LIDAR_METRICS_BUCKETS) {
+            snprintf(value, sizeof(value), ",le=\"%g\"} %" PRIu64 "\n",
+                     (double)(1024ULL << i) * 1e-9, cumulative);
+        } else {
+            snprintf(value, sizeof(value), ",le=\"+Inf\"} %" PRIu64 "\n", cumulative);
+        }
+        out.append("lidar_decode_seconds_bucket").append(lidar).append(value);
+    }
+    snprintf(value, sizeof(value), " %.9f\n", metrics.decode_ns_sum * 1e-9);
+    out.append("lidar_decode_seconds_sum").append(labels).append(value);
+    snprintf(value, sizeof(value), " %" PRIu64 "\n", metrics.decode_count);
+    out.append("lidar_decode_seconds_count").append(labels).append(value);
+
+    header(out, "lidar_decode_seconds_max", "Longest decode.", "gauge");
+    snprintf(value, sizeof(value), " %.9f\n", metrics.decode_ns_max * 1e-9);
+    out.append("lidar_decode_seconds_max").append(labels).append(value);
+
+    for (size_t i = 0; i < sizeof(gauges) / sizeof(gauges[0]); i++) {
+        const GaugeInfo &g = gauges[i];
+        double v = *reinterpret_cast<const double *>(reinterpret_cast<const uint8_t *>(&metrics) + g.offset);
+        header(out, g.name, g.help, "gauge");
+        snprintf(value, sizeof(value), " %.6g\n", v);
+        out.append(g.name).append(labels).append(value);
+    }
+    header(out, "lidar_scan_period_seconds", "Measured revolution period, filtered.", "gauge");
+    snprintf(value, sizeof(value), " %.9f\n", metrics.scan_period_ns * 1e-9);
+    out.append("lidar_scan_period_seconds").append(labels).append(value);
+    header(out, "lidar_scan_period_jitter_seconds", "Mean deviation of the revolution periods.", "gauge");
+    snprintf(value, sizeof(value), " %.9f\n", metrics.scan_jitter_ns * 1e-9);
+    out.append("lidar_scan_period_jitter_seconds").append(labels).append(value);
+    header(out, "lidar_scan_points", "Points of the last revolution.", "gauge");
+    snprintf(value, sizeof(value), " %" PRIu64 "\n", metrics.scan_points);
+    out.append("lidar_scan_points").append(labels).append(value);
+}
+
+}//namespace lidar
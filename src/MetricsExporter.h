@@ -0,0 +1,82 @@
+#ifndef METRICS_EXPORTER_H
+#define METRICS_EXPORTER_H
+#include <core/base/thread.h>
+#include <core/base/stop_token.h>
+#include <core/common/DriverInterface.h>
+#include <core/network/PassiveSocket.h>
+#include <string>
+
+namespace lidar {
+
+using namespace core::base;
+using namespace core::common;
+using namespace core::network;
+
+/**
+ * @brief Periodic export of the driver metrics in Prometheus text format \n
+ * The target is either a file, rewritten every interval through a rename
+ * so a textfile collector never reads half of it, or "host:port", where
+ * every HTTP request gets the current metrics. An empty host listens on
+ * 127.0.0.1 only.
+ */
+class MetricsExporter {
+public:
+    enum {
+        DEFAULT_INTERVAL = 1000,      /**< File export period(ms). */
+        REQUEST_TIMEOUT = 100,        /**< Wait for the request of a connection(ms). */
+    };
+
+    MetricsExporter();
+    ~MetricsExporter();
+
+    /**
+     * @brief start exporting
+     * @param driver    driver whose metrics are exported, it must outlive ::stop
+     * @param target    file path or "host:port"
+     * @param label     value of the lidar="" label
+     * @param interval  file export period(ms)
+     * @return true if the exporter thread is running
+     */
+    bool start(DriverInterface *driver, const std::string &target, const std::string &label,
+               uint32_t interval = DEFAULT_INTERVAL);
+
+    /**
+     * @brief stop exporting, a file gets the final values
+     */
+    void stop();
+
+    bool isRunning() const {
+        return m_driver != NULL;
+    }
+
+    /**
+     * @brief format metrics in Prometheus text format
+     * @param metrics   metrics
+     * @param label     value of the lidar="" label
+     * @param[out] out  text, appended
+     */
+    static void format(const LidarMetrics &metrics, const std::string &label, std::string &out);
+
+private:
+    MetricsExporter(const MetricsExporter &);
+    MetricsExporter &operator=(const MetricsExporter &);
+
+    int fileLoop();
+    int socketLoop();
+    bool writeFile();
+    void serve(CActiveSocket *client);
+
+private:
+    DriverInterface *m_driver;
+    std::string m_target;
+    std::string m_label;
+    uint32_t m_interval;
+    CPassiveSocket *m_socket;   ///< listening socket, NULL for a file target
+    Thread m_thread;
+    StopToken m_stop;
+    std::string m_text;         ///< exporter thread only
+};
+
+}//namespace lidar
+
+#endif // METRICS_EXPORTER_H
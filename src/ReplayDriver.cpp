@@ -0,0 +1,277 @@
+#include "ReplayDriver.h"
+#include <core/serial/common.h>
+#include <core/common/lidar_help.h>
+
+namespace lidar {
+
+ReplayDriver::ReplayDriver(float speed, bool loop)
+    : m_speed(speed < 0 ? 0 : speed)
+    , m_loop(loop)
+    , m_source(0)
+    , m_frequency(0)
+    , m_sampleRate(0) {
+    m_decoder.setMetrics(&m_Metrics);
+    //父类成员变量
+    allocScanBuffer();
+}
+
+
+ReplayDriver::~ReplayDriver() {
+    disconnect();
+    m_State.cancel();
+    if (m_ScanNodeBuf) {
+        delete[] m_ScanNodeBuf;
+        m_ScanNodeBuf = nullptr;
+    }
+}
+
+/*--------------------------------------------------------------------------------------------------------------
+                                                     本类的私有函数
+---------------------------------------------------------------------------------------------------------------*/
+
+void ReplayDriver::disableDataGrabbing() {
+    m_StopToken.requestStop();
+    m_ConsumedEvent.set();
+    m_DataEvent.set();
+    m_Thread.join();
+}
+
+
+bool ReplayDriver::pace(uint64_t recv_ns, uint64_t first_ns, uint64_t start_ns) {
+    if (m_speed <= 0 || recv_ns <= first_ns) {
+        return getIsScanning();
+    }
+    uint64_t due = start_ns + static_cast<uint64_t>((recv_ns - first_ns) / m_speed);
+    uint64_t now = getns();
+    //a late frame is replayed at once to catch up
+    if (due > now + 1000000) {
+        if (!m_StopToken.sleep((due - now) / 1000000)) {
+            return false;
+        }
+    }
+    return getIsScanning();
+}
+
+
+int ReplayDriver::replayLoop() {
+    node_info local_buf[DATABLOCK_COUNT * DATA_COUNT];
+    ScanAssembler assembler(getScanCapacity(), getScanSpacing(), getFieldOfView());
+    capture_frame frame;
+    size_t count = 0;
+    uint64_t first_ns = 0;
+    uint64_t start_ns = 0;
+
+    memset(&local_buf, 0, sizeof(local_buf));
+    allocScanBuffer();
+    traceReset();
+    while (getIsScanning() && !m_StopToken.stopRequested()) {
+        if (!m_reader.next(frame)) {
+            if (!m_loop) {
+                break;
+            }
+            //the next pass starts a new timeline
+            m_reader.rewind();
+            m_decoder.reset();
+            assembler.reset();
+            traceReset();
+            m_Clock.reset();
+            first_ns = 0;
+            continue;
+        }
+        if (m_source == 0) {
+            m_source = frame.src_addr;
+        }
+        if (frame.src_addr != m_source) {
+            m_Metrics.foreign_packets.add();
+            continue;
+        }
+        if (first_ns == 0) {
+            first_ns = frame.recv_ns;
+            start_ns = getns();
+        }
+        if (!pace(frame.recv_ns, first_ns, start_ns)) {
+            break;
+        }
+
+        uint64_t start = getns();
+        m_Metrics.onPacket(frame.length, start);
+        result_t ans = m_decoder.decode(frame.payload, frame.length, local_buf, count);
+        uint64_t decoded = getns();
+        m_Metrics.decode.record(decoded - start);
+        if (!IS_OK(ans)) {
+            m_Liveness.update(getms());
+            assembler.markSync();
+            continue;
+        }
+        //only a valid frame proves the link alive
+        m_Liveness.onPacket(getms());
+        m_Liveness.update(getms());
+        markStartup(m_StartupTiming.first_packet);
+        //the capture stamps are another clock, the frame is received when it is read
+        tracePacket(start, decoded);
+        if (count) {
+            //the recorded receive times give the stamps of the live run
+            m_Clock.sample(local_buf[count - 1].stamp, frame.recv_ns);
+        }
+        assembler.push(local_buf, count, [this](const node_info *scan, size_t scan_count, const ScanStats &stats) {
+            publishScan(scan, scan_count, stats);
+            markStartup(m_StartupTiming.first_scan);
+            //as fast as possible still hands every revolution to the consumer
+            if (m_speed <= 0) {
+                m_ConsumedEvent.wait(DEFAULT_TIMEOUT);
+            }
+        });
+    }
+
+    //the scan ends with the capture
+    if (m_State.transition(DriverStateMachine::mask(DriverStateScanning), DriverStateConfiguring)) {
+        LOGD("Replay of %s finished", m_path.c_str());
+        m_Liveness.stop();
+    }
+    return RESULT_OK;
+}
+
+/*--------------------------------------------------------------------------------------------------------------
+                                        从DriverInterface虚基类继承的纯虚函数
+---------------------------------------------------------------------------------------------------------------*/
+
+result_t ReplayDriver::connect(const char *port_path, uint32_t baudrate) {
+    UNUSED(baudrate);
+    if (!m_State.transition(DriverStateMachine::mask(DriverStateDisconnected) |
+                            DriverStateMachine::mask(DriverStateConfiguring), DriverStateConnecting)) {
+        LOGW("Cannot open a capture while replaying");
+        return RESULT_FAIL;
+    }
+    memset(&m_StartupTiming, 0, sizeof(m_StartupTiming));
+    m_StartupTiming.connect_start = getms();
+    m_path = port_path;
+    if (!m_reader.open(port_path)) {
+        LOGE("Failed to open capture %s", port_path);
+        setDriverError(NotOpenError);
+        m_State.transition(DriverStateDisconnected);
+        return RESULT_FAIL;
+    }
+    m_State.transition(DriverStateConfiguring);
+    m_StartupTiming.connected = getms();
+    LOGD("Replaying %s at %gx", port_path, m_speed);
+    return RESULT_OK;
+}
+
+
+void ReplayDriver::disconnect() {
+    m_State.transition(DriverStateDisconnected);
+    disableDataGrabbing();
+    m_reader.close();
+}
+
+
+result_t ReplayDriver::grabScanData(node_info *nodebuffer, size_t &count, uint32_t timeout) {
+    switch (m_DataEvent.wait(timeout)) {
+
+        case Event::EVENT_TIMEOUT: {
+            count = 0;
+            return RESULT_TIMEOUT;
+        }
+
+        case Event::EVENT_OK: {
+            if (m_ScanNodeCount == 0) {
+                return RESULT_FAIL;
+            }
+
+            ScopedLocker l(m_Lock);
+            size_t size_to_copy = min(count, m_ScanNodeCount);
+            memcpy(nodebuffer, m_ScanNodeBuf, size_to_copy * sizeof(node_info));
+            count = size_to_copy;
+            m_ScanNodeCount = 0;
+            traceGrab();
+            m_ConsumedEvent.set();
+            return RESULT_OK;
+        }
+
+        default:
+            count = 0;
+            return RESULT_FAIL;
+    }
+}
+
+
+result_t ReplayDriver::startScan(uint32_t timeout) {
+    UNUSED(timeout);
+    m_StartupTiming.scan_start = getms();
+    if (!m_State.transition(DriverStateMachine::mask(DriverStateConfiguring), DriverStateScanning)) {
+        LOGE("No capture is open or it is already replaying");
+        return RESULT_FAIL;
+    }
+    //a finished replay thread is joined before the next one
+    m_Thread.join();
+    m_reader.rewind();
+    m_decoder.reset();
+    m_source = 0;
+    m_StopToken.reset();
+    m_ConsumedEvent.set(false);
+    m_Liveness.start(getms());
+
+    thread_attr attr = ingestAttr("lidar-replay");
+    m_Thread = CLASS_THREAD_ATTR(ReplayDriver, replayLoop, attr);
+    if (m_Thread.getHandle() == 0) {
+        m_State.transition(DriverStateConfiguring);
+        return RESULT_FAIL;
+    }
+    m_StartupTiming.scan_started = getms();
+    return RESULT_OK;
+}
+
+
+result_t ReplayDriver::stopScan(uint32_t timeout) {
+    UNUSED(timeout);
+    if (!m_State.transition(DriverStateMachine::mask(DriverStateScanning), DriverStateStopping)) {
+        //finished on its own
+        m_Thread.join();
+        return RESULT_OK;
+    }
+    disableDataGrabbing();
+    m_Liveness.stop();
+    m_State.transition(DriverStateMachine::mask(DriverStateStopping), DriverStateConfiguring);
+    return RESULT_OK;
+}
+
+
+result_t ReplayDriver::getScanFrequency(scan_frequency &frequency, uint32_t timeout) {
+    UNUSED(timeout);
+    frequency.frequency = m_frequency;
+    return RESULT_OK;
+}
+
+
+result_t ReplayDriver::setScanFrequency(scan_frequency &frequency, uint32_t timeout) {
+    UNUSED(timeout);
+    m_frequency = frequency.frequency;
+    return RESULT_OK;
+}
+
+
+result_t ReplayDriver::getSamplingRate(sampling_rate &rate, uint32_t timeout) {
+    UNUSED(timeout);
+    rate.rate = m_sampleRate;
+    return RESULT_OK;
+}
+
+
+result_t ReplayDriver::setSamplingRate(sampling_rate &rate, uint32_t timeout) {
+    UNUSED(timeout);
+    m_sampleRate = rate.rate;
+    return RESULT_OK;
+}
+
+
+const char *ReplayDriver::DescribeError(bool isTCP) {
+    UNUSED(isTCP);
+    return m_reader.isOpen() ? "No error" : "Capture file is not open";
+}
+
+
+map<string, string> ReplayDriver::lidarPortList() {
+    return map<string, string>();
+}
+
+}//namespace lidar
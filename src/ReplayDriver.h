@@ -0,0 +1,137 @@
+#ifndef REPLAY_DRIVER_H
+#define REPLAY_DRIVER_H
+#include <stdlib.h>
+#include <core/common/DriverInterface.h>
+#include "FrameDecoder.h"
+#include "record/CaptureReader.h"
+
+namespace lidar {
+
+using namespace std;
+using namespace core::base;
+using namespace core::common;
+
+/**
+ * @brief Driver replaying a capture recorded with LidarPropRecordPath \n
+ * The datagrams go through the same FrameDecoder and ScanAssembler as live
+ * data, paced by their receive times divided by the speed factor, or as
+ * fast as ::grabScanData consumes them when the speed is 0.
+ */
+class ReplayDriver : public DriverInterface {
+
+private:
+    string m_path;                    ///< capture file
+    CaptureReader m_reader;
+    FrameDecoder m_decoder;
+    float m_speed;                    ///< 1 real time, N N times faster, 0 as fast as possible
+    bool m_loop;                      ///< start over at the end of the capture
+    uint32_t m_source;                ///< replayed lidar address, network byte order, 0 before the first frame
+    Event m_ConsumedEvent;            ///< a scan was taken by grabScanData, used when the speed is 0
+    uint32_t m_frequency;             ///< last value given to ::setScanFrequency
+    uint8_t m_sampleRate;             ///< last value given to ::setSamplingRate
+
+public:
+    /**
+     * @par Constructor
+     * @param speed  replay speed factor, 0 for as fast as possible
+     * @param loop   start over at the end of the capture
+     */
+    explicit ReplayDriver(float speed = 1.0f, bool loop = false);
+
+    /**
+     * @par Destructor
+     *
+     */
+    ~ReplayDriver();
+
+private:
+    /**
+     * @brief Replay thread \n
+     */
+    int replayLoop();
+
+    /**
+     * @brief Wait until a capture time is due \n
+     * @return false if the replay was stopped
+     */
+    bool pace(uint64_t recv_ns, uint64_t first_ns, uint64_t start_ns);
+
+    /**
+     * @brief Stop the replay thread.
+     */
+    void disableDataGrabbing();
+
+public:
+    /**
+     * @brief Open the capture file \n
+     * @param[in] port_path    capture file
+     * @param[in] baudrate     unused
+     * @return connection status
+     * @retval RESULT_OK       success
+     * @retval RESULT_FAILE    failed
+     */
+    virtual result_t connect(const char *port_path, uint32_t baudrate);
+
+    /**
+     * @brief Close the capture file
+     */
+    virtual void disconnect();
+
+    /**
+     * @brief Get a circle of laser data \n
+     * @param[in] nodebuffer Laser data
+     * @param[in] count      one circle of laser points
+     * @param[in] timeout    timeout
+     * @return return status
+     * @retval RESULT_OK       success
+     * @retval RESULT_FAILE    failed
+     * @retval RESULT_TIMEOUT  no revolution within the timeout
+     */
+    virtual result_t grabScanData(node_info *nodebuffer, size_t &count, uint32_t timeout = DEFAULT_TIMEOUT);
+
+    /**
+     * @brief Start replaying from the beginning of the capture \n
+     * @return result status
+     */
+    virtual result_t startScan(uint32_t timeout = DEFAULT_TIMEOUT);
+
+    /**
+     * @brief Stop replaying \n
+     * @return result status
+     */
+    virtual result_t stopScan(uint32_t timeout = DEFAULT_TIMEOUT);
+
+    /**
+     * @brief Get the scan frequency given to ::setScanFrequency \n
+     */
+    virtual result_t getScanFrequency(scan_frequency &frequency, uint32_t timeout = DEFAULT_TIMEOUT);
+
+    /**
+     * @brief A capture cannot be changed, the value is only kept \n
+     */
+    virtual result_t setScanFrequency(scan_frequency &frequency, uint32_t timeout = DEFAULT_TIMEOUT);
+
+    /**
+     * @brief Get the sampling rate given to ::setSamplingRate \n
+     */
+    virtual result_t getSamplingRate(sampling_rate &rate, uint32_t timeout = DEFAULT_TIMEOUT);
+
+    /**
+     * @brief A capture cannot be changed, the value is only kept \n
+     */
+    virtual result_t setSamplingRate(sampling_rate &rate, uint32_t timeout = DEFAULT_TIMEOUT);
+
+    /**
+     * @brief Returns a human-readable description of the last error
+     */
+    virtual const char *DescribeError(bool isTCP = true);
+
+    /**
+     * @brief A capture has no online lidars
+     */
+    virtual map<string, string> lidarPortList();
+};
+
+}// namespace lidar
+
+#endif // REPLAY_DRIVER_H
@@ -0,0 +1,536 @@
+#include "SerialDriver.h"
+#include <core/serial/common.h>
+#include <core/tools/cJSON.h>
+#include <core/common/lidar_help.h>
+#include <algorithm>
+
+namespace lidar {
+
+SerialDriver::SerialDriver()
+    : m_baudrate(0)
+    , m_ring(RING_SIZE)
+    , m_parser(m_decoder)
+    , m_overflows(0) {
+    m_serial = new Serial();
+    m_portArrived = false;
+    m_readStamp = 0;
+    m_monitor.setCallback(&SerialDriver::onPortEvent, this);
+    memset(&m_lidarConfig, -1, sizeof(m_lidarConfig));
+    m_decoder.setMetrics(&m_Metrics);
+
+    //父类成员变量
+    allocScanBuffer();
+}
+
+
+SerialDriver::~SerialDriver() {
+    disconnect();
+    m_monitor.stop();
+    m_State.cancel();
+    ScopedLocker cmd_lock(m_CmdLock);
+    if (m_serial) {
+        delete m_serial;
+        m_serial = NULL;
+    }
+    if (m_ScanNodeBuf) {
+        delete[] m_ScanNodeBuf;
+        m_ScanNodeBuf = nullptr;
+    }
+}
+
+/*--------------------------------------------------------------------------------------------------------------
+                                                     本类的私有函数
+---------------------------------------------------------------------------------------------------------------*/
+
+bool SerialDriver::sendMessage(const char *message) {
+    ScopedLocker lock(m_CmdLock);
+    size_t len = strlen(message);
+    if (!m_serial || !m_serial->isOpen()) {
+        return false;
+    }
+    return m_serial->writeData(reinterpret_cast<const uint8_t *>(message), len) == len;
+}
+
+
+bool SerialDriver::readAnswer(char *buf, size_t size, uint32_t timeout) {
+    ScopedLocker lock(m_CmdLock);
+    uint32_t start = getms();
+    size_t len = 0;
+    int depth = 0;
+
+    //one byte at a time, the data stream after the answer stays in the port
+    while (getms() - start < timeout && len + 1 < size) {
+        uint8_t c = 0;
+        if (m_serial->readData(&c, 1) != 1) {
+            continue;
+        }
+        if (depth == 0 && c != '{') {
+            continue;
+        }
+        depth += (c == '{') - (c == '}');
+        buf[len++] = c;
+        if (depth == 0) {
+            buf[len] = 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+
+result_t SerialDriver::configMessage(char op, const char *descriptor, int &value, uint32_t timeout) {
+    char name[64] = {0};
+    char transbuf[256] = {0};
+    char recvbuf[256] = {0};
+    cJSON *root = NULL;
+    cJSON *item = NULL;
+    strncpy(name, descriptor, sizeof(name) - 1);
+    valLastName(name);
+    if(op == 'w' || op == 'W') {
+        sprintf(transbuf, "{\"%s\":%d}", name, value);
+    }else if(op == 'r' || op == 'R') {
+        sprintf(transbuf, "{\"Read\":\"%s\"}", name);
+    }else {
+        LOGW("op error!");
+        return RESULT_FAIL;
+    }
+
+    //answers cannot be told apart from the data stream while scanning
+    if (getIsScanning()) {
+        return (op == 'w' || op == 'W') && sendMessage(transbuf) ? RESULT_OK : RESULT_FAIL;
+    }
+    if (!sendMessage(transbuf)) {
+        setDriverError(NotOpenError);
+        return RESULT_FAIL;
+    }
+    if (!readAnswer(recvbuf, sizeof(recvbuf), timeout)) {
+        m_Liveness.onControl(false, getms());
+        return RESULT_FAIL;
+    }
+    m_Liveness.onControl(true, getms());
+
+    root = cJSON_Parse(recvbuf);
+    if (!root){
+        return RESULT_FAIL;
+    }
+    item = cJSON_GetObjectItem(root, name);
+    if(!cJSON_IsNumber(item)) {
+        cJSON_Delete(root);
+        return RESULT_FAIL;
+    }
+    value = item->valueint;
+    cJSON_Delete(root);
+    return RESULT_OK;
+}
+
+
+result_t SerialDriver::startMeasure(uint32_t timeout) {
+    m_lidarConfig.scanType = 0;
+    if(!IS_OK(configMessage('w', valName(m_lidarConfig.scanType), m_lidarConfig.scanType, timeout))) {
+        return RESULT_FAIL;
+    }
+    return RESULT_OK;
+}
+
+
+result_t SerialDriver::stopMeasure(uint32_t timeout) {
+    char name[64] = {0};
+    char transbuf[256] = {0};
+    strncpy(name, valName(m_lidarConfig.scanType), sizeof(name) - 1);
+    valLastName(name);
+    snprintf(transbuf, sizeof(transbuf), "{\"%s\":%d}", name, -1);
+    m_lidarConfig.scanType = -1;
+    if (!sendMessage(transbuf)) {
+        return RESULT_FAIL;
+    }
+    //the answer is somewhere in the tail of the data stream, it is dropped with it
+    delay(std::min<uint32_t>(timeout, READ_TIMEOUT));
+    ScopedLocker lock(m_CmdLock);
+    m_serial->flushInput();
+    return RESULT_OK;
+}
+
+
+void SerialDriver::onPortEvent(PortMonitor::PortEvent event, const PortInfo &port, void *user) {
+    SerialDriver *driver = static_cast<SerialDriver *>(user);
+    if (event == PortMonitor::PortRemoved) {
+        if (port.port == driver->m_port) {
+            LOGD("Serial port %s unplugged", port.port.c_str());
+        }
+        return;
+    }
+    //m_port may be a udev symlink, any new port is worth a try
+    driver->m_portArrived = true;
+    driver->m_PortEvent.set();
+}
+
+
+bool SerialDriver::reopenPort() {
+    ScopedLocker lock(m_CmdLock);
+    if (m_serial->isOpen()) {
+        return true;
+    }
+    if (!m_serial->open()) {
+        return false;
+    }
+    m_serial->setLowLatency();
+    return true;
+}
+
+
+void SerialDriver::disableDataGrabbing() {
+    //every wait of both threads ends on the stop request
+    m_StopToken.requestStop();
+    m_RingEvent.set();
+    m_PortEvent.set();
+    m_DataEvent.set();
+    m_ReadThread.join();
+    m_Thread.join();
+}
+
+
+int SerialDriver::readLoop() {
+    uint32_t last_data_time = getms();
+    uint32_t retry_time = 0;
+    uint32_t backoff = DEFAULT_RECONNECT_MIN_DELAY;
+    bool receiving = false;
+
+    while (getIsScanning() && !m_StopToken.stopRequested()) {
+        if (getIsAutoReconnect() && getIsAutoconnting() &&
+            (m_portArrived.exchange(false) || getms() - retry_time >= backoff)) {
+            //an unplugged port is reopened, a power cycled lidar is asked to scan again
+            retry_time = getms();
+            backoff = std::min<uint32_t>(backoff * 2, DEFAULT_RECONNECT_MAX_DELAY);
+            if (reopenPort()) {
+                m_lidarConfig.scanType = 0;
+                configMessage('w', valName(m_lidarConfig.scanType), m_lidarConfig.scanType);
+            }
+        }
+
+        size_t space = 0;
+        uint8_t *region = m_ring.writeRegion(space);
+        if (space == 0) {
+            //the scanning thread is behind, the bytes wait in the port meanwhile
+            m_overflows++;
+            m_RingEvent.set();
+            delay(1);
+            continue;
+        }
+
+        //the scanning thread is woken as soon as the bytes land
+        size_t len = 0;
+        int ans = m_serial->readStream(region, space, READ_TIMEOUT, &len, m_StopToken.fd());
+        if (ans == -3) {
+            break;
+        }
+        if (ans == 0) {
+            uint64_t now = getns();
+            m_readStamp.store(now, std::memory_order_relaxed);
+            m_ring.commit(len);
+            m_RingEvent.set();
+            m_Metrics.onBytes(len, now);
+            last_data_time = getms();
+            receiving = true;
+            if (m_State.transition(DriverStateMachine::mask(DriverStateReconnecting), DriverStateScanning)) {
+                LOGD("Data stream resumed");
+                setDriverError(NoError);
+                backoff = DEFAULT_RECONNECT_MIN_DELAY;
+            }
+            continue;
+        }
+        if (ans == -2) {
+            if (m_serial->isOpen()) {
+                LOGE("Serial port %s lost", m_port.c_str());
+                ScopedLocker lock(m_CmdLock);
+                m_serial->closePort();
+            }
+            setDriverError(NotOpenError);
+            if (m_State.transition(DriverStateMachine::mask(DriverStateScanning), DriverStateReconnecting)) {
+                LOGD("Reconnecting...");
+                retry_time = getms();
+                backoff = DEFAULT_RECONNECT_MIN_DELAY;
+            }
+            //woken by the port monitor when a device is plugged in
+            m_PortEvent.wait(READ_TIMEOUT);
+            continue;
+        }
+
+        //the motor spin-up is given the full timeout
+        uint32_t silence = receiving ? DEFAULT_HEART_BEAT : DEFAULT_TIMEOUT * (DEFAULT_TIMEOUT_COUNT + 1);
+        if (getms() - last_data_time > silence &&
+            m_State.transition(DriverStateMachine::mask(DriverStateScanning), DriverStateReconnecting)) {
+            setDriverError(TimeoutError);
+            LOGD("Reconnecting...");
+            retry_time = getms();
+            backoff = DEFAULT_RECONNECT_MIN_DELAY;
+        }
+    }
+    return RESULT_OK;
+}
+
+
+int SerialDriver::cacheScanData() {
+    ScanAssembler assembler(getScanCapacity(), getScanSpacing(), getFieldOfView());
+    size_t size = 0;
+
+    allocScanBuffer();
+    traceReset();
+    while (getIsScanning() && !m_StopToken.stopRequested()) {
+        m_RingEvent.wait(READ_TIMEOUT);
+        for (const uint8_t *data = m_ring.readRegion(size); size > 0; data = m_ring.readRegion(size)) {
+            uint64_t start = getns();
+            //no kernel stamp on a tty, the bytes arrived at the latest by the last read
+            uint64_t received = m_readStamp.load(std::memory_order_relaxed);
+            uint64_t resyncs = m_parser.resyncs();
+            m_parser.feed(data, size, [&](result_t ans, const node_info *nodes, size_t count) {
+                m_Metrics.onPacket(0, start);//the bytes are counted by readLoop
+                if (!IS_OK(ans)) {
+                    assembler.markSync();
+                    return;
+                }
+                m_Liveness.onPacket(getms());
+                markStartup(m_StartupTiming.first_packet);
+                uint64_t now = getns();
+                tracePacket(received, now);
+                if (count && received) {
+                    //the read time moved from getns() to the host clock
+                    m_Clock.sample(nodes[count - 1].stamp, getTime() - (now - std::min(received, now)));
+                }
+                assembler.push(nodes, count, [this](const node_info *scan, size_t scan_count, const ScanStats &stats) {
+                    publishScan(scan, scan_count, stats);
+                    if (markStartup(m_StartupTiming.first_scan)) {
+                        LOGD("Time to first scan: %u ms (connect %u ms, start %u ms, first packet %u ms)",
+                             m_StartupTiming.first_scan - m_StartupTiming.connect_start,
+                             m_StartupTiming.connected - m_StartupTiming.connect_start,
+                             m_StartupTiming.scan_started - m_StartupTiming.scan_start,
+                             m_StartupTiming.first_packet - m_StartupTiming.scan_start);
+                    }
+                });
+            });
+            m_Metrics.frame_errors.add(m_parser.resyncs() - resyncs);
+            m_Metrics.decode.record(getns() - start);
+            m_ring.release(size);
+        }
+        m_Liveness.update(getms());
+    }
+    return RESULT_OK;
+}
+
+/*--------------------------------------------------------------------------------------------------------------
+                                        从DriverInterface虚基类继承的纯虚函数
+---------------------------------------------------------------------------------------------------------------*/
+
+result_t SerialDriver::connect(const char *port_path, uint32_t baudrate) {
+    if (!m_State.transition(DriverStateMachine::mask(DriverStateDisconnected) |
+                            DriverStateMachine::mask(DriverStateConfiguring), DriverStateConnecting)) {
+        LOGW("Cannot connect while scanning");
+        return RESULT_FAIL;
+    }
+    memset(&m_StartupTiming, 0, sizeof(m_StartupTiming));
+    m_StartupTiming.connect_start = getms();
+    m_port = port_path;
+    m_baudrate = baudrate;
+    memset(&m_lidarConfig, -1, sizeof(m_lidarConfig));
+
+    {
+        ScopedLocker lock(m_CmdLock);
+        Timeout timeout = Timeout::simpleTimeout(READ_TIMEOUT);
+        m_serial->closePort();
+        m_serial->setPort(m_port);
+        m_serial->setBaudrate(m_baudrate);
+        m_serial->setTimeout(timeout);
+        if (!m_serial->open()) {
+            LOGE("Failed to open serial port %s", port_path);
+            setDriverError(NotOpenError);
+            m_State.transition(DriverStateDisconnected);
+            return RESULT_FAIL;
+        }
+        if (!m_serial->setLowLatency()) {
+            LOGD("Serial port %s has no low latency mode", port_path);
+        }
+    }
+    if (!m_monitor.isRunning() && !m_monitor.start()) {
+        LOGD("No serial hotplug events, reconnecting by polling");
+    }
+    //a lidar left scanning by a previous session would bury the answers
+    stopMeasure();
+
+    m_State.transition(DriverStateConfiguring);
+    m_StartupTiming.connected = getms();
+    LOGD("Serial port %s opened at %u", port_path, baudrate);
+    return RESULT_OK;
+}
+
+
+void SerialDriver::disconnect() {
+    //an active scan ends here as well, its threads see the state change and exit
+    m_State.transition(DriverStateDisconnected);
+    disableDataGrabbing();
+    ScopedLocker lock(m_CmdLock);
+    if (m_serial) {
+        m_serial->closePort();
+    }
+}
+
+
+result_t SerialDriver::grabScanData(node_info *nodebuffer, size_t &count, uint32_t timeout) {
+    switch (m_DataEvent.wait(timeout)) {
+
+        case Event::EVENT_TIMEOUT: {
+            count = 0;
+            return RESULT_TIMEOUT;
+        }
+
+        case Event::EVENT_OK: {
+            if (m_ScanNodeCount == 0) {
+                return RESULT_FAIL;
+            }
+
+            ScopedLocker l(m_Lock);
+            size_t size_to_copy = min(count, m_ScanNodeCount);
+            memcpy(nodebuffer, m_ScanNodeBuf, size_to_copy * sizeof(node_info));
+            count = size_to_copy;
+            m_ScanNodeCount = 0;
+            traceGrab();
+            return RESULT_OK;
+        }
+
+        default:
+            count = 0;
+            return RESULT_FAIL;
+    }
+}
+
+
+result_t SerialDriver::startScan(uint32_t timeout) {
+    if(getIsScanning()){
+        LOGD("The lidar is scanning");
+        return RESULT_OK;
+    }
+    if (!m_State.in(DriverStateMachine::mask(DriverStateConfiguring))) {
+        LOGE("The lidar is not connected");
+        return RESULT_FAIL;
+    }
+    m_StartupTiming.scan_start = getms();
+    m_decoder.reset();
+    m_parser.reset();
+    m_ring.reset();
+
+    //the answer is read before the data stream owns the line
+    if (!IS_OK(startMeasure(timeout))) {
+        return RESULT_FAIL;
+    }
+    m_Liveness.start(getms());
+    if (!m_State.transition(DriverStateMachine::mask(DriverStateConfiguring), DriverStateScanning)) {
+        stopMeasure();
+        return RESULT_FAIL;
+    }
+    m_RingEvent.set(false);
+    m_StopToken.reset();
+    thread_attr read_attr = ingestAttr("lidar-serial-rx");
+    thread_attr scan_attr = ingestAttr("lidar-ingest");
+    m_ReadThread = CLASS_THREAD_ATTR(SerialDriver, readLoop, read_attr);
+    m_Thread = CLASS_THREAD_ATTR(SerialDriver, cacheScanData, scan_attr);
+    if (m_ReadThread.getHandle() == 0 || m_Thread.getHandle() == 0) {
+        m_State.transition(DriverStateConfiguring);
+        disableDataGrabbing();
+        stopMeasure();
+        return RESULT_FAIL;
+    }
+    m_StartupTiming.scan_started = getms();
+    LOGD("The radar starts scanning");
+    return RESULT_OK;
+}
+
+
+result_t SerialDriver::stopScan(uint32_t timeout) {
+    //a reconnect in progress is abandoned by the state change, nothing to wait for
+    if (!m_State.transition(DriverStateMachine::mask(DriverStateScanning) |
+                            DriverStateMachine::mask(DriverStateReconnecting), DriverStateStopping)) {
+        LOGD("The lidar is not scanning");
+        return RESULT_OK;
+    }
+    disableDataGrabbing();
+    m_Liveness.stop();
+    result_t ans = stopMeasure(timeout);
+    m_State.transition(DriverStateMachine::mask(DriverStateStopping), DriverStateConfiguring);
+    if (m_overflows) {
+        LOGW("Serial receive ring overflowed %llu times", (unsigned long long)m_overflows);
+        m_overflows = 0;
+    }
+    if (!IS_OK(ans)) {
+        return RESULT_FAIL;
+    }
+    LOGD("Radar stop scanning");
+    return RESULT_OK;
+}
+
+
+result_t SerialDriver::getScanFrequency(scan_frequency &frequency, uint32_t timeout) {
+    //the last confirmed value is used while scanning
+    if(!IS_OK(configMessage('r', valName(m_lidarConfig.motorSpeed), m_lidarConfig.motorSpeed, timeout)) &&
+        m_lidarConfig.motorSpeed < 0) {
+        return RESULT_FAIL;
+    }
+    frequency.frequency = m_lidarConfig.motorSpeed;
+    return RESULT_OK;
+}
+
+
+result_t SerialDriver::setScanFrequency(scan_frequency &frequency, uint32_t timeout) {
+    int motorSpeed = frequency.frequency;
+    if (motorSpeed == m_lidarConfig.motorSpeed) {
+        return RESULT_OK;//already applied
+    }
+    if(!IS_OK(configMessage('w', valName(m_lidarConfig.motorSpeed), motorSpeed, timeout))) {
+        m_lidarConfig.motorSpeed = -1;
+        return RESULT_FAIL;
+    }
+    m_lidarConfig.motorSpeed = motorSpeed;
+    return RESULT_OK;
+}
+
+
+result_t SerialDriver::getSamplingRate(sampling_rate &rate, uint32_t timeout) {
+    if(!IS_OK(configMessage('r', valName(m_lidarConfig.samplerate), m_lidarConfig.samplerate, timeout)) &&
+        m_lidarConfig.samplerate < 0) {
+        return RESULT_FAIL;
+    }
+    rate.rate = m_lidarConfig.samplerate;
+    return RESULT_OK;
+}
+
+
+result_t SerialDriver::setSamplingRate(sampling_rate &rate, uint32_t timeout) {
+    int samplerate = rate.rate;
+    if (samplerate == m_lidarConfig.samplerate) {
+        return RESULT_OK;//already applied
+    }
+    if(!IS_OK(configMessage('w', valName(m_lidarConfig.samplerate), samplerate, timeout))) {
+        m_lidarConfig.samplerate = -1;
+        return RESULT_FAIL;
+    }
+    m_lidarConfig.samplerate = samplerate;
+    return RESULT_OK;
+}
+
+
+const char *SerialDriver::DescribeError(bool isTCP) {
+    UNUSED(isTCP);
+    ScopedLocker lock(m_CmdLock);
+    return m_serial != NULL ? m_serial->DescribeError() : "NO Serial";
+}
+
+
+map<string, string> SerialDriver::lidarPortList() {
+    //the monitor keeps the table current, only enumerate when it is not running
+    vector<PortInfo> lst = m_monitor.isRunning() ? m_monitor.ports() : list_ports();
+    map<string, string> ports;
+
+    for (vector<PortInfo>::const_iterator it = lst.begin(); it != lst.end(); it++) {
+        ports[(*it).port] = (*it).description;
+    }
+    return ports;
+}
+
+}//namespace lidar
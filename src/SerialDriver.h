@@ -0,0 +1,125 @@
+#ifndef SERIAL_DRIVER_H
+#define SERIAL_DRIVER_H
+#include <stdlib.h>
+#include <core/common/DriverInterface.h>
+#include <core/common/ByteRing.h>
+#include <core/serial/serial.h>
+#include <core/serial/port_monitor.h>
+#include <atomic>
+#include "FrameDecoder.h"
+#include "FrameParser.h"
+
+namespace lidar {
+
+using namespace std;
+using namespace core::base;
+using namespace core::common;
+using namespace core::serial;
+
+/**
+ * @brief Driver of serial attached lidars \n
+ * The lidar streams the same DataFrame as over UDP and takes the same JSON
+ * commands on the line. A reader thread streams the port in low latency
+ * mode (Serial::readStream) straight into a lock-free ByteRing, the
+ * scanning thread parses the ring in place with FrameParser and hands the
+ * points to the ScanAssembler shared with the UDP driver.
+ *
+ * While scanning the line belongs to the data stream: commands are still
+ * written, but their answers are skipped by the parser, so values can only
+ * be read back before ::startScan.
+ */
+class SerialDriver : public DriverInterface {
+public:
+    enum {
+        RING_SIZE = 64 * 1024,        /**< Receive ring, about 0.7s at 20K. */
+        READ_TIMEOUT = 100,           /**< Longest wait of the reader thread(ms). */
+    };
+
+private:
+    string m_port;                    ///< serial port path
+    uint32_t m_baudrate;              ///< serial baudrate
+    Serial *m_serial;
+    ByteRing m_ring;                  ///< reader thread -> scanning thread
+    Event m_RingEvent;                ///< bytes were committed to m_ring
+    Thread m_ReadThread;
+    FrameDecoder m_decoder;           ///< DataFrame sequence and stamps, shared with the UDP path
+    FrameParser m_parser;             ///< scanning thread only
+    LidarConfig m_lidarConfig;        ///< last values confirmed by the lidar, -1 if unknown
+    uint64_t m_overflows;             ///< reads skipped because m_ring was full
+    std::atomic<uint64_t> m_readStamp;///< getns() of the last read committed to m_ring
+    PortMonitor m_monitor;            ///< plug events wake the reconnect
+    Event m_PortEvent;                ///< a serial port was plugged in
+    std::atomic<bool> m_portArrived;
+
+public:
+    SerialDriver();
+
+    ~SerialDriver();
+
+/*--------------------------------------------------------------------------------------------------------------
+                                                     本类的私有函数
+---------------------------------------------------------------------------------------------------------------*/
+private:
+
+    bool sendMessage(const char *message);
+
+    bool readAnswer(char *buf, size_t size, uint32_t timeout);
+
+    result_t configMessage(char op, const char *descriptor, int &value, uint32_t timeout = DEFAULT_TIMEOUT);
+
+    result_t startMeasure(uint32_t timeout = DEFAULT_TIMEOUT);
+
+    result_t stopMeasure(uint32_t timeout = DEFAULT_TIMEOUT);
+
+    static void onPortEvent(PortMonitor::PortEvent event, const PortInfo &port, void *user);
+
+    bool reopenPort();
+
+    void disableDataGrabbing();
+
+    int readLoop();
+
+    int cacheScanData();
+
+/*--------------------------------------------------------------------------------------------------------------
+                                           从DriverInterface继承的纯虚函数
+---------------------------------------------------------------------------------------------------------------*/
+public:
+    /**
+     * @brief Open the serial port \n
+     * @param[in] port_path    serial port
+     * @param[in] baudrate     serial baudrate
+     * @return connection status
+     * @retval RESULT_OK       success
+     * @retval RESULT_FAILE    failed
+     */
+    virtual result_t connect(const char *port_path, uint32_t baudrate);
+
+    virtual void disconnect();
+
+    virtual result_t grabScanData(node_info *nodebuffer, size_t &count, uint32_t timeout = DEFAULT_TIMEOUT);
+
+    virtual result_t startScan(uint32_t timeout = DEFAULT_TIMEOUT);
+
+    virtual result_t stopScan(uint32_t timeout = DEFAULT_TIMEOUT);
+
+    virtual result_t getScanFrequency(scan_frequency &frequency, uint32_t timeout = DEFAULT_TIMEOUT);
+
+    virtual result_t setScanFrequency(scan_frequency &frequency, uint32_t timeout = DEFAULT_TIMEOUT);
+
+    virtual result_t getSamplingRate(sampling_rate &rate, uint32_t timeout = DEFAULT_TIMEOUT);
+
+    virtual result_t setSamplingRate(sampling_rate &rate, uint32_t timeout = DEFAULT_TIMEOUT);
+
+    virtual const char *DescribeError(bool isTCP = true);
+
+    /**
+     * @brief Get the serial ports of the system
+     * @return port path and hardware id
+     */
+    virtual map<string, string> lidarPortList();
+};
+
+}// namespace lidar
+
+#endif // SERIAL_DRIVER_H
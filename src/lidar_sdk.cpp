@@ -23,6 +23,7 @@
 //
 
 #include <sstream>
+#include <stdio.h>
 #include "lidar_sdk.h"
 #include "CLidar.h"
 #include "lidar_config.h"
@@ -191,6 +192,132 @@ void os_shutdown() {
     lidar::os_shutdown();
 }
 
+void setLinkStateCallback(PubLidar *lidar, LinkStateCallback callback, void *user) {
+    if (lidar == NULL || lidar->lidar == NULL) {
+        return;
+    }
+
+    CLidar *drv = static_cast<CLidar *>(lidar->lidar);
+
+    if (drv) {
+        drv->setLinkStateCallback(callback, user);
+    }
+}
+
+LinkState getLinkState(PubLidar *lidar) {
+    if (lidar == NULL || lidar->lidar == NULL) {
+        return LinkStateUnknown;
+    }
+
+    CLidar *drv = static_cast<CLidar *>(lidar->lidar);
+
+    if (drv) {
+        return drv->getLinkState();
+    }
+
+    return LinkStateUnknown;
+}
+
+void setDriverStateCallback(PubLidar *lidar, DriverStateCallback callback, void *user) {
+    if (lidar == NULL || lidar->lidar == NULL) {
+        return;
+    }
+
+    CLidar *drv = static_cast<CLidar *>(lidar->lidar);
+
+    if (drv) {
+        drv->setDriverStateCallback(callback, user);
+    }
+}
+
+DriverState getDriverState(PubLidar *lidar) {
+    if (lidar == NULL || lidar->lidar == NULL) {
+        return DriverStateDisconnected;
+    }
+
+    CLidar *drv = static_cast<CLidar *>(lidar->lidar);
+
+    if (drv) {
+        return drv->getDriverState();
+    }
+
+    return DriverStateDisconnected;
+}
+
+bool getMetrics(PubLidar *lidar, LidarMetrics *metrics) {
+    if (lidar == NULL || lidar->lidar == NULL || metrics == NULL) {
+        return false;
+    }
+
+    CLidar *drv = static_cast<CLidar *>(lidar->lidar);
+    *metrics = drv->getMetrics();
+    return true;
+}
+
+int getMetricsText(PubLidar *lidar, char *text, int size) {
+    if (lidar == NULL || lidar->lidar == NULL) {
+        return 0;
+    }
+
+    CLidar *drv = static_cast<CLidar *>(lidar->lidar);
+    std::string metrics = drv->getMetricsText();
+
+    if (text != NULL && size > 0) {
+        snprintf(text, size, "%s", metrics.c_str());
+    }
+
+    return (int)metrics.size();
+}
+
+bool getScanLatency(PubLidar *lidar, ScanLatency *latency) {
+    if (lidar == NULL || lidar->lidar == NULL || latency == NULL) {
+        return false;
+    }
+
+    CLidar *drv = static_cast<CLidar *>(lidar->lidar);
+    drv->getScanLatency(*latency);
+    return true;
+}
+
+bool getScanTimeline(PubLidar *lidar, ScanTimeline *timeline) {
+    if (lidar == NULL || lidar->lidar == NULL || timeline == NULL) {
+        return false;
+    }
+
+    CLidar *drv = static_cast<CLidar *>(lidar->lidar);
+    *timeline = drv->getScanTimeline();
+    return true;
+}
+
+bool getScanStats(PubLidar *lidar, ScanStats *stats) {
+    if (lidar == NULL || lidar->lidar == NULL || stats == NULL) {
+        return false;
+    }
+
+    CLidar *drv = static_cast<CLidar *>(lidar->lidar);
+    *stats = drv->getScanStats();
+    return true;
+}
+
+bool getClockSync(PubLidar *lidar, ClockSyncState *clock) {
+    if (lidar == NULL || lidar->lidar == NULL || clock == NULL) {
+        return false;
+    }
+
+    CLidar *drv = static_cast<CLidar *>(lidar->lidar);
+    *clock = drv->getClockSync();
+    return true;
+}
+
+bool writeLatencyTrace(PubLidar *lidar, const char *path) {
+    if (lidar == NULL || lidar->lidar == NULL || path == NULL) {
+        return false;
+    }
+
+    CLidar *drv = static_cast<CLidar *>(lidar->lidar);
+    return drv->writeLatencyTrace(path);
+}
+
 int lidarPortList(PubLidar *lidar, LidarPort *ports) {
     if (lidar == NULL || ports == NULL) {
         return 0;
@@ -215,3 +342,21 @@ int lidarPortList(PubLidar *lidar, LidarPort *ports) {
     }
     return i;
 }
+
+bool subscribeDiscovery(PubLidar *lidar, DiscoveryCallback callback, void *user) {
+    if (lidar == NULL || lidar->lidar == NULL) {
+        return false;
+    }
+
+    CLidar *drv = static_cast<CLidar *>(lidar->lidar);
+    return drv->subscribeDiscovery(callback, user);
+}
+
+bool unsubscribeDiscovery(PubLidar *lidar, DiscoveryCallback callback, void *user) {
+    if (lidar == NULL || lidar->lidar == NULL) {
+        return false;
+    }
+
+    CLidar *drv = static_cast<CLidar *>(lidar->lidar);
+    return drv->unsubscribeDiscovery(callback, user);
+}
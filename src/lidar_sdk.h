@@ -71,6 +71,10 @@ LIDAR_API void lidarDestroy(PubLidar **lidar);
  * @todo string properties
  * - @ref LidarPropSerialPort
  * - @ref LidarPropIgnoreArray
+ * - @ref LidarPropRecordPath
+ * - @ref LidarPropArchivePath
+ * - @ref LidarPropThreadCpus
+ * - @ref LidarPropMetricsPath
  * @note set string property example
  * @code
  * CLidar laser;
@@ -82,6 +86,12 @@ LIDAR_API void lidarDestroy(PubLidar **lidar);
  * - @ref LidarPropLidarType
  * - @ref LidarPropDeviceType
  * - @ref LidarPropSampleRate
+ * - @ref LidarPropLivenessTimeout
+ * - @ref LidarPropDataPort
+ * - @ref LidarPropThreadPolicy
+ * - @ref LidarPropThreadPriority
+ * - @ref LidarPropThreadStackSize
+ * - @ref LidarPropMetricsInterval
  * @note set int property example
  * @code
  * CLidar laser;
@@ -95,6 +105,8 @@ LIDAR_API void lidarDestroy(PubLidar **lidar);
  * - @ref LidarPropAutoReconnect
  * - @ref LidarPropSingleChannel
  * - @ref LidarPropIntenstiy
+ * - @ref LidarPropSupportHeartBeat
+ * - @ref LidarPropReplayLoop
  * @note set bool property example
  * @code
  * CLidar laser;
@@ -107,6 +119,7 @@ LIDAR_API void lidarDestroy(PubLidar **lidar);
  * - @ref LidarPropMaxAngle
  * - @ref LidarPropMinAngle
  * - @ref LidarPropScanFrequency
+ * - @ref LidarPropReplaySpeed
  * @note set float property example
  * @code
  * CLidar laser;
@@ -133,6 +146,10 @@ LIDAR_API bool setlidaropt(PubLidar *lidar, int optname, const void *optval,
  * @todo string properties
  * - @ref LidarPropSerialPort
  * - @ref LidarPropIgnoreArray
+ * - @ref LidarPropRecordPath
+ * - @ref LidarPropArchivePath
+ * - @ref LidarPropThreadCpus
+ * - @ref LidarPropMetricsPath
  * @note get string property example
  * @code
  * CLidar laser;
@@ -144,6 +161,12 @@ LIDAR_API bool setlidaropt(PubLidar *lidar, int optname, const void *optval,
  * - @ref LidarPropLidarType
  * - @ref LidarPropDeviceType
  * - @ref LidarPropSampleRate
+ * - @ref LidarPropLivenessTimeout
+ * - @ref LidarPropDataPort
+ * - @ref LidarPropThreadPolicy
+ * - @ref LidarPropThreadPriority
+ * - @ref LidarPropThreadStackSize
+ * - @ref LidarPropMetricsInterval
  * @note get int property example
  * @code
  * CLidar laser;
@@ -157,6 +180,8 @@ LIDAR_API bool setlidaropt(PubLidar *lidar, int optname, const void *optval,
  * - @ref LidarPropAutoReconnect
  * - @ref LidarPropSingleChannel
  * - @ref LidarPropIntenstiy
+ * - @ref LidarPropSupportHeartBeat
+ * - @ref LidarPropReplayLoop
  * @note get bool property example
  * @code
  * CLidar laser;
@@ -169,6 +194,7 @@ LIDAR_API bool setlidaropt(PubLidar *lidar, int optname, const void *optval,
  * - @ref LidarPropMaxAngle
  * - @ref LidarPropMinAngle
  * - @ref LidarPropScanFrequency
+ * - @ref LidarPropReplaySpeed
  * @note set float property example
  * @code
  * CLidar laser;
@@ -244,6 +270,95 @@ LIDAR_API bool os_isOk();
  */
 LIDAR_API void os_shutdown();
 
+/**
+ * @brief set the link state transition callback
+ * @param lidar     a lidar instance
+ * @param callback  called from an SDK thread on every transition, NULL to disable
+ * @param user      user data passed to the callback
+ */
+LIDAR_API void setLinkStateCallback(PubLidar *lidar, LinkStateCallback callback, void *user);
+
+/**
+ * @brief get the link liveness state
+ * @param lidar     a lidar instance
+ * @return link state
+ */
+LIDAR_API LinkState getLinkState(PubLidar *lidar);
+
+/**
+ * @brief set the driver state transition callback
+ * @param lidar     a lidar instance
+ * @param callback  called on every lifecycle transition, NULL to disable
+ * @param user      user data passed to the callback
+ */
+LIDAR_API void setDriverStateCallback(PubLidar *lidar, DriverStateCallback callback, void *user);
+
+/**
+ * @brief get the driver lifecycle state
+ * @param lidar     a lidar instance
+ * @return driver state
+ */
+LIDAR_API DriverState getDriverState(PubLidar *lidar);
+
+/**
+ * @brief get the ingest pipeline metrics
+ * @param lidar         a lidar instance
+ * @param[out] metrics  totals since ::initialize created the driver
+ * @return true if successfully get, otherwise false.
+ */
+LIDAR_API bool getMetrics(PubLidar *lidar, LidarMetrics *metrics);
+
+/**
+ * @brief get the ingest pipeline metrics in Prometheus text format
+ * @param lidar      a lidar instance
+ * @param[out] text  buffer, NUL terminated, NULL to query the size
+ * @param size       buffer size
+ * @return text length without the NUL, the text is cut if it is not less than size
+ */
+LIDAR_API int getMetricsText(PubLidar *lidar, char *text, int size);
+
+/**
+ * @brief get the latency percentiles of every stage a revolution goes through
+ * @param lidar         a lidar instance
+ * @param[out] latency  percentiles of the revolutions returned by ::doProcessSimple
+ * @return true if successfully get, otherwise false.
+ */
+LIDAR_API bool getScanLatency(PubLidar *lidar, ScanLatency *latency);
+
+/**
+ * @brief get the timeline of the revolution returned by the last ::doProcessSimple
+ * @param lidar          a lidar instance
+ * @param[out] timeline  getns() of every stage
+ * @return true if successfully get, otherwise false.
+ */
+LIDAR_API bool getScanTimeline(PubLidar *lidar, ScanTimeline *timeline);
+
+/**
+ * @brief get the measured scan frequency, motor stability and angular gaps
+ * of the revolution returned by the last ::doProcessSimple
+ * @param lidar       a lidar instance
+ * @param[out] stats  speed and coverage, zeroed before the first revolution
+ * @return true if successfully get, otherwise false.
+ */
+LIDAR_API bool getScanStats(PubLidar *lidar, ScanStats *stats);
+
+/**
+ * @brief get the relation of the lidar clock to the host clock,
+ * LaserFan::stamp is the lidar stamp mapped with it
+ * @param lidar       a lidar instance
+ * @param[out] clock  offset, skew and error bound
+ * @return true if successfully get, otherwise false.
+ */
+LIDAR_API bool getClockSync(PubLidar *lidar, ClockSyncState *clock);
+
+/**
+ * @brief write the timelines of the last revolutions as a Chrome trace(json)
+ * @param lidar  a lidar instance
+ * @param path   file, loads in chrome://tracing and ui.perfetto.dev
+ * @return true if the file is written
+ */
+LIDAR_API bool writeLatencyTrace(PubLidar *lidar, const char *path);
+
 /**
  * @brief get lidar serial port
  * @param ports serial port lists
@@ -251,6 +366,24 @@ LIDAR_API void os_shutdown();
  */
 LIDAR_API int lidarPortList(PubLidar *lidar, LidarPort *ports);
 
+/**
+ * @brief subscribe to the lidars heard on the broadcast port
+ * @param lidar     a lidar instance, the subscription ends with it
+ * @param callback  called from the discovery thread on every add, change and expiry
+ * @param user      user data passed to the callback
+ * @return true if the listener is running, false if the port is taken by another process
+ */
+LIDAR_API bool subscribeDiscovery(PubLidar *lidar, DiscoveryCallback callback, void *user);
+
+/**
+ * @brief unsubscribe a callback given to ::subscribeDiscovery
+ * @param lidar     a lidar instance
+ * @param callback  event callback
+ * @param user      user data given to ::subscribeDiscovery
+ * @return true if the callback was subscribed
+ */
+LIDAR_API bool unsubscribeDiscovery(PubLidar *lidar, DiscoveryCallback callback, void *user);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,223 @@
+#include "ArchiveCodec.h"
+#include <string.h>
+
+namespace lidar {
+
+#define ARCHIVE_MAX_RICE (20)
+
+static inline uint32_t zigzag(int32_t v) {
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+
+static inline int32_t unzigzag(uint32_t u) {
+    return (int32_t)(u >> 1) ^ -(int32_t)(u & 1);
+}
+
+
+static inline int32_t clamp32(int64_t v) {
+    return v > INT32_MAX ? INT32_MAX : (v < INT32_MIN ? INT32_MIN : (int32_t)v);
+}
+
+/// LSB first bit packer
+class BitWriter {
+public:
+    explicit BitWriter(std::vector<uint8_t> &out)
+        : m_out(out)
+        , m_acc(0)
+        , m_bits(0) {
+    }
+
+    /// bits <= 32
+    void put(uint32_t value, int bits) {
+        m_acc |= (uint64_t)value << m_bits;
+        m_bits += bits;
+        while (m_bits >= 8) {
+            m_out.push_back(static_cast<uint8_t>(m_acc));
+            m_acc >>= 8;
+            m_bits -= 8;
+        }
+    }
+
+    void rice(uint32_t value, int k) {
+        uint32_t q = value >> k;
+        if (q < ARCHIVE_RICE_ESCAPE) {
+            //q ones closed by a zero
+            put((1u << q) - 1, q + 1);
+            if (k) {
+                put(value & ((1u << k) - 1), k);
+            }
+        } else {
+            put((1u << ARCHIVE_RICE_ESCAPE) - 1, ARCHIVE_RICE_ESCAPE);
+            put(value, 32);
+        }
+    }
+
+    void flush() {
+        if (m_bits > 0) {
+            m_out.push_back(static_cast<uint8_t>(m_acc));
+        }
+        m_acc = 0;
+        m_bits = 0;
+    }
+
+private:
+    std::vector<uint8_t> &m_out;
+    uint64_t m_acc;
+    int m_bits;
+};
+
+/// LSB first bit reader, reading past the end sets the overrun flag
+class BitReader {
+public:
+    BitReader(const uint8_t *data, size_t size)
+        : m_p(data)
+        , m_end(data + size)
+        , m_acc(0)
+        , m_bits(0)
+        , m_overrun(false) {
+    }
+
+    uint32_t get(int bits) {
+        while (m_bits <= 56 && m_p < m_end) {
+            m_acc |= (uint64_t)(*m_p++) << m_bits;
+            m_bits += 8;
+        }
+        if (m_bits < bits) {
+            m_overrun = true;
+            return 0;
+        }
+        uint32_t value = static_cast<uint32_t>(m_acc & ((bits == 32) ? 0xffffffffull : ((1ull << bits) - 1)));
+        m_acc >>= bits;
+        m_bits -= bits;
+        return value;
+    }
+
+    uint32_t rice(int k) {
+        uint32_t q = 0;
+        while (q < ARCHIVE_RICE_ESCAPE && get(1) && !m_overrun) {
+            q++;
+        }
+        if (q == ARCHIVE_RICE_ESCAPE) {
+            return get(32);
+        }
+        return k ? (q << k) | get(k) : q;
+    }
+
+    bool overrun() const {
+        return m_overrun;
+    }
+
+private:
+    const uint8_t *m_p;
+    const uint8_t *m_end;
+    uint64_t m_acc;
+    int m_bits;
+    bool m_overrun;
+};
+
+/// Rice parameter giving the fewest bits for a column
+static uint8_t best_rice(const std::vector<uint32_t> &column) {
+    uint64_t best_bits = UINT64_MAX;
+    uint8_t best = 0;
+    for (int k = 0; k <= ARCHIVE_MAX_RICE; k++) {
+        uint64_t bits = 0;
+        for (size_t i = 0; i < column.size(); i++) {
+            uint32_t q = column[i] >> k;
+            bits += q < ARCHIVE_RICE_ESCAPE ? q + 1 + k : ARCHIVE_RICE_ESCAPE + 32;
+        }
+        if (bits < best_bits) {
+            best_bits = bits;
+            best = k;
+        }
+    }
+    return best;
+}
+
+
+void ArchiveEncoder::encode(const node_info *nodes, uint32_t count, uint64_t host_ns, uint32_t revolution,
+                            archive_block_header &header, std::vector<uint8_t> &out) {
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, ARCHIVE_BLOCK_MAGIC, sizeof(header.magic));
+    header.host_ns = host_ns;
+    header.revolution = revolution;
+    header.count = count;
+    if (count == 0) {
+        return;
+    }
+    header.device_ms = nodes[0].stamp / 1000000;
+    header.device_us = nodes[0].stamp / 1000 % 1000;
+    header.first_angle = nodes[0].angle_q6_checkbit;
+    header.first_distance = nodes[0].distance_q2;
+    header.first_quality = nodes[0].sync_quality;
+    header.flags = (nodes[0].sync_flag & Node_Sync) ? ARCHIVE_BLOCK_SYNC : 0;
+    if (count > 1) {
+        int32_t span = (int32_t)nodes[count - 1].angle_q6_checkbit - nodes[0].angle_q6_checkbit;
+        int32_t step = (span + (int32_t)(count - 1) / 2) / (int32_t)(count - 1);
+        header.angle_step = step > 0 ? step : 0;
+    }
+
+    for (int c = 0; c < ARCHIVE_COLUMNS; c++) {
+        m_columns[c].resize(count - 1);
+    }
+    for (uint32_t i = 1; i < count; i++) {
+        const node_info &prev = nodes[i - 1];
+        const node_info &cur = nodes[i];
+        m_columns[0][i - 1] = zigzag((int32_t)cur.angle_q6_checkbit - prev.angle_q6_checkbit - header.angle_step);
+        m_columns[1][i - 1] = zigzag((int32_t)cur.distance_q2 - prev.distance_q2);
+        m_columns[2][i - 1] = zigzag((int32_t)cur.sync_quality - prev.sync_quality);
+        //whole microseconds of each stamp, the rounding does not add up
+        m_columns[3][i - 1] = zigzag(clamp32((int64_t)(cur.stamp / 1000) - (int64_t)(prev.stamp / 1000)));
+    }
+
+    size_t start = out.size();
+    BitWriter writer(out);
+    for (int c = 0; c < ARCHIVE_COLUMNS; c++) {
+        header.rice[c] = best_rice(m_columns[c]);
+        for (size_t i = 0; i < m_columns[c].size(); i++) {
+            writer.rice(m_columns[c][i], header.rice[c]);
+        }
+    }
+    writer.flush();
+    header.size = out.size() - start;
+}
+
+
+bool ArchiveDecoder::decode(const archive_block_header &header, const uint8_t *data, node_info *nodes,
+                            uint16_t version) {
+    if (header.count == 0) {
+        return true;
+    }
+    for (int c = 0; c < ARCHIVE_COLUMNS; c++) {
+        if (header.rice[c] > ARCHIVE_MAX_RICE) {
+            return false;
+        }
+    }
+
+    memset(nodes, 0, header.count * sizeof(node_info));
+    nodes[0].sync_flag = (header.flags & ARCHIVE_BLOCK_SYNC) ? Node_Sync : Node_NotSync;
+    nodes[0].angle_q6_checkbit = header.first_angle;
+    nodes[0].distance_q2 = header.first_distance;
+    nodes[0].sync_quality = header.first_quality;
+    uint64_t unit = version < 2 ? 1000000 : 1000;
+    nodes[0].stamp = header.device_ms * 1000000 + (version < 2 ? 0 : header.device_us * 1000ULL);
+
+    BitReader reader(data, header.size);
+    for (uint32_t i = 1; i < header.count; i++) {
+        nodes[i].sync_flag = Node_NotSync;
+        nodes[i].angle_q6_checkbit = nodes[i - 1].angle_q6_checkbit + header.angle_step +
+                                     unzigzag(reader.rice(header.rice[0]));
+    }
+    for (uint32_t i = 1; i < header.count; i++) {
+        nodes[i].distance_q2 = nodes[i - 1].distance_q2 + unzigzag(reader.rice(header.rice[1]));
+    }
+    for (uint32_t i = 1; i < header.count; i++) {
+        nodes[i].sync_quality = nodes[i - 1].sync_quality + unzigzag(reader.rice(header.rice[2]));
+    }
+    for (uint32_t i = 1; i < header.count; i++) {
+        nodes[i].stamp = nodes[i - 1].stamp + (int64_t)unzigzag(reader.rice(header.rice[3])) * unit;
+    }
+    return !reader.overrun();
+}
+
+}//namespace lidar
@@ -0,0 +1,52 @@
+#ifndef ARCHIVE_CODEC_H
+#define ARCHIVE_CODEC_H
+#include <vector>
+#include <core/common/lidar_protocol.h>
+#include <core/common/lidar_datatype.h>
+#include "ArchiveFormat.h"
+
+namespace lidar {
+
+/**
+ * @brief Encodes revolutions into archive blocks \n
+ * The column buffers are kept between calls, encoding allocates nothing
+ * once the largest revolution was seen.
+ */
+class ArchiveEncoder {
+public:
+    /**
+     * @brief encode a revolution
+     * @param nodes       points of the revolution
+     * @param count       point count
+     * @param host_ns     host time the revolution was received, realtime clock(ns)
+     * @param revolution  revolution number
+     * @param header      block header, size is the number of bytes appended to out
+     * @param out         encoded points are appended
+     */
+    void encode(const node_info *nodes, uint32_t count, uint64_t host_ns, uint32_t revolution,
+                archive_block_header &header, std::vector<uint8_t> &out);
+
+private:
+    std::vector<uint32_t> m_columns[ARCHIVE_COLUMNS];
+};
+
+/**
+ * @brief Decodes archive blocks
+ */
+class ArchiveDecoder {
+public:
+    /**
+     * @brief decode a block
+     * @param header  block header
+     * @param data    header.size encoded bytes following the header
+     * @param nodes   header.count points are written
+     * @param version archive version, stamps are stored in ms up to version 1
+     * @return false if the block is corrupt
+     */
+    bool decode(const archive_block_header &header, const uint8_t *data, node_info *nodes,
+                uint16_t version = ARCHIVE_VERSION);
+};
+
+}//namespace lidar
+
+#endif // ARCHIVE_CODEC_H
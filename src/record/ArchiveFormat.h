@@ -0,0 +1,82 @@
+#ifndef ARCHIVE_FORMAT_H
+#define ARCHIVE_FORMAT_H
+#include <core/base/v8stdint.h>
+
+/**
+ * Scan archive layout, little endian:
+ *
+ *   archive_file_header
+ *   archive_block_header + encoded points ...   (one block per revolution)
+ *   archive_index_entry ...                     (written on close)
+ *   archive_file_footer                         (written on close)
+ *
+ * The first point of a revolution is stored in the block header. The
+ * others are stored as four bit-packed columns of zigzag-mapped residuals,
+ * Rice coded with a parameter chosen per block and column:
+ *
+ *   angle     difference to the previous angle minus angle_step
+ *   distance  difference to the previous distance
+ *   quality   difference to the previous quality
+ *   stamp     difference to the previous stamp(us, ms in version 1)
+ *
+ * A file without footer (writer killed) is still readable, the blocks are
+ * scanned up to the last complete one.
+ */
+#define ARCHIVE_FILE_MAGIC "LDSA"
+#define ARCHIVE_BLOCK_MAGIC "LDRV"
+#define ARCHIVE_INDEX_MAGIC "LDSX"
+#define ARCHIVE_VERSION (2)
+#define ARCHIVE_INDEX_INTERVAL (64)   ///< revolutions between two index entries
+#define ARCHIVE_COLUMNS (4)
+#define ARCHIVE_RICE_ESCAPE (24)      ///< unary prefix length of a raw 32 bit value
+#define ARCHIVE_BLOCK_SYNC (0x1)      ///< the first point is a sync point
+
+#if defined(_WIN32)
+#pragma pack(1)
+#endif
+
+struct archive_file_header {
+    char magic[4];               ///< ARCHIVE_FILE_MAGIC
+    uint16_t version;            ///< ARCHIVE_VERSION
+    uint16_t header_size;        ///< sizeof(archive_file_header)
+    uint32_t index_interval;     ///< revolutions between two index entries
+    uint32_t reserved;
+    uint64_t start_ns;           ///< realtime clock when the archive was created
+}__attribute__((packed));
+
+struct archive_block_header {
+    char magic[4];               ///< ARCHIVE_BLOCK_MAGIC
+    uint32_t size;               ///< encoded bytes following the header
+    uint64_t host_ns;            ///< host time the revolution was received, realtime clock(ns)
+    uint64_t device_ms;          ///< stamp of the first point(ms)
+    uint32_t revolution;         ///< revolution number since the archive was created
+    uint32_t count;              ///< point count
+    uint16_t first_angle;        ///< angle of the first point(0.01°)
+    uint16_t first_distance;     ///< distance of the first point
+    uint16_t first_quality;      ///< quality of the first point
+    uint16_t angle_step;         ///< expected angle increment(0.01°)
+    uint8_t flags;               ///< ARCHIVE_BLOCK_SYNC
+    uint8_t rice[ARCHIVE_COLUMNS];///< Rice parameter of each column
+    uint16_t device_us;          ///< sub-millisecond part of the first stamp(us), 0 in version 1
+    uint8_t reserved[1];
+}__attribute__((packed));
+
+struct archive_index_entry {
+    uint64_t host_ns;            ///< host time of the indexed block
+    uint64_t device_ms;          ///< device time of the indexed block
+    uint32_t revolution;         ///< revolution number of the indexed block
+    uint32_t reserved;
+    uint64_t offset;             ///< file offset of the indexed block
+}__attribute__((packed));
+
+struct archive_file_footer {
+    uint64_t index_offset;       ///< file offset of the first index entry
+    uint32_t index_count;        ///< index entry count
+    char magic[4];               ///< ARCHIVE_INDEX_MAGIC
+}__attribute__((packed));
+
+#if defined(_WIN32)
+#pragma pack()
+#endif
+
+#endif // ARCHIVE_FORMAT_H
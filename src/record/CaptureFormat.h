@@ -0,0 +1,70 @@
+#ifndef CAPTURE_FORMAT_H
+#define CAPTURE_FORMAT_H
+#include <core/base/v8stdint.h>
+
+/**
+ * Capture file layout, little endian:
+ *
+ *   capture_file_header
+ *   capture_record_header + payload (padded to CAPTURE_ALIGN) ...
+ *   capture_index_entry ...           (written on close)
+ *   capture_file_footer               (written on close)
+ *
+ * The index holds an entry for the record carrying the first point of every
+ * revolution and for every CAPTURE_INDEX_INTERVAL-th record in between, so
+ * records can be found by receive time, device time or revolution.
+ *
+ * A file without footer (recorder killed) is still readable, the records
+ * are scanned up to the last complete one and the index is rebuilt.
+ */
+#define CAPTURE_FILE_MAGIC "LDCP"
+#define CAPTURE_INDEX_MAGIC "LDIX"
+#define CAPTURE_VERSION (2)
+#define CAPTURE_ALIGN (8)
+#define CAPTURE_INDEX_INTERVAL (256)  ///< records between two index entries at most
+#define CAPTURE_INDEX_REVOLUTION (0x1)///< the indexed record starts a revolution
+
+#if defined(_WIN32)
+#pragma pack(1)
+#endif
+
+struct capture_file_header {
+    char magic[4];               ///< CAPTURE_FILE_MAGIC
+    uint16_t version;            ///< CAPTURE_VERSION
+    uint16_t header_size;        ///< sizeof(capture_file_header)
+    uint32_t index_interval;     ///< records between two index entries
+    uint32_t reserved;
+    uint64_t start_ns;           ///< realtime clock when the capture started
+}__attribute__((packed));
+
+struct capture_record_header {
+    uint64_t recv_ns;            ///< kernel receive time, realtime clock(ns)
+    uint32_t src_addr;           ///< source IPv4 address, network byte order
+    uint16_t src_port;           ///< source port, host byte order
+    uint16_t length;             ///< payload length
+}__attribute__((packed));
+
+struct capture_index_entry {
+    uint64_t recv_ns;            ///< receive time of the indexed record
+    uint64_t device_ms;          ///< device time of the indexed record, or of the last DataFrame before it(ms)
+    uint32_t revolution;         ///< revolution number since the capture started
+    uint32_t flags;              ///< CAPTURE_INDEX_REVOLUTION
+    uint64_t offset;             ///< file offset of the indexed record
+}__attribute__((packed));
+
+struct capture_file_footer {
+    uint64_t index_offset;       ///< file offset of the first index entry
+    uint32_t index_count;        ///< index entry count
+    char magic[4];               ///< CAPTURE_INDEX_MAGIC
+}__attribute__((packed));
+
+#if defined(_WIN32)
+#pragma pack()
+#endif
+
+/// size of a record in the file
+static inline uint64_t capture_record_size(uint16_t length) {
+    return (sizeof(capture_record_header) + length + CAPTURE_ALIGN - 1) & ~(uint64_t)(CAPTURE_ALIGN - 1);
+}
+
+#endif // CAPTURE_FORMAT_H
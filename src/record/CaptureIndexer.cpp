@@ -0,0 +1,66 @@
+#include "CaptureIndexer.h"
+#include <core/common/lidar_protocol.h>
+#include <core/common/lidar_help.h>
+
+namespace lidar {
+
+CaptureIndexer::CaptureIndexer() {
+    reset();
+}
+
+
+void CaptureIndexer::reset() {
+    m_index.clear();
+    m_unindexed = 0;
+    m_revolution = 0;
+    m_deviceMs = 0;
+    m_source = 0;
+    m_lastAngle = -1;
+}
+
+
+bool CaptureIndexer::deviceTime(const uint8_t *payload, uint16_t length, uint64_t &device_ms) {
+    if (length < sizeof(DataFrame)) {
+        return false;
+    }
+    const DataFrame &frame = *reinterpret_cast<const DataFrame *>(payload);
+    if (BigLittleSwap16(frame.dataBlock[0].frameHead) != 0xFFEE) {
+        return false;
+    }
+    device_ms = (uint64_t)BigLittleSwap32(frame.timeStamp_s) * 1000 + BigLittleSwap32(frame.timeStamp_ms);
+    return true;
+}
+
+
+void CaptureIndexer::add(uint64_t recv_ns, uint32_t src_addr, const uint8_t *payload, uint16_t length,
+                         uint64_t offset) {
+    bool start = false;
+    uint64_t device_ms = 0;
+    if ((m_source == 0 || src_addr == m_source) && deviceTime(payload, length, device_ms)) {
+        m_source = src_addr;
+        m_deviceMs = device_ms;
+        const DataFrame &frame = *reinterpret_cast<const DataFrame *>(payload);
+        for (int i = 0; i < DATABLOCK_COUNT; i++) {
+            int angle = BigLittleSwap16(frame.dataBlock[i].startAngle);
+            if (m_lastAngle >= 0 && angle < m_lastAngle && !start) {
+                start = true;
+                m_revolution++;
+            }
+            m_lastAngle = angle;
+        }
+    }
+
+    if (start || m_index.empty() || m_unindexed >= CAPTURE_INDEX_INTERVAL) {
+        capture_index_entry entry;
+        entry.recv_ns = recv_ns;
+        entry.device_ms = m_deviceMs;
+        entry.revolution = m_revolution;
+        entry.flags = start ? CAPTURE_INDEX_REVOLUTION : 0;
+        entry.offset = offset;
+        m_index.push_back(entry);
+        m_unindexed = 0;
+    }
+    m_unindexed++;
+}
+
+}//namespace lidar
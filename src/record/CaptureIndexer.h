@@ -0,0 +1,63 @@
+#ifndef CAPTURE_INDEXER_H
+#define CAPTURE_INDEXER_H
+#include <vector>
+#include "CaptureFormat.h"
+
+namespace lidar {
+
+/**
+ * @brief Builds the sparse capture index from the recorded datagrams \n
+ * Payloads that are DataFrames are inspected for the device time and for
+ * the revolution start, a revolution starts in the record whose block
+ * start angle wraps around. Only the source of the first DataFrame is
+ * followed, as ReplayDriver replays it, other lidars on the same port would
+ * mix their angles into its revolutions. Used by CaptureWriter while recording and by
+ * CaptureReader for files without a usable index.
+ */
+class CaptureIndexer {
+public:
+    CaptureIndexer();
+
+    /**
+     * @brief forget all records and entries
+     */
+    void reset();
+
+    /**
+     * @brief account for the next record
+     * @param recv_ns   receive time of the record
+     * @param src_addr  source address of the record, network byte order
+     * @param payload   datagram
+     * @param length    datagram length
+     * @param offset    file offset of the record
+     */
+    void add(uint64_t recv_ns, uint32_t src_addr, const uint8_t *payload, uint16_t length, uint64_t offset);
+
+    /**
+     * @brief index entries, ordered by offset
+     */
+    const std::vector<capture_index_entry> &index() const {
+        return m_index;
+    }
+
+    /**
+     * @brief device time of a DataFrame
+     * @param payload    datagram
+     * @param length     datagram length
+     * @param device_ms  device time(ms)
+     * @return false if the datagram is not a DataFrame
+     */
+    static bool deviceTime(const uint8_t *payload, uint16_t length, uint64_t &device_ms);
+
+private:
+    std::vector<capture_index_entry> m_index;
+    uint32_t m_unindexed;             ///< records since the last entry
+    uint32_t m_revolution;            ///< revolution of the next record
+    uint64_t m_deviceMs;              ///< device time of the last DataFrame
+    uint32_t m_source;                ///< indexed lidar address, network byte order, 0 before the first DataFrame
+    int m_lastAngle;                  ///< start angle of the last block, -1 before the first DataFrame
+};
+
+}//namespace lidar
+
+#endif // CAPTURE_INDEXER_H
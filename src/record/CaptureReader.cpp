@@ -0,0 +1,266 @@
+#include "CaptureReader.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+namespace lidar {
+
+/// index entry size of version 1 files, which had no device time and revolution
+#define CAPTURE_V1_INDEX_ENTRY_SIZE (16)
+
+CaptureReader::CaptureReader()
+    : m_data(NULL)
+    , m_size(0)
+    , m_end(0)
+    , m_pos(0)
+    , m_index(NULL)
+    , m_indexCount(0)
+    , m_indexed(false) {
+}
+
+
+CaptureReader::~CaptureReader() {
+    close();
+}
+
+
+bool CaptureReader::open(const char *path) {
+    close();
+    if (!m_file.open(path)) {
+        return false;
+    }
+    m_data = m_file.data();
+    m_size = m_file.size();
+    if (m_size < sizeof(capture_file_header) ||
+        memcmp(header()->magic, CAPTURE_FILE_MAGIC, 4) != 0 ||
+        (header()->version != 1 && header()->version != CAPTURE_VERSION) ||
+        header()->header_size < sizeof(capture_file_header) ||
+        header()->header_size > m_size) {
+        close();
+        return false;
+    }
+
+    //the footer is only present if the recorder was closed properly
+    size_t entry_size = header()->version == 1 ? CAPTURE_V1_INDEX_ENTRY_SIZE : sizeof(capture_index_entry);
+    m_end = m_size;
+    if (m_size >= header()->header_size + sizeof(capture_file_footer)) {
+        const capture_file_footer *footer = reinterpret_cast<const capture_file_footer *>(
+            m_data + m_size - sizeof(capture_file_footer));
+        if (memcmp(footer->magic, CAPTURE_INDEX_MAGIC, 4) == 0 &&
+            footer->index_offset >= header()->header_size &&
+            footer->index_offset + (uint64_t)footer->index_count * entry_size +
+            sizeof(capture_file_footer) == m_size) {
+            m_end = footer->index_offset;
+            if (header()->version == CAPTURE_VERSION) {
+                m_indexCount = footer->index_count;
+                m_index = m_indexCount ? reinterpret_cast<const capture_index_entry *>(m_data + m_end) : NULL;
+                m_indexed = true;
+            }
+        }
+    }
+
+    if (!m_indexed) {
+        //one pass over the record headers, the payloads are only peeked at
+        //a recorder killed while closing leaves index entries or zeroed pages without a footer,
+        //neither reads as a record: every recorded datagram has a length and a receive time
+        size_t pos = header()->header_size;
+        while (pos + sizeof(capture_record_header) <= m_end) {
+            const capture_record_header *record = reinterpret_cast<const capture_record_header *>(m_data + pos);
+            if (record->length == 0 || record->recv_ns == 0 ||
+                pos + sizeof(capture_record_header) + record->length > m_end) {
+                break;
+            }
+            m_indexer.add(record->recv_ns, record->src_addr, m_data + pos + sizeof(capture_record_header), record->length, pos);
+            pos += capture_record_size(record->length);
+        }
+        m_end = std::min(pos, m_end);
+        m_indexCount = m_indexer.index().size();
+        m_index = m_indexCount ? &m_indexer.index()[0] : NULL;
+    }
+    rewind();
+    return true;
+}
+
+
+void CaptureReader::close() {
+    m_file.close();
+    m_data = NULL;
+    m_size = 0;
+    m_end = 0;
+    m_pos = 0;
+    m_index = NULL;
+    m_indexCount = 0;
+    m_indexed = false;
+    m_indexer.reset();
+}
+
+
+bool CaptureReader::next(capture_frame &frame) {
+    if (!m_data || m_pos + sizeof(capture_record_header) > m_end) {
+        return false;
+    }
+    const capture_record_header *record = reinterpret_cast<const capture_record_header *>(m_data + m_pos);
+    uint64_t size = capture_record_size(record->length);
+    if (m_pos + sizeof(capture_record_header) + record->length > m_end) {
+        //truncated by a crash of the recorder
+        m_pos = m_end;
+        return false;
+    }
+    frame.recv_ns = record->recv_ns;
+    frame.src_addr = record->src_addr;
+    frame.src_port = record->src_port;
+    frame.length = record->length;
+    frame.payload = m_data + m_pos + sizeof(capture_record_header);
+    m_pos += size;
+    return true;
+}
+
+
+void CaptureReader::rewind() {
+    m_pos = m_data ? header()->header_size : 0;
+}
+
+
+bool CaptureReader::seek(uint64_t recv_ns) {
+    rewind();
+    if (!m_data) {
+        return false;
+    }
+    //last index entry before recv_ns, the records after it are scanned
+    const capture_index_entry *entry = std::lower_bound(m_index, m_index + m_indexCount, recv_ns,
+    [](const capture_index_entry & e, uint64_t t) {
+        return e.recv_ns < t;
+    });
+    if (entry != m_index && entry[-1].offset < m_end) {
+        m_pos = entry[-1].offset;
+    }
+
+    size_t pos = m_pos;
+    capture_frame frame;
+    while (next(frame)) {
+        if (frame.recv_ns >= recv_ns) {
+            m_pos = pos;
+            return true;
+        }
+        pos = m_pos;
+    }
+    return false;
+}
+
+
+bool CaptureReader::seekDevice(uint64_t device_ms) {
+    rewind();
+    if (!m_data) {
+        return false;
+    }
+    const capture_index_entry *entry = std::lower_bound(m_index, m_index + m_indexCount, device_ms,
+    [](const capture_index_entry & e, uint64_t t) {
+        return e.device_ms < t;
+    });
+    if (entry != m_index && entry[-1].offset < m_end) {
+        m_pos = entry[-1].offset;
+    }
+
+    size_t pos = m_pos;
+    capture_frame frame;
+    uint64_t stamp = 0;
+    while (next(frame)) {
+        if (CaptureIndexer::deviceTime(frame.payload, frame.length, stamp) && stamp >= device_ms) {
+            m_pos = pos;
+            return true;
+        }
+        pos = m_pos;
+    }
+    return false;
+}
+
+
+bool CaptureReader::seekRevolution(uint32_t revolution) {
+    rewind();
+    if (!m_data) {
+        return false;
+    }
+    //every revolution start has an entry, no scan is needed
+    const capture_index_entry *entry = std::lower_bound(m_index, m_index + m_indexCount, revolution,
+    [](const capture_index_entry & e, uint32_t r) {
+        return e.revolution < r;
+    });
+    if (entry == m_index + m_indexCount || entry->offset >= m_end) {
+        m_pos = m_end;
+        return false;
+    }
+    m_pos = entry->offset;
+    return true;
+}
+
+
+bool CaptureReader::extract(const char *path, uint64_t begin_ns, uint64_t end_ns) {
+    if (!m_data || begin_ns >= end_ns) {
+        return false;
+    }
+    size_t pos = m_pos;
+    if (!seek(begin_ns)) {
+        m_pos = pos;
+        return false;
+    }
+    size_t begin = m_pos;
+    size_t end = seek(end_ns) ? m_pos : m_end;
+    m_pos = pos;
+    if (begin >= end) {
+        return false;
+    }
+
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        return false;
+    }
+    capture_file_header file_header = *header();
+    file_header.version = CAPTURE_VERSION;
+    file_header.header_size = sizeof(file_header);
+    bool ok = fwrite(&file_header, sizeof(file_header), 1, file) == 1 &&
+              fwrite(m_data + begin, end - begin, 1, file) == 1;
+
+    //entries of the window, moved to the new offsets
+    std::vector<capture_index_entry> index;
+    const capture_index_entry *entry = std::lower_bound(m_index, m_index + m_indexCount, (uint64_t)begin,
+    [](const capture_index_entry & e, uint64_t offset) {
+        return e.offset < offset;
+    });
+    if (entry == m_index + m_indexCount || entry->offset != begin) {
+        //the first record gets an entry of its own, it belongs to the revolution of the entry before
+        const capture_record_header *record = reinterpret_cast<const capture_record_header *>(m_data + begin);
+        capture_index_entry first;
+        memset(&first, 0, sizeof(first));
+        first.recv_ns = record->recv_ns;
+        first.offset = begin;
+        if (entry != m_index) {
+            first.device_ms = entry[-1].device_ms;
+            first.revolution = entry[-1].revolution;
+        }
+        uint64_t device_ms = 0;
+        if (CaptureIndexer::deviceTime(m_data + begin + sizeof(capture_record_header), record->length, device_ms)) {
+            first.device_ms = device_ms;
+        }
+        index.push_back(first);
+    }
+    for (; entry != m_index + m_indexCount && entry->offset < end; ++entry) {
+        index.push_back(*entry);
+    }
+    for (size_t i = 0; i < index.size(); i++) {
+        index[i].offset = index[i].offset - begin + sizeof(file_header);
+    }
+
+    capture_file_footer footer;
+    memset(&footer, 0, sizeof(footer));
+    footer.index_offset = sizeof(file_header) + (end - begin);
+    footer.index_count = index.size();
+    memcpy(footer.magic, CAPTURE_INDEX_MAGIC, sizeof(footer.magic));
+    if (!index.empty()) {
+        ok = ok && fwrite(&index[0], sizeof(capture_index_entry), index.size(), file) == index.size();
+    }
+    ok = ok && fwrite(&footer, sizeof(footer), 1, file) == 1;
+    ok = fclose(file) == 0 && ok;
+    return ok;
+}
+
+}//namespace lidar
@@ -0,0 +1,122 @@
+#ifndef CAPTURE_READER_H
+#define CAPTURE_READER_H
+#include <stddef.h>
+#include <vector>
+#include "CaptureIndexer.h"
+#include "MappedFile.h"
+
+namespace lidar {
+
+/// one datagram of a capture file, payload points into the mapped file
+struct capture_frame {
+    uint64_t recv_ns;            ///< receive time, realtime clock(ns)
+    uint32_t src_addr;           ///< source IPv4 address, network byte order
+    uint16_t src_port;           ///< source port, host byte order
+    uint16_t length;             ///< payload length
+    const uint8_t *payload;      ///< datagram, valid until ::close
+};
+
+/**
+ * @brief Memory-mapped capture file reader \n
+ * Frames are returned in place, nothing is copied. The seeks use the sparse
+ * index written by CaptureWriter, the index of a file without footer or of
+ * a version 1 file is rebuilt when it is opened.
+ */
+class CaptureReader {
+public:
+    CaptureReader();
+    ~CaptureReader();
+
+    /**
+     * @brief map a capture file
+     * @param path  file path
+     * @return true if the file is a valid capture
+     */
+    bool open(const char *path);
+
+    /**
+     * @brief unmap the file, returned payloads become invalid
+     */
+    void close();
+
+    /**
+     * @brief whether a capture file is mapped
+     */
+    bool isOpen() const {
+        return m_data != NULL;
+    }
+
+    /**
+     * @brief file header
+     */
+    const capture_file_header *header() const {
+        return reinterpret_cast<const capture_file_header *>(m_data);
+    }
+
+    /**
+     * @brief read the next frame
+     * @param frame  frame, payload points into the mapped file
+     * @return false at the end of the capture
+     */
+    bool next(capture_frame &frame);
+
+    /**
+     * @brief go back to the first frame
+     */
+    void rewind();
+
+    /**
+     * @brief position at the first frame received at or after a time
+     * @param recv_ns  receive time, realtime clock(ns)
+     * @return false if no frame was received at or after recv_ns
+     */
+    bool seek(uint64_t recv_ns);
+
+    /**
+     * @brief position at the first DataFrame stamped at or after a device time
+     * @param device_ms  device time(ms)
+     * @return false if no DataFrame is stamped at or after device_ms
+     */
+    bool seekDevice(uint64_t device_ms);
+
+    /**
+     * @brief position at the frame holding the first point of a revolution \n
+     * If the revolution is not in the capture, the next one present is used.
+     * @param revolution  revolution number since the capture started
+     * @return false if the capture ends before the revolution
+     */
+    bool seekRevolution(uint32_t revolution);
+
+    /**
+     * @brief copy the frames received in [begin_ns, end_ns) into a new capture \n
+     * Records are copied as they are, the index of the window is taken over.
+     * The read position is not changed.
+     * @param path      file path, an existing file is overwritten
+     * @param begin_ns  first receive time, realtime clock(ns)
+     * @param end_ns    receive time after the window, realtime clock(ns)
+     * @return false if the window is empty or the file cannot be written
+     */
+    bool extract(const char *path, uint64_t begin_ns, uint64_t end_ns);
+
+    /**
+     * @brief whether the capture was closed properly and its index was used as is
+     */
+    bool hasIndex() const {
+        return m_indexed;
+    }
+
+private:
+    MappedFile m_file;
+    const uint8_t *m_data;                  ///< mapped file
+    size_t m_size;                          ///< mapped size
+    size_t m_end;                           ///< end of the record area
+    size_t m_pos;                           ///< offset of the next record
+    const capture_index_entry *m_index;     ///< sparse index, NULL if the capture is empty
+    uint32_t m_indexCount;
+    bool m_indexed;                         ///< the index is the one of the file
+    CaptureIndexer m_indexer;               ///< rebuilt index
+};
+
+}//namespace lidar
+
+#endif // CAPTURE_READER_H
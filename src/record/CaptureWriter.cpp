@@ -0,0 +1,174 @@
+#include "CaptureWriter.h"
+#include <core/serial/common.h>
+#include <core/common/lidar_help.h>
+#include <string.h>
+
+namespace lidar {
+
+CaptureWriter::CaptureWriter()
+    : m_file(NULL)
+    , m_running(false)
+    , m_current(NULL)
+    , m_chunks(0)
+    , m_offset(0)
+    , m_records(0)
+    , m_dropped(0) {
+}
+
+
+CaptureWriter::~CaptureWriter() {
+    close();
+}
+
+
+bool CaptureWriter::open(const char *path) {
+    close();
+    m_file = fopen(path, "wb");
+    if (!m_file) {
+        LOGE("Failed to create capture file %s", path);
+        return false;
+    }
+    m_path = path;
+
+    capture_file_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CAPTURE_FILE_MAGIC, sizeof(header.magic));
+    header.version = CAPTURE_VERSION;
+    header.header_size = sizeof(header);
+    header.index_interval = CAPTURE_INDEX_INTERVAL;
+    header.start_ns = getTime();
+    if (fwrite(&header, sizeof(header), 1, m_file) != 1) {
+        fclose(m_file);
+        m_file = NULL;
+        return false;
+    }
+
+    m_offset = sizeof(header);
+    m_indexer.reset();
+    m_records = 0;
+    m_dropped = 0;
+    m_running = true;
+    m_event.set(false);
+    thread_attr attr("lidar-capture");
+    m_thread = CLASS_THREAD_ATTR(CaptureWriter, writeLoop, attr);
+    if (m_thread.getHandle() == 0) {
+        m_running = false;
+        fclose(m_file);
+        m_file = NULL;
+        return false;
+    }
+    LOGD("Recording to %s", path);
+    return true;
+}
+
+
+void CaptureWriter::close() {
+    if (!m_file) {
+        return;
+    }
+    m_running = false;
+    m_event.set();
+    m_thread.join();
+    flush(true);
+
+    capture_file_footer footer;
+    memset(&footer, 0, sizeof(footer));
+    footer.index_offset = m_offset;
+    footer.index_count = m_indexer.index().size();
+    memcpy(footer.magic, CAPTURE_INDEX_MAGIC, sizeof(footer.magic));
+    if (!m_indexer.index().empty()) {
+        fwrite(&m_indexer.index()[0], sizeof(capture_index_entry), m_indexer.index().size(), m_file);
+    }
+    fwrite(&footer, sizeof(footer), 1, m_file);
+    fclose(m_file);
+    m_file = NULL;
+
+    for (size_t i = 0; i < m_free.size(); i++) {
+        delete m_free[i];
+    }
+    m_free.clear();
+    m_chunks = 0;
+    LOGD("Capture %s closed, %llu records, %llu dropped", m_path.c_str(),
+         (unsigned long long)m_records, (unsigned long long)m_dropped);
+}
+
+
+bool CaptureWriter::write(uint64_t recv_ns, uint32_t src_addr, uint16_t src_port,
+                          const void *payload, uint16_t length) {
+    static const uint8_t padding[CAPTURE_ALIGN] = {0};
+    uint64_t size = capture_record_size(length);
+    ScopedLocker lock(m_Lock);
+    if (!m_running) {
+        return false;
+    }
+
+    if (!m_current || m_current->size() + size > CHUNK_SIZE) {
+        if (m_current) {
+            m_pending.push_back(m_current);
+            m_current = NULL;
+            m_event.set();
+        }
+        if (!m_free.empty()) {
+            m_current = m_free.back();
+            m_free.pop_back();
+        } else if (m_chunks < MAX_CHUNKS) {
+            m_current = new Chunk();
+            m_current->reserve(CHUNK_SIZE);
+            m_chunks++;
+        } else {
+            m_dropped++;
+            return false;
+        }
+    }
+
+    m_indexer.add(recv_ns, src_addr, reinterpret_cast<const uint8_t *>(payload), length, m_offset);
+    capture_record_header header = {recv_ns, src_addr, src_port, length};
+    const uint8_t *p = reinterpret_cast<const uint8_t *>(&header);
+    m_current->insert(m_current->end(), p, p + sizeof(header));
+    p = reinterpret_cast<const uint8_t *>(payload);
+    m_current->insert(m_current->end(), p, p + length);
+    m_current->insert(m_current->end(), padding, padding + (size - sizeof(header) - length));
+    m_offset += size;
+    m_records++;
+    return true;
+}
+
+
+bool CaptureWriter::flush(bool all) {
+    std::vector<Chunk *> chunks;
+    {
+        ScopedLocker lock(m_Lock);
+        chunks.swap(m_pending);
+        if (all && m_current) {
+            chunks.push_back(m_current);
+            m_current = NULL;
+        }
+    }
+    bool ok = true;
+    for (size_t i = 0; i < chunks.size(); i++) {
+        if (!chunks[i]->empty() && fwrite(&(*chunks[i])[0], chunks[i]->size(), 1, m_file) != 1) {
+            ok = false;
+        }
+        chunks[i]->clear();
+    }
+    if (!chunks.empty()) {
+        fflush(m_file);
+        ScopedLocker lock(m_Lock);
+        m_free.insert(m_free.end(), chunks.begin(), chunks.end());
+    }
+    return ok;
+}
+
+
+int CaptureWriter::writeLoop() {
+    while (m_running) {
+        //a partial chunk reaches the disk after FLUSH_INTERVAL at the latest
+        bool timeout = m_event.wait(FLUSH_INTERVAL) == Event::EVENT_TIMEOUT;
+        if (!flush(timeout)) {
+            LOGE("Failed to write capture file %s", m_path.c_str());
+        }
+    }
+    return 0;
+}
+
+}//namespace lidar
@@ -0,0 +1,102 @@
+#ifndef CAPTURE_WRITER_H
+#define CAPTURE_WRITER_H
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <core/base/thread.h>
+#include <core/base/locker.h>
+#include "CaptureIndexer.h"
+
+namespace lidar {
+
+using namespace core::base;
+
+/**
+ * @brief Appends received datagrams to a capture file \n
+ * ::write only copies the datagram into a memory chunk, full chunks are
+ * written to disk by a background thread. When the disk cannot keep up
+ * datagrams are dropped and counted instead of blocking the receiver.
+ */
+class CaptureWriter {
+public:
+    enum {
+        CHUNK_SIZE = 256 * 1024,    /**< Size of one memory chunk. */
+        MAX_CHUNKS = 16,            /**< Chunks in flight before dropping. */
+        FLUSH_INTERVAL = 200,       /**< Partial chunks are written after(ms). */
+    };
+
+    CaptureWriter();
+    ~CaptureWriter();
+
+    /**
+     * @brief create the capture file and start the writer thread
+     * @param path  file path, an existing file is overwritten
+     * @return true if the file is open
+     */
+    bool open(const char *path);
+
+    /**
+     * @brief write pending chunks, the index and the footer, then close the file
+     */
+    void close();
+
+    /**
+     * @brief whether a capture file is open
+     */
+    bool isOpen() const {
+        return m_file != NULL;
+    }
+
+    /**
+     * @brief append a datagram
+     * @param recv_ns   receive time, realtime clock(ns)
+     * @param src_addr  source IPv4 address, network byte order
+     * @param src_port  source port, host byte order
+     * @param payload   datagram
+     * @param length    datagram length
+     * @return false if the datagram was dropped
+     */
+    bool write(uint64_t recv_ns, uint32_t src_addr, uint16_t src_port,
+               const void *payload, uint16_t length);
+
+    /**
+     * @brief recorded datagram count
+     */
+    uint64_t records() const {
+        return m_records;
+    }
+
+    /**
+     * @brief dropped datagram count
+     */
+    uint64_t dropped() const {
+        return m_dropped;
+    }
+
+private:
+    typedef std::vector<uint8_t> Chunk;
+
+    int writeLoop();
+    bool flush(bool all);
+
+private:
+    FILE *m_file;
+    std::string m_path;
+    Thread m_thread;
+    Event m_event;
+    std::atomic<bool> m_running;
+    Locker m_Lock;                              ///< chunks and index
+    Chunk *m_current;                           ///< chunk being filled
+    std::vector<Chunk *> m_pending;             ///< full chunks, oldest first
+    std::vector<Chunk *> m_free;                ///< recycled chunks
+    size_t m_chunks;                            ///< allocated chunks
+    uint64_t m_offset;                          ///< file offset of the next record
+    CaptureIndexer m_indexer;
+    std::atomic<uint64_t> m_records;
+    std::atomic<uint64_t> m_dropped;
+};
+
+}//namespace lidar
+
+#endif // CAPTURE_WRITER_H
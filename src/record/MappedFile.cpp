@@ -0,0 +1,96 @@
+#include "MappedFile.h"
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace lidar {
+
+MappedFile::MappedFile()
+    : m_data(NULL)
+    , m_size(0)
+#if defined(_WIN32)
+    , m_file(NULL)
+    , m_mapping(NULL)
+#endif
+{
+}
+
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+
+bool MappedFile::open(const char *path) {
+    close();
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                              OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!mapping) {
+        CloseHandle(file);
+        return false;
+    }
+    m_data = reinterpret_cast<const uint8_t *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!m_data) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    m_file = file;
+    m_mapping = mapping;
+    m_size = size.QuadPart;
+#else
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+    void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+    madvise(data, st.st_size, MADV_SEQUENTIAL);
+    m_data = reinterpret_cast<const uint8_t *>(data);
+    m_size = st.st_size;
+#endif
+    return true;
+}
+
+
+void MappedFile::close() {
+    if (!m_data) {
+        return;
+    }
+#if defined(_WIN32)
+    UnmapViewOfFile(m_data);
+    CloseHandle(reinterpret_cast<HANDLE>(m_mapping));
+    CloseHandle(reinterpret_cast<HANDLE>(m_file));
+    m_file = NULL;
+    m_mapping = NULL;
+#else
+    munmap(const_cast<uint8_t *>(m_data), m_size);
+#endif
+    m_data = NULL;
+    m_size = 0;
+}
+
+}//namespace lidar
@@ -0,0 +1,51 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+#include <stddef.h>
+#include <core/base/v8stdint.h>
+
+namespace lidar {
+
+/**
+ * @brief Read-only memory mapping of a whole file
+ */
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+
+    /**
+     * @brief map a file
+     * @param path  file path
+     * @return false if the file cannot be opened or is empty
+     */
+    bool open(const char *path);
+
+    /**
+     * @brief unmap the file, pointers into it become invalid
+     */
+    void close();
+
+    bool isOpen() const {
+        return m_data != NULL;
+    }
+
+    const uint8_t *data() const {
+        return m_data;
+    }
+
+    size_t size() const {
+        return m_size;
+    }
+
+private:
+    const uint8_t *m_data;
+    size_t m_size;
+#if defined(_WIN32)
+    void *m_file;
+    void *m_mapping;
+#endif
+};
+
+}//namespace lidar
+
+#endif // MAPPED_FILE_H
@@ -0,0 +1,233 @@
+#include "ScanArchiveReader.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+namespace lidar {
+
+/// key of an index entry or a block header, key is a ScanArchiveReader::SeekKey
+template<typename T>
+static inline uint64_t seek_key(const T &v, int key) {
+    return key == 0 ? v.host_ns : (key == 1 ? v.device_ms : v.revolution);
+}
+
+/// index entry of a block, the offset is relative to base
+static archive_index_entry index_entry(const archive_block &block, uint64_t base) {
+    archive_index_entry entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.host_ns = block.header->host_ns;
+    entry.device_ms = block.header->device_ms;
+    entry.revolution = block.header->revolution;
+    entry.offset = block.offset - base;
+    return entry;
+}
+
+ScanArchiveReader::ScanArchiveReader()
+    : m_data(NULL)
+    , m_size(0)
+    , m_end(0)
+    , m_pos(0)
+    , m_index(NULL)
+    , m_indexCount(0)
+    , m_indexed(false) {
+}
+
+
+ScanArchiveReader::~ScanArchiveReader() {
+    close();
+}
+
+
+bool ScanArchiveReader::open(const char *path) {
+    close();
+    if (!m_file.open(path)) {
+        return false;
+    }
+    m_data = m_file.data();
+    m_size = m_file.size();
+    if (m_size < sizeof(archive_file_header) ||
+        memcmp(header()->magic, ARCHIVE_FILE_MAGIC, 4) != 0 ||
+        header()->version == 0 || header()->version > ARCHIVE_VERSION ||
+        header()->header_size < sizeof(archive_file_header) ||
+        header()->header_size > m_size) {
+        close();
+        return false;
+    }
+
+    //the footer is only present if the writer was closed properly
+    m_end = m_size;
+    if (m_size >= header()->header_size + sizeof(archive_file_footer)) {
+        const archive_file_footer *footer = reinterpret_cast<const archive_file_footer *>(
+            m_data + m_size - sizeof(archive_file_footer));
+        if (memcmp(footer->magic, ARCHIVE_INDEX_MAGIC, 4) == 0 &&
+            footer->index_offset >= header()->header_size &&
+            footer->index_offset + (uint64_t)footer->index_count * sizeof(archive_index_entry) +
+            sizeof(archive_file_footer) == m_size) {
+            m_end = footer->index_offset;
+            m_indexCount = footer->index_count;
+            m_index = m_indexCount ? reinterpret_cast<const archive_index_entry *>(m_data + m_end) : NULL;
+            m_indexed = true;
+        }
+    }
+
+    if (!m_indexed) {
+        //only the block headers are read
+        rewind();
+        archive_block block;
+        for (uint64_t i = 0; next(block); i++) {
+            if (i % ARCHIVE_INDEX_INTERVAL == 0) {
+                m_rebuilt.push_back(index_entry(block, 0));
+            }
+        }
+        m_end = m_pos;
+        m_indexCount = m_rebuilt.size();
+        m_index = m_indexCount ? &m_rebuilt[0] : NULL;
+    }
+    rewind();
+    return true;
+}
+
+
+void ScanArchiveReader::close() {
+    m_file.close();
+    m_data = NULL;
+    m_size = 0;
+    m_end = 0;
+    m_pos = 0;
+    m_index = NULL;
+    m_indexCount = 0;
+    m_indexed = false;
+    m_rebuilt.clear();
+}
+
+
+bool ScanArchiveReader::next(archive_block &block) {
+    if (!m_data || m_pos + sizeof(archive_block_header) > m_end) {
+        return false;
+    }
+    const archive_block_header *header = reinterpret_cast<const archive_block_header *>(m_data + m_pos);
+    if (memcmp(header->magic, ARCHIVE_BLOCK_MAGIC, 4) != 0 ||
+        m_pos + sizeof(archive_block_header) + header->size > m_end) {
+        //truncated by a crash of the writer
+        m_pos = m_end;
+        return false;
+    }
+    block.header = header;
+    block.data = m_data + m_pos + sizeof(archive_block_header);
+    block.offset = m_pos;
+    m_pos += sizeof(archive_block_header) + header->size;
+    return true;
+}
+
+
+bool ScanArchiveReader::decode(const archive_block &block, std::vector<node_info> &nodes) {
+    //every point after the first takes one bit per column at least
+    if (block.header->count > 1 &&
+        block.header->count - 1 > (uint64_t)block.header->size * 8 / ARCHIVE_COLUMNS) {
+        return false;
+    }
+    nodes.resize(block.header->count);
+    if (nodes.empty()) {
+        return true;
+    }
+    return m_decoder.decode(*block.header, block.data, &nodes[0], header()->version);
+}
+
+
+void ScanArchiveReader::rewind() {
+    m_pos = m_data ? header()->header_size : 0;
+}
+
+
+bool ScanArchiveReader::seekBy(SeekKey key, uint64_t target) {
+    rewind();
+    if (!m_data) {
+        return false;
+    }
+    //last index entry before target, at most ARCHIVE_INDEX_INTERVAL block headers follow
+    const archive_index_entry *entry = std::lower_bound(m_index, m_index + m_indexCount, target,
+    [key](const archive_index_entry & e, uint64_t t) {
+        return seek_key(e, key) < t;
+    });
+    if (entry != m_index && entry[-1].offset < m_end) {
+        m_pos = entry[-1].offset;
+    }
+
+    size_t pos = m_pos;
+    archive_block block;
+    while (next(block)) {
+        if (seek_key(*block.header, key) >= target) {
+            m_pos = pos;
+            return true;
+        }
+        pos = m_pos;
+    }
+    return false;
+}
+
+
+bool ScanArchiveReader::seek(uint64_t host_ns) {
+    return seekBy(SeekHost, host_ns);
+}
+
+
+bool ScanArchiveReader::seekDevice(uint64_t device_ms) {
+    return seekBy(SeekDevice, device_ms);
+}
+
+
+bool ScanArchiveReader::seekRevolution(uint32_t revolution) {
+    return seekBy(SeekRevolution, revolution);
+}
+
+
+bool ScanArchiveReader::extract(const char *path, uint64_t begin_ns, uint64_t end_ns) {
+    if (!m_data || begin_ns >= end_ns) {
+        return false;
+    }
+    size_t pos = m_pos;
+    if (!seek(begin_ns)) {
+        m_pos = pos;
+        return false;
+    }
+    size_t begin = m_pos;
+    size_t end = seek(end_ns) ? m_pos : m_end;
+    if (begin >= end) {
+        m_pos = pos;
+        return false;
+    }
+
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        m_pos = pos;
+        return false;
+    }
+    archive_file_header file_header = *header();
+    file_header.header_size = sizeof(file_header);
+    bool ok = fwrite(&file_header, sizeof(file_header), 1, file) == 1 &&
+              fwrite(m_data + begin, end - begin, 1, file) == 1;
+
+    std::vector<archive_index_entry> index;
+    archive_block block;
+    m_pos = begin;
+    for (uint64_t i = 0; m_pos < end && next(block); i++) {
+        if (i % ARCHIVE_INDEX_INTERVAL == 0) {
+            index.push_back(index_entry(block, begin - sizeof(file_header)));
+        }
+    }
+    m_pos = pos;
+
+    archive_file_footer footer;
+    memset(&footer, 0, sizeof(footer));
+    footer.index_offset = sizeof(file_header) + (end - begin);
+    footer.index_count = index.size();
+    memcpy(footer.magic, ARCHIVE_INDEX_MAGIC, sizeof(footer.magic));
+    if (!index.empty()) {
+        ok = ok && fwrite(&index[0], sizeof(archive_index_entry), index.size(), file) == index.size();
+    }
+    ok = ok && fwrite(&footer, sizeof(footer), 1, file) == 1;
+    ok = fclose(file) == 0 && ok;
+    return ok;
+}
+
+}//namespace lidar
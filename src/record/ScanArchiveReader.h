@@ -0,0 +1,138 @@
+#ifndef SCAN_ARCHIVE_READER_H
+#define SCAN_ARCHIVE_READER_H
+#include <stddef.h>
+#include <vector>
+#include "ArchiveCodec.h"
+#include "MappedFile.h"
+
+namespace lidar {
+
+/// one encoded revolution of an archive, pointers into the mapped file
+struct archive_block {
+    const archive_block_header *header;     ///< block header, valid until ::close
+    const uint8_t *data;                    ///< header->size encoded bytes
+    uint64_t offset;                        ///< file offset of the block
+};
+
+/**
+ * @brief Memory-mapped scan archive reader \n
+ * Blocks are returned encoded, ::decode expands one of them into points.
+ * The seeks use the sparse index written by ScanArchiveWriter, the index of
+ * an archive without footer is rebuilt when it is opened.
+ */
+class ScanArchiveReader {
+public:
+    ScanArchiveReader();
+    ~ScanArchiveReader();
+
+    /**
+     * @brief map an archive
+     * @param path  file path
+     * @return true if the file is a valid archive
+     */
+    bool open(const char *path);
+
+    /**
+     * @brief unmap the file, returned blocks become invalid
+     */
+    void close();
+
+    /**
+     * @brief whether an archive is mapped
+     */
+    bool isOpen() const {
+        return m_data != NULL;
+    }
+
+    /**
+     * @brief file header
+     */
+    const archive_file_header *header() const {
+        return reinterpret_cast<const archive_file_header *>(m_data);
+    }
+
+    /**
+     * @brief read the next block
+     * @param block  block, pointers into the mapped file
+     * @return false at the end of the archive
+     */
+    bool next(archive_block &block);
+
+    /**
+     * @brief decode a block
+     * @param block  block returned by ::next
+     * @param nodes  resized to the point count of the block
+     * @return false if the block is corrupt
+     */
+    bool decode(const archive_block &block, std::vector<node_info> &nodes);
+
+    /**
+     * @brief go back to the first block
+     */
+    void rewind();
+
+    /**
+     * @brief position at the first revolution received at or after a time
+     * @param host_ns  receive time, realtime clock(ns)
+     * @return false if no revolution was received at or after host_ns
+     */
+    bool seek(uint64_t host_ns);
+
+    /**
+     * @brief position at the first revolution starting at or after a device time
+     * @param device_ms  device time(ms)
+     * @return false if no revolution starts at or after device_ms
+     */
+    bool seekDevice(uint64_t device_ms);
+
+    /**
+     * @brief position at a revolution, or at the next one present if it was dropped
+     * @param revolution  revolution number since the archive was created
+     * @return false if the archive ends before the revolution
+     */
+    bool seekRevolution(uint32_t revolution);
+
+    /**
+     * @brief copy the revolutions received in [begin_ns, end_ns) into a new archive \n
+     * Blocks are copied without decoding, only their headers are read to
+     * index the new archive. The read position is not changed.
+     * @param path      file path, an existing file is overwritten
+     * @param begin_ns  first receive time, realtime clock(ns)
+     * @param end_ns    receive time after the window, realtime clock(ns)
+     * @return false if the window is empty or the file cannot be written
+     */
+    bool extract(const char *path, uint64_t begin_ns, uint64_t end_ns);
+
+    /**
+     * @brief whether the archive was closed properly and its index was used as is
+     */
+    bool hasIndex() const {
+        return m_indexed;
+    }
+
+private:
+    enum SeekKey {
+        SeekHost,
+        SeekDevice,
+        SeekRevolution,
+    };
+
+    /// position at the first block whose key is not less than target
+    bool seekBy(SeekKey key, uint64_t target);
+
+private:
+    MappedFile m_file;
+    const uint8_t *m_data;                  ///< mapped file
+    size_t m_size;                          ///< mapped size
+    size_t m_end;                           ///< end of the block area
+    size_t m_pos;                           ///< offset of the next block
+    const archive_index_entry *m_index;     ///< sparse index, NULL if the archive is empty
+    uint32_t m_indexCount;
+    bool m_indexed;                         ///< the index is the one of the file
+    std::vector<archive_index_entry> m_rebuilt;
+    ArchiveDecoder m_decoder;
+};
+
+}//namespace lidar
+
+#endif // SCAN_ARCHIVE_READER_H
@@ -0,0 +1,188 @@
+#include "ScanArchiveWriter.h"
+#include <core/serial/common.h>
+#include <core/common/lidar_help.h>
+#include <string.h>
+
+namespace lidar {
+
+ScanArchiveWriter::ScanArchiveWriter()
+    : m_file(NULL)
+    , m_running(false)
+    , m_allocated(0)
+    , m_sequence(0)
+    , m_blocks(0)
+    , m_revolutions(0)
+    , m_dropped(0)
+    , m_bytes(0) {
+}
+
+
+ScanArchiveWriter::~ScanArchiveWriter() {
+    close();
+}
+
+
+bool ScanArchiveWriter::open(const char *path) {
+    close();
+    m_file = fopen(path, "wb");
+    if (!m_file) {
+        LOGE("Failed to create scan archive %s", path);
+        return false;
+    }
+    m_path = path;
+
+    archive_file_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, ARCHIVE_FILE_MAGIC, sizeof(header.magic));
+    header.version = ARCHIVE_VERSION;
+    header.header_size = sizeof(header);
+    header.index_interval = ARCHIVE_INDEX_INTERVAL;
+    header.start_ns = getTime();
+    if (fwrite(&header, sizeof(header), 1, m_file) != 1) {
+        fclose(m_file);
+        m_file = NULL;
+        return false;
+    }
+
+    m_index.clear();
+    m_sequence = 0;
+    m_blocks = 0;
+    m_revolutions = 0;
+    m_dropped = 0;
+    m_bytes = sizeof(header);
+    m_running = true;
+    m_event.set(false);
+    thread_attr attr("lidar-archive");
+    m_thread = CLASS_THREAD_ATTR(ScanArchiveWriter, writeLoop, attr);
+    if (m_thread.getHandle() == 0) {
+        m_running = false;
+        fclose(m_file);
+        m_file = NULL;
+        return false;
+    }
+    LOGD("Archiving scans to %s", path);
+    return true;
+}
+
+
+void ScanArchiveWriter::close() {
+    if (!m_file) {
+        return;
+    }
+    {
+        ScopedLocker lock(m_Lock);
+        m_running = false;
+    }
+    m_event.set();
+    m_thread.join();
+    flush();
+
+    archive_file_footer footer;
+    memset(&footer, 0, sizeof(footer));
+    footer.index_offset = m_bytes;
+    footer.index_count = m_index.size();
+    memcpy(footer.magic, ARCHIVE_INDEX_MAGIC, sizeof(footer.magic));
+    if (!m_index.empty()) {
+        fwrite(&m_index[0], sizeof(archive_index_entry), m_index.size(), m_file);
+    }
+    fwrite(&footer, sizeof(footer), 1, m_file);
+    m_bytes += m_index.size() * sizeof(archive_index_entry) + sizeof(footer);
+    fclose(m_file);
+    m_file = NULL;
+
+    for (size_t i = 0; i < m_free.size(); i++) {
+        delete m_free[i];
+    }
+    m_free.clear();
+    m_allocated = 0;
+    std::vector<uint8_t>().swap(m_buffer);
+    LOGD("Scan archive %s closed, %llu revolutions, %llu dropped, %llu bytes", m_path.c_str(),
+         (unsigned long long)m_revolutions, (unsigned long long)m_dropped,
+         (unsigned long long)m_bytes);
+}
+
+
+bool ScanArchiveWriter::write(const node_info *nodes, size_t count, uint64_t host_ns) {
+    ScopedLocker lock(m_Lock);
+    if (!m_running) {
+        return false;
+    }
+    //the number is consumed by a dropped revolution too, the gap shows the loss
+    uint32_t revolution = m_sequence++;
+
+    Revolution *rev = NULL;
+    if (!m_free.empty()) {
+        rev = m_free.back();
+        m_free.pop_back();
+    } else if (m_allocated < MAX_PENDING) {
+        rev = new Revolution();
+        m_allocated++;
+    } else {
+        m_dropped++;
+        return false;
+    }
+    rev->host_ns = host_ns;
+    rev->revolution = revolution;
+    rev->nodes.assign(nodes, nodes + count);
+    m_pending.push_back(rev);
+    m_event.set();
+    return true;
+}
+
+
+bool ScanArchiveWriter::flush() {
+    std::vector<Revolution *> revolutions;
+    {
+        ScopedLocker lock(m_Lock);
+        revolutions.swap(m_pending);
+    }
+    if (revolutions.empty()) {
+        return true;
+    }
+
+    m_buffer.clear();
+    for (size_t i = 0; i < revolutions.size(); i++) {
+        const Revolution *rev = revolutions[i];
+        size_t at = m_buffer.size();
+        archive_block_header header;
+        m_buffer.resize(at + sizeof(header));
+        m_encoder.encode(rev->nodes.empty() ? NULL : &rev->nodes[0], rev->nodes.size(),
+                         rev->host_ns, rev->revolution, header, m_buffer);
+        memcpy(&m_buffer[at], &header, sizeof(header));
+
+        if (m_blocks % ARCHIVE_INDEX_INTERVAL == 0) {
+            archive_index_entry entry;
+            memset(&entry, 0, sizeof(entry));
+            entry.host_ns = header.host_ns;
+            entry.device_ms = header.device_ms;
+            entry.revolution = header.revolution;
+            entry.offset = m_bytes + at;
+            m_index.push_back(entry);
+        }
+        m_blocks++;
+    }
+
+    bool ok = fwrite(&m_buffer[0], m_buffer.size(), 1, m_file) == 1;
+    m_bytes += m_buffer.size();
+    m_revolutions += revolutions.size();
+    ScopedLocker lock(m_Lock);
+    m_free.insert(m_free.end(), revolutions.begin(), revolutions.end());
+    return ok;
+}
+
+
+int ScanArchiveWriter::writeLoop() {
+    uint32_t flushed = getms();
+    while (m_running) {
+        if (m_event.wait(FLUSH_INTERVAL) != Event::EVENT_TIMEOUT && !flush()) {
+            LOGE("Failed to write scan archive %s", m_path.c_str());
+        }
+        if (getms() - flushed >= FLUSH_INTERVAL) {
+            fflush(m_file);
+            flushed = getms();
+        }
+    }
+    return 0;
+}
+
+}//namespace lidar
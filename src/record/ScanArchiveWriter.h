@@ -0,0 +1,112 @@
+#ifndef SCAN_ARCHIVE_WRITER_H
+#define SCAN_ARCHIVE_WRITER_H
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <core/base/thread.h>
+#include <core/base/locker.h>
+#include "ArchiveCodec.h"
+
+namespace lidar {
+
+using namespace core::base;
+
+/**
+ * @brief Appends decoded revolutions to a compressed scan archive \n
+ * ::write only copies the points, encoding and disk writes are done by a
+ * background thread. When it cannot keep up revolutions are dropped and
+ * counted instead of blocking the caller.
+ */
+class ScanArchiveWriter {
+public:
+    enum {
+        MAX_PENDING = 32,           /**< Revolutions in flight before dropping. */
+        FLUSH_INTERVAL = 1000,      /**< Encoded blocks reach the disk after(ms). */
+    };
+
+    ScanArchiveWriter();
+    ~ScanArchiveWriter();
+
+    /**
+     * @brief create the archive and start the writer thread
+     * @param path  file path, an existing file is overwritten
+     * @return true if the file is open
+     */
+    bool open(const char *path);
+
+    /**
+     * @brief write pending revolutions, the index and the footer, then close the file
+     */
+    void close();
+
+    /**
+     * @brief whether an archive is open
+     */
+    bool isOpen() const {
+        return m_file != NULL;
+    }
+
+    /**
+     * @brief append a revolution
+     * @param nodes    points
+     * @param count    point count
+     * @param host_ns  receive time, realtime clock(ns)
+     * @return false if the revolution was dropped
+     */
+    bool write(const node_info *nodes, size_t count, uint64_t host_ns);
+
+    /**
+     * @brief archived revolution count
+     */
+    uint64_t revolutions() const {
+        return m_revolutions;
+    }
+
+    /**
+     * @brief dropped revolution count
+     */
+    uint64_t dropped() const {
+        return m_dropped;
+    }
+
+    /**
+     * @brief bytes written so far
+     */
+    uint64_t bytes() const {
+        return m_bytes;
+    }
+
+private:
+    struct Revolution {
+        uint64_t host_ns;
+        uint32_t revolution;
+        std::vector<node_info> nodes;
+    };
+
+    int writeLoop();
+    bool flush();
+
+private:
+    FILE *m_file;
+    std::string m_path;
+    Thread m_thread;
+    Event m_event;
+    std::atomic<bool> m_running;
+    Locker m_Lock;                              ///< revolution queues
+    std::vector<Revolution *> m_pending;        ///< copied revolutions, oldest first
+    std::vector<Revolution *> m_free;           ///< recycled revolutions
+    size_t m_allocated;                         ///< allocated revolutions
+    uint32_t m_sequence;                        ///< number of the next revolution
+    ArchiveEncoder m_encoder;                   ///< writer thread only
+    std::vector<uint8_t> m_buffer;              ///< encoded blocks of one flush
+    std::vector<archive_index_entry> m_index;
+    uint64_t m_blocks;                          ///< blocks encoded
+    std::atomic<uint64_t> m_revolutions;
+    std::atomic<uint64_t> m_dropped;
+    std::atomic<uint64_t> m_bytes;
+};
+
+}//namespace lidar
+
+#endif // SCAN_ARCHIVE_WRITER_H